@@ -2,13 +2,13 @@
 
 #include <ppftk/rom_patch/patch_file_exts.h>
 #include <ppftk/rom_patch/cd/spec.h>
+#include <ppftk/rom_patch/cd/verify.h>
 
 #include <ppfbase/branding.h>
 #include <ppfbase/logging/logging.h>
 #include <ppfbase/process/this_process.h>
-#include <ppfbase/stdext/iostream.h>
 
-#include <fstream>
+#include <iostream>
 
 #include <Windows.h>
 
@@ -32,146 +32,33 @@ namespace {
       // Leave injector loaded until process exits.
    }
 
-   [[nodiscard]] size_t GetFileSize(
-      std::istream& target,
-      std::istream& verification)
+   [[nodiscard]] tk::rompatch::cd::VerifyLevel Level(
+      const bool checkEdc,
+      const bool checkEcc) noexcept
    {
-      target.seekg(0, std::ios::end);
-      const size_t targetSize = target.tellg();
+      using tk::rompatch::cd::VerifyLevel;
 
-      verification.seekg(0, std::ios::end);
-      if (targetSize != verification.tellg()) {
-         throw std::runtime_error(
-            "Original and verification have different sizes");
-      }
-
-      target.seekg(0, std::ios::beg);
-      verification.seekg(0, std::ios::beg);
-      return targetSize;
-   }
-
-   // Expects the 'target' and 'verification' to be identical. No special
-   // treatment given to these files.
-   void SimpleVerification(std::istream& target, std::istream& verification)
-   {
-      // 8KB verification chunk size.
-      static constexpr size_t kChunkSize = 8 * 1024;
-
-      size_t left = GetFileSize(target, verification);
-
-      std::vector<char> patched(kChunkSize);
-      std::vector<char> expected(kChunkSize);
-      size_t read = 0;
-
-      while (left > 0) {
-         if (left < kChunkSize) {
-            patched.resize(left);
-            expected.resize(left);
-         }
-
-         stdext::Read(target, patched);
-         stdext::Read(verification, expected);
-
-         if (patched != expected) {
-            for (size_t i = 0; i < patched.size(); ++i) {
-               if (patched[i] != expected[i]) {
-                  throw std::runtime_error(
-                     "Mismatch at file location: " + std::to_string(read + i));
-               }
-            }
-         }
-
-         read += patched.size();
-         left -= patched.size();
+      if (checkEcc) {
+         return VerifyLevel::Ecc;
       }
+      return checkEdc ? VerifyLevel::Edc : VerifyLevel::Data;
    }
 
-   void CheckSector(
-      const cd::Sector& target,
-      const cd::Sector& verification,
-      const size_t sectorNumber,
-      const bool checkEdc)
+   // Verify() only logs these.
+   void CheckSizes(
+      const fs::path& target,
+      const fs::path& verification,
+      const bool wholeSectors)
    {
-      size_t blockSize = 0;
-      uint8_t mode = 0;
-      uint8_t form = 0;
-
-      bool failForm2Edc = false;
-
-      switch (target.header.parts.mode) {
-      default:
-         std::cout << "Unknown sector mode for sector " << sectorNumber << ": "
-            << target.header.parts.mode << ". Assume Mode 0."
-            << std::endl;
-      case cd::kMode0:
-         blockSize = cd::kSectorSize;
-         mode = cd::kMode0;
-         break;
-      case cd::kMode1:
-         mode = cd::kMode1;
-         blockSize =
-            cd::kSectorSize - cd::kEccSize - (checkEdc ? 0 : cd::kEdcSize);
-         break;
-      case cd::kMode2:
-         mode = 2;
-         if (target.xa.subheader[0].full != target.xa.subheader[1].full) {
-            std::cout << "Non-XA Mode 2 sector: " << sectorNumber << std::endl;
-            blockSize = cd::kSectorSize;
-         }
-         else if (target.xa.subheader[0].parts.submode.form == cd::kXaForm1) {
-            form = 1;
-            blockSize =
-               cd::kSectorSize - cd::kEccSize - (checkEdc ? 0 : cd::kEdcSize);
-         }
-         else {
-            form = 2;
-            blockSize = cd::kSectorSize - cd::kEdcSize;
-            const auto tEdc = target.xa.form2.edc.full;
-            const auto vEdc = verification.xa.form2.edc.full;
-            failForm2Edc = tEdc != 0 && tEdc != vEdc;
-         }
-         break;
-      }
-
-      if (0 != memcmp(&target, &verification, blockSize)) {
-         throw std::runtime_error(
-            "Sector " + std::to_string(sectorNumber) + " data mismatch");
-      }
-
-      if (failForm2Edc) {
+      const auto targetSize = fs::file_size(target);
+      if (targetSize != fs::file_size(verification)) {
          throw std::runtime_error(
-            "Form 2 Sector " + std::to_string(sectorNumber) + " EDC mismatch");
+            "Original and verification have different sizes");
       }
-   }
-
-   // Don't need to check ECC here. If ECC check were requested,
-   // SimpleVerification would have been called instead.
-   void CdVerification(
-      std::istream& target,
-      std::istream& verification,
-      const bool checkEdc)
-   {
-      // The assumption of CD image is that it starts immediately with sector
-      // data. The first 12 bytes would be the sync data.
 
-      const auto fileSize = GetFileSize(target, verification);
-      if (fileSize % cd::kSectorSize != 0) {
+      if (wholeSectors && targetSize % cd::kSectorSize != 0) {
          throw std::runtime_error("Incomplete sector in test files");
       }
-
-      const auto sectorCount = fileSize / cd::kSectorSize;
-      std::cout << "Sector count: " << sectorCount << std::endl;
-      std::cout << "EDC verification: " << std::boolalpha << checkEdc
-                << std::endl;
-
-      for (size_t i = 0; i < sectorCount; ++i) {
-         cd::Sector tSec{0};
-         cd::Sector vSec{0};
-
-         stdext::Read(target, tSec);
-         stdext::Read(verification, vSec);
-         CheckSector(tSec, vSec, i, checkEdc);
-      }
    }
 }
 
@@ -185,8 +72,9 @@ LivePatch::LivePatch(CLI::App& test)
    , m_verification()
    , m_checkEdc(false)
    , m_checkEcc(false)
+   , m_threads(0)
 {
-   m_cmd->require_option(2, 4);
+   m_cmd->require_option(2, 5);
 
    m_cmd->add_option(
       "--original",
@@ -209,6 +97,11 @@ LivePatch::LivePatch(CLI::App& test)
       "--check_ecc",
       m_checkEcc,
       "Check ECC differences in CD images. Implies --check_edc");
+
+   m_cmd->add_option(
+      "--threads",
+      m_threads,
+      "Number of threads comparing the files. Defaults to one per core.");
 }
 
 bool LivePatch::Execute()
@@ -263,14 +156,34 @@ void LivePatch::DoTest() const
 {
    LoadInjector();
 
-   std::ifstream target(m_original, std::ios::binary);
-   std::ifstream verification(m_verification, std::ios::binary);
+   tk::rompatch::cd::VerifyOptions options;
+   options.level = Level(m_checkEdc, m_checkEcc);
+   options.workers = m_threads;
 
-   if (m_checkEcc) {
-      SimpleVerification(target, verification);
+   CheckSizes(
+      m_original,
+      m_verification,
+      options.level != tk::rompatch::cd::VerifyLevel::Ecc);
+
+   const auto report =
+      tk::rompatch::cd::Verify(m_original, m_verification, options);
+   if (!report) {
+      throw std::runtime_error("Unable to compare the test files");
    }
-   else {
-      CdVerification(target, verification, m_checkEdc);
+
+   std::cout << "Sector count: " << report->sectors << std::endl;
+   std::cout << "EDC verification: " << std::boolalpha << m_checkEdc
+             << std::endl;
+
+   for (const auto& mismatch : report->mismatches) {
+      std::cout << "Sector " << mismatch.sector << " ("
+                << ToString(mismatch.layout) << ") mismatch at offset "
+                << mismatch.offset << std::endl;
+   }
+
+   if (!report->mismatches.empty()) {
+      throw std::runtime_error(
+         std::to_string(report->mismatches.size()) + " sectors mismatch");
    }
 
    std::cout << "File data identical. Live patching is working." << std::endl;
@@ -23,6 +23,7 @@ namespace tdd::app::emulauncher::cmd::test {
       std::filesystem::path m_verification;
       bool m_checkEdc;
       bool m_checkEcc;
+      size_t m_threads;
    };
 
 }
\ No newline at end of file
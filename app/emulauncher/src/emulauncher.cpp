@@ -20,6 +20,8 @@ int main(int argc, char** argv)
 
    tdd::base::logging::SetMinLogLevel(
       tdd::tk::config::App::LogLevel());
+   tdd::base::logging::SetArchivePolicy(
+      tdd::tk::config::App::LogArchivePolicy());
 
    if (argc > 1) {
       return tdd::app::emulauncher::cmd::HandleCmdLine(argc, argv);
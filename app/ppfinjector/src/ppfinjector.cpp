@@ -1,24 +1,27 @@
 #include "hook_status.h"
 
 #include <ppftk/config/app.h>
-#include <ppftk/config/patch.h>
-#include <ppftk/rom_patch/patch_file_exts.h>
-#include <ppftk/rom_patch/patchers.h>
-#include <ppftk/rom_patch/ppf/parser.h>
+#include <ppftk/rom_patch/async_patcher.h>
+#include <ppftk/rom_patch/extra_reads.h>
+#include <ppftk/rom_patch/patch_loader.h>
+#include <ppftk/rom_patch/patch_sessions.h>
+#include <ppftk/rom_patch/pending_reads.h>
+#include <ppftk/rom_patch/read_trace.h>
 
 #include <ppfbase/branding.h>
 #include <ppfbase/logging/logging.h>
 #include <ppfbase/filesystem/file.h>
 #include <ppfbase/filesystem/path_service.h>
 #include <ppfbase/process/this_module.h>
-#include <ppfbase/stdext/scope_exit.h>
 #include <ppfbase/stdext/string.h>
 #include <ppfbase/stdext/system_error.h>
 
+#include <algorithm>
 #include <atomic>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 #include <Windows.h>
@@ -30,14 +33,29 @@ namespace {
 
    namespace fs = std::filesystem;
    namespace AppConfig = tk::config::App;
+   using TraceClock = tk::rompatch::ReadTrace::Clock;
 
    auto g_origCreateFileW = CreateFileW;
    auto g_origReadFile = ReadFile;
    auto g_origReadFileEx = ReadFileEx;
    auto g_origCloseHandle = CloseHandle;
-
-   std::unique_ptr<tk::rompatch::IPatcher> g_patch;
-   std::atomic<HANDLE> g_targetFile = INVALID_HANDLE_VALUE;
+   auto g_origDuplicateHandle = DuplicateHandle;
+   auto g_origGetOverlappedResult = GetOverlappedResult;
+   auto g_origGetOverlappedResultEx = GetOverlappedResultEx;
+   auto g_origGetQueuedCompletionStatus = GetQueuedCompletionStatus;
+   auto g_origGetQueuedCompletionStatusEx = GetQueuedCompletionStatusEx;
+
+   // Set with the first patch session if the config turns the read trace on.
+   // Never freed, the hooks run until the process is gone.
+   std::atomic<tk::rompatch::ReadTrace*> g_trace = nullptr;
+
+   // Taken before a read of a target is issued. Only needed for the trace.
+   [[nodiscard]] TraceClock::time_point ReadStart() noexcept
+   {
+      return nullptr != g_trace.load(std::memory_order_relaxed)
+         ? TraceClock::now()
+         : TraceClock::time_point();
+   }
 
    struct [[nodiscard]] LastErrorRestorer
    {
@@ -56,29 +74,124 @@ namespace {
       TDD_DISABLE_COPY_MOVE(LastErrorRestorer);
    };
 
-   [[nodiscard]] bool IsTargetable(const fs::path& file)
+   // 'file' needs to be canonical.
+   [[nodiscard]] bool IsWindowsFile(const fs::path& file)
    {
       static const fs::path kWindows(L"C:\\Windows\\");
 
-      const auto targetExt = stdext::WideToUtf8(file.extension().wstring());
+      const auto [winEnd, nothing] =
+         std::mismatch(kWindows.begin(), kWindows.end(), file.begin());
+      return kWindows.end() == winEnd;
+   }
+
+   // Runs on the AsyncPatcher's loader thread.
+   [[nodiscard]] std::unique_ptr<tk::rompatch::IPatcher> LoadTarget(
+      const fs::path& file,
+      const tk::rompatch::AsyncPatcher::Announce& announce)
+   {
+      // The loader opens the PPF and the image itself.
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
 
-      if (AppConfig::TargetExts().count(targetExt) == 0) {
-         return false;
+      std::error_code ec;
+      const auto target = fs::canonical(file, ec);
+      if (ec) {
+         TDD_LOG_DEBUG() << "Target [" << file.wstring()
+                         << "] can't be canonicalized: " << ec.message();
+         return nullptr;
       }
 
-      const auto [winEnd, nothing] =
-         std::mismatch(kWindows.begin(), kWindows.end(), file.begin());
-      return kWindows.end() != winEnd;
+      if (IsWindowsFile(target)) {
+         return nullptr;
+      }
+
+      return tk::rompatch::LoadPatcher(target, announce);
+   }
+
+   // Everything that belongs to one opened image. Shared by all handles the
+   // emulator has open on it.
+   struct [[nodiscard]] Session
+   {
+      Session(const fs::path& file, const HANDLE hFile)
+         : patcher(std::make_unique<tk::rompatch::AsyncPatcher>(
+            [file](const tk::rompatch::AsyncPatcher::Announce& announce) {
+               return LoadTarget(file, announce);
+            }))
+         , extraReadFile(base::fs::File::ReopenForReadAt(hFile))
+      {}
+
+      ~Session()
+      {
+         if (INVALID_HANDLE_VALUE != extraReadFile) {
+            g_origCloseHandle(extraReadFile);
+         }
+      }
+
+      TDD_DISABLE_COPY_MOVE(Session);
+
+      const std::unique_ptr<tk::rompatch::AsyncPatcher> patcher;
+      // Private handle to the image for the extra reads. Its file pointer is
+      // not the emulator's.
+      const HANDLE extraReadFile;
+   };
+
+   using SessionPtr = std::shared_ptr<Session>;
+
+   tk::rompatch::PatchSessions<HANDLE, Session> g_sessions;
+
+   struct [[nodiscard]] OverlappedRead
+   {
+      SessionPtr session;
+      HANDLE file;
+      TraceClock::time_point start;
+   };
+
+   struct [[nodiscard]] ApcRead
+   {
+      SessionPtr session;
+      HANDLE file;
+      TraceClock::time_point start;
+      LPOVERLAPPED_COMPLETION_ROUTINE completion;
+   };
+
+   // Overlapped reads of a target, keyed by their OVERLAPPED. They are
+   // patched wherever the emulator learns about the completion: a wait on the
+   // OVERLAPPED or its IO completion port. Closing the handle drops its
+   // reads, so those that completed unseen don't pile up and keep their
+   // session alive. A completion dequeued after the close is left unpatched.
+   tk::rompatch::PendingReads<OverlappedRead> g_overlappedReads;
+   // ReadFileEx reads. They are patched in the wrapped completion routine.
+   tk::rompatch::PendingReads<ApcRead> g_apcReads;
+
+   [[nodiscard]] bool IsCurrentProcess(const HANDLE hProcess) noexcept
+   {
+      return ::GetCurrentProcess() == hProcess
+          || ::GetProcessId(hProcess) == ::GetCurrentProcessId();
+   }
+
+   // Where a read through 'hFile' starts. An OVERLAPPED structure carries
+   // the offset, so the file pointer is only queried without one.
+   [[nodiscard]] std::optional<base::fs::File::FilePointer> ReadAddress(
+      const HANDLE hFile,
+      const LPOVERLAPPED lpOverlapped) noexcept
+   {
+      if (nullptr == lpOverlapped) {
+         return base::fs::File::GetFilePointer(hFile);
+      }
+
+      return base::fs::File::FilePointer(static_cast<int64_t>(
+         (static_cast<uint64_t>(lpOverlapped->OffsetHigh) << 32)
+         | lpOverlapped->Offset));
    }
 
-   void LogReadOp(const HANDLE hFile, DWORD readSize)
+   void LogReadOp(
+      const std::optional<base::fs::File::FilePointer>& filePtr,
+      DWORD readSize)
    {
       if (!TDD_LOG_IS_ON(Verbose_2)) {
          return;
       }
 
       std::stringstream log;
-      const auto filePtr = base::fs::File::GetFilePointer(hFile);
       if (filePtr.has_value()) {
          log << filePtr->get();
       }
@@ -90,33 +203,168 @@ namespace {
       TDD_VLOG2() << log.str();
    }
 
-   void PatchExtraRead(
+   // Patches 'data', read from 'hFile' at 'addr'. Extra reads go through the
+   // private handle. Without one they go through 'hFile', which moves the
+   // file pointer of a synchronous handle. It is put back to 'resumeAt'.
+   // The read was issued at 'start'.
+   void PatchTargetRead(
+      Session& session,
       const HANDLE hFile,
-      const tk::rompatch::IPatcher::AdditionalReads& extraReads)
+      const uint64_t addr,
+      std::span<uint8_t> data,
+      const std::optional<base::fs::File::FilePointer>& resumeAt,
+      const TraceClock::time_point start)
    {
-      std::vector<uint8_t> extraBlock(extraReads.blockSize, 0);
-      for (const auto addr : extraReads.addrs) {
-         const auto err =
-            base::fs::File::Seek(hFile, base::fs::File::FilePointer(addr));
-         TDD_CHECK(!err, "Unable to seek for extra read");
-
-         DWORD bytesRead = 0;
-         g_origReadFile(
-            hFile,
-            extraBlock.data(),
-            static_cast<DWORD>(extraBlock.size()),
-            &bytesRead,
-            nullptr);
+      const auto trace = g_trace.load(std::memory_order_relaxed);
+      const auto read =
+         nullptr != trace ? TraceClock::now() : TraceClock::time_point();
+
+      const auto hReadAt = INVALID_HANDLE_VALUE != session.extraReadFile
+         ? session.extraReadFile
+         : hFile;
+
+      uint32_t extraReads = 0;
+      const auto patched = tk::rompatch::PatchRead(
+         *session.patcher,
+         addr,
+         data,
+         [hReadAt, &extraReads](
+            const uint64_t readAddr,
+            std::span<uint8_t> buffer) {
+            ++extraReads;
+            const auto err = base::fs::File::ReadAt(
+               hReadAt,
+               base::fs::File::FilePointer(static_cast<int64_t>(readAddr)),
+               buffer);
+            return !err;
+         });
+
+      // The patcher asks for the extra reads before it touches 'data'.
+      if (!patched) {
+         TDD_LOG_ERROR() << "Read at [" << addr << "] is left unpatched";
+      }
+
+      if (nullptr != trace) {
+         trace->Add({
+            .offset = addr,
+            .length = data.size(),
+            .patchedBytes = session.patcher->PatchedBytes(addr, data.size()),
+            .extraReads = extraReads,
+            .start = start,
+            .read = read,
+            .patched = TraceClock::now()});
+      }
 
-         TDD_CHECK(
-            extraBlock.size() == bytesRead,
-            "Unable to read requested amount");
+      if (0 == extraReads || hReadAt != hFile || !resumeAt.has_value()) {
+         return;
+      }
 
-         const auto check = g_patch->Patch(addr, extraBlock);
-         TDD_CHECK(!check.has_value(), "Unexpected extra read requests");
+      const auto err = base::fs::File::Seek(hFile, resumeAt.value());
+      if (err) {
+         TDD_LOG_ERROR() << "Unable to restore file pointer: " << err.message();
       }
    }
 
+   // Completion of an asynchronous read of a target, issued at 'start'.
+   void PatchCompletedRead(
+      Session& session,
+      const HANDLE hFile,
+      const uint64_t addr,
+      std::span<uint8_t> buffer,
+      const DWORD bytesTransferred,
+      const TraceClock::time_point start)
+   {
+      TDD_VLOG2() << addr << ":" << bytesTransferred << " completed";
+
+      // An overlapped handle has no file pointer worth restoring.
+      PatchTargetRead(
+         session,
+         hFile,
+         addr,
+         buffer.first(std::min<size_t>(bytesTransferred, buffer.size())),
+         std::nullopt,
+         start);
+   }
+
+   // Called once the emulator has seen 'lpOverlapped' complete. 'hFile' is
+   // the handle it was waited on with, std::nullopt where the completion
+   // doesn't tell, as with a completion port.
+   void CompleteOverlappedRead(
+      const LPOVERLAPPED lpOverlapped,
+      const std::optional<HANDLE> hFile,
+      const bool success,
+      const DWORD bytesTransferred)
+   {
+      if (nullptr == lpOverlapped) {
+         return;
+      }
+
+      auto read = g_overlappedReads.Take(lpOverlapped);
+      if (!read.has_value() || !success) {
+         return;
+      }
+
+      // Left behind by a read that completed unseen, e.g. through a wait on
+      // the event, before the OVERLAPPED was reused for another file.
+      if (hFile.has_value() && hFile.value() != read->context.file) {
+         return;
+      }
+
+      // A completion port doesn't tell the file. An OVERLAPPED reused for a
+      // socket, an ioctl or a posted packet must not be patched into a
+      // buffer the emulator may have freed since.
+      const auto addr = ReadAddress(read->context.file, lpOverlapped).value();
+      if (static_cast<uint64_t>(addr.get()) != read->addr
+       || bytesTransferred > read->buffer.size()) {
+         TDD_LOG_WARN() << "Dropping a stale read at [" << read->addr << "]";
+         return;
+      }
+
+      PatchCompletedRead(
+         *read->context.session,
+         read->context.file,
+         read->addr,
+         read->buffer,
+         bytesTransferred,
+         read->context.start);
+   }
+
+   // A new read through 'lpOverlapped' means the one registered under it
+   // completed without the hooks seeing it, through a wait on its event or
+   // the handle. The OVERLAPPED may now belong to a file that isn't patched.
+   void ForgetOverlappedRead(const LPOVERLAPPED lpOverlapped)
+   {
+      if (nullptr != lpOverlapped) {
+         std::ignore = g_overlappedReads.Take(lpOverlapped);
+      }
+   }
+
+   // Reads that haven't completed yet fail with one of these. They stay
+   // registered.
+   [[nodiscard]] bool IsIncomplete(const DWORD err) noexcept
+   {
+      return ERROR_IO_INCOMPLETE == err || WAIT_TIMEOUT == err
+          || WAIT_IO_COMPLETION == err;
+   }
+
+   // Only processes that open a target get a trace file.
+   void StartReadTrace()
+   {
+      static std::once_flag once;
+      std::call_once(once, [] {
+         const auto records = AppConfig::ReadTraceRecords();
+         const auto path = 0 != records
+            ? tk::rompatch::ReadTrace::DllTracePath()
+            : std::nullopt;
+         if (!path.has_value()) {
+            return;
+         }
+
+         g_trace = tk::rompatch::ReadTrace::Create(path.value(), records)
+            .release();
+      });
+   }
+
    HANDLE WINAPI CreateFileWHook(
       _In_ LPCWSTR lpFileName,
       _In_ DWORD dwDesiredAccess,
@@ -147,51 +395,77 @@ namespace {
       LastErrorRestorer lastErr;
       TDD_PPF_DISABLE_FURTHER_HOOKS();
 
-      std::error_code ec;
-      const auto target = fs::canonical(lpFileName, ec);
-      if (ec) {
-         TDD_LOG_DEBUG() << "Target [" << lpFileName
-                         << "] can't be canonicalized: " << ec.message();
-         return hFile;
-      }
-
       TDD_LOG_DEBUG() << "Opened: " << lpFileName;
-      if (!IsTargetable(target)) {
+
+      // Only cheap checks here. Everything else happens on the loader thread
+      // while the emulator carries on.
+      const fs::path file(lpFileName);
+      if (!tk::rompatch::IsPatchTarget(file)) {
          return hFile;
       }
 
-      tk::config::Patch patchConfig(target);
-
-      if (patchConfig.PatchFile().empty()) {
+      // Sessions are matched by path. GetFullPathNameW() doesn't touch the
+      // disk.
+      std::error_code ec;
+      const auto image = fs::absolute(file, ec).lexically_normal();
+      if (ec) {
+         TDD_LOG_WARN() << "Unable to make [" << file.wstring()
+                        << "] absolute: " << ec.message();
          return hFile;
       }
 
-      TDD_LOG_INFO() << "Target: " << lpFileName;
-      TDD_LOG_INFO() << "Patch: " << patchConfig.PatchFile().wstring();
+      std::ignore = g_sessions.Open(hFile, image, [&file, hFile] {
+         TDD_LOG_INFO() << "New patch session for [" << file.wstring() << "]";
+         StartReadTrace();
+         return std::make_shared<Session>(file, hFile);
+      });
+      TDD_LOG_DEBUG() << g_sessions.Size() << " target handles open";
 
-      if (g_targetFile != INVALID_HANDLE_VALUE) {
-         TDD_LOG_WARN() << "Already opened before. Replacing with new handle.";
-      }
+      return hFile;
+   }
 
-      g_targetFile = hFile;
+   // The read is registered before it is issued. Its completion can be
+   // dequeued on another thread before ReadFile returns.
+   BOOL ReadOverlapped(
+      SessionPtr session,
+      const HANDLE hFile,
+      const LPVOID lpBuffer,
+      const DWORD nNumberOfBytesToRead,
+      const LPDWORD lpNumberOfBytesRead,
+      const LPOVERLAPPED lpOverlapped,
+      const uint64_t targetAddr)
+   {
+      g_overlappedReads.Add(
+         lpOverlapped,
+         {.addr = targetAddr,
+          .buffer = std::span(
+             static_cast<uint8_t*>(lpBuffer),
+             nNumberOfBytesToRead),
+          .context = {
+             .session = std::move(session),
+             .file = hFile,
+             .start = ReadStart()}});
 
-      auto patch = tk::rompatch::ppf::Parse(patchConfig.PatchFile());
-      if (!patch.has_value()) {
-         TDD_LOG_WARN() << "Unable to parse patch";
-         return hFile;
-      }
+      const auto success = g_origReadFile(
+         hFile,
+         lpBuffer,
+         nNumberOfBytesToRead,
+         lpNumberOfBytesRead,
+         lpOverlapped);
 
-      if (patchConfig.CalculateEdc()) {
-         TDD_LOG_INFO() << "EDC calculation required.";
-         g_patch = std::make_unique<tk::rompatch::cd::Patcher>(
-            std::move(patch).value());
-      }
-      else {
-         g_patch = std::make_unique<tk::rompatch::SimplePatcher>(
-            std::move(patch).value());
+      LastErrorRestorer lastErr;
+      if (!success && ERROR_IO_PENDING == lastErr.m_lastErr) {
+         return success;
       }
 
-      return hFile;
+      // Completed right away, or failed. The OVERLAPPED holds the byte count
+      // either way, 'lpNumberOfBytesRead' is optional for overlapped reads.
+      CompleteOverlappedRead(
+         lpOverlapped,
+         hFile,
+         success,
+         static_cast<DWORD>(lpOverlapped->InternalHigh));
+      return success;
    }
 
    BOOL WINAPI ReadFileHook(
@@ -201,11 +475,12 @@ namespace {
       _Out_opt_ LPDWORD lpNumberOfBytesRead,
       _Inout_opt_ LPOVERLAPPED lpOverlapped)
    {
-      const bool skipHook = !HookStatus::ShouldExecute() || hFile == NULL ||
-         hFile == INVALID_HANDLE_VALUE || hFile != g_targetFile ||
-         nullptr == g_patch;
+      const auto session = HookStatus::ShouldExecute()
+         ? g_sessions.Find(hFile)
+         : nullptr;
 
-      if (skipHook) {
+      if (nullptr == session) {
+         ForgetOverlappedRead(lpOverlapped);
          return g_origReadFile(
             hFile,
             lpBuffer,
@@ -216,12 +491,20 @@ namespace {
 
       TDD_PPF_DISABLE_FURTHER_HOOKS();
 
-      LogReadOp(hFile, nNumberOfBytesToRead);
+      const auto targetAddr = ReadAddress(hFile, lpOverlapped);
+      LogReadOp(targetAddr, nNumberOfBytesToRead);
 
       if (nullptr != lpOverlapped) {
-         TDD_LOG_WARN() << "Overlapped IO used to read target";
+         return ReadOverlapped(
+            session,
+            hFile,
+            lpBuffer,
+            nNumberOfBytesToRead,
+            lpNumberOfBytesRead,
+            lpOverlapped,
+            targetAddr.value().get());
       }
-      const auto targetAddr = base::fs::File::GetFilePointer(hFile);
+
       // 2. ReadFile
       DWORD bytesRead = 0;
 
@@ -229,6 +512,7 @@ namespace {
          lpNumberOfBytesRead = &bytesRead;
       }
 
+      const auto start = ReadStart();
       const auto success = g_origReadFile(
          hFile,
          lpBuffer,
@@ -244,42 +528,58 @@ namespace {
          return success;
       }
 
-      const auto extraReads = g_patch->Patch(
+      PatchTargetRead(
+         *session,
+         hFile,
          targetAddr.value().get(),
-         std::span(static_cast<uint8_t*>(lpBuffer), *lpNumberOfBytesRead));
+         std::span(static_cast<uint8_t*>(lpBuffer), *lpNumberOfBytesRead),
+         base::fs::File::FilePointer(
+            targetAddr.value().get() + *lpNumberOfBytesRead),
+         start);
+      return success;
+   }
 
-      if (!extraReads.has_value()) {
-         return success;
+   VOID CALLBACK ReadFileExCompletion(
+      _In_ DWORD dwErrorCode,
+      _In_ DWORD dwNumberOfBytesTransfered,
+      _Inout_ LPOVERLAPPED lpOverlapped)
+   {
+      const auto read = g_apcReads.Take(lpOverlapped);
+      TDD_CHECK(read.has_value(), "Completion of an unknown ReadFileEx");
+
+      if (ERROR_SUCCESS == dwErrorCode) {
+         LastErrorRestorer lastErr;
+         TDD_PPF_DISABLE_FURTHER_HOOKS();
+         PatchCompletedRead(
+            *read->context.session,
+            read->context.file,
+            read->addr,
+            read->buffer,
+            dwNumberOfBytesTransfered,
+            read->context.start);
       }
 
-      TDD_ON_SCOPE_EXIT(
-         const LARGE_INTEGER location{
-            .QuadPart = targetAddr.value().get() + *lpNumberOfBytesRead};
-         if (!::SetFilePointerEx(hFile, location, nullptr, FILE_BEGIN)) {
-            const auto err = stdext::make_last_error();
-            TDD_LOG_ERROR()
-               << "Unable to restore file pointer: " << err.message();
-         });
-
-      PatchExtraRead(hFile, extraReads.value());
-      const auto check = g_patch->Patch(
-         targetAddr.value().get(),
-         std::span(static_cast<uint8_t*>(lpBuffer), *lpNumberOfBytesRead));
-      TDD_CHECK(!check.has_value(), "Unexpected extra read requests");
-      return success;
+      // The emulator's routine runs with hooks enabled again.
+      read->context.completion(
+         dwErrorCode,
+         dwNumberOfBytesTransfered,
+         lpOverlapped);
    }
 
-   BOOL ReadFileExHook(
+   BOOL WINAPI ReadFileExHook(
       _In_ HANDLE hFile,
       LPVOID lpBuffer,
       _In_ DWORD nNumberOfBytesToRead,
       _Inout_ LPOVERLAPPED lpOverlapped,
       _In_ LPOVERLAPPED_COMPLETION_ROUTINE lpCompletionRoutine)
    {
-      const bool skipHook = !HookStatus::ShouldExecute() || hFile == NULL ||
-         hFile == INVALID_HANDLE_VALUE || hFile != g_targetFile;
+      ForgetOverlappedRead(lpOverlapped);
+
+      auto session = HookStatus::ShouldExecute()
+         ? g_sessions.Find(hFile)
+         : nullptr;
 
-      if (skipHook) {
+      if (nullptr == session || nullptr == lpCompletionRoutine) {
          return g_origReadFileEx(
             hFile,
             lpBuffer,
@@ -288,41 +588,231 @@ namespace {
             lpCompletionRoutine);
       }
 
-      TDD_LOG_WARN() << "ReadFileEx is used to read target file!";
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      const auto targetAddr = ReadAddress(hFile, lpOverlapped);
+      LogReadOp(targetAddr, nNumberOfBytesToRead);
 
-      LogReadOp(hFile, nNumberOfBytesToRead);
+      // 2. ReadFileEx. The completion routine is wrapped, the OVERLAPPED is
+      // passed through untouched. The emulator may have hidden data next to
+      // it.
+      g_apcReads.Add(
+         lpOverlapped,
+         {.addr = targetAddr.value().get(),
+          .buffer = std::span(
+             static_cast<uint8_t*>(lpBuffer),
+             nNumberOfBytesToRead),
+          .context = {
+             .session = std::move(session),
+             .file = hFile,
+             .start = ReadStart(),
+             .completion = lpCompletionRoutine}});
 
-      // 2. ReadFileEx. We need to replace the original OVERLAPPED structure.
       const auto success = g_origReadFileEx(
          hFile,
          lpBuffer,
          nNumberOfBytesToRead,
          lpOverlapped,
-         lpCompletionRoutine);
+         ReadFileExCompletion);
 
-      // 3. Post read logging
+      // 3. The routine is only queued if the read was.
+      if (!success) {
+         LastErrorRestorer lastErr;
+         std::ignore = g_apcReads.Take(lpOverlapped);
+      }
 
       return success;
    }
 
-   BOOL WINAPI CloseHandleHook(HANDLE hObject)
+   BOOL WINAPI GetOverlappedResultHook(
+      _In_ HANDLE hFile,
+      _In_ LPOVERLAPPED lpOverlapped,
+      _Out_ LPDWORD lpNumberOfBytesTransferred,
+      _In_ BOOL bWait)
    {
-      const auto success = g_origCloseHandle(hObject);
-      if (!success) {
+      const auto success = g_origGetOverlappedResult(
+         hFile,
+         lpOverlapped,
+         lpNumberOfBytesTransferred,
+         bWait);
+
+      if (!HookStatus::ShouldExecute()) {
+         return success;
+      }
+
+      LastErrorRestorer lastErr;
+      if (!success && IsIncomplete(lastErr.m_lastErr)) {
          return success;
       }
 
-      const bool skipHook = !HookStatus::ShouldExecute() ||
-         g_targetFile != hObject || hObject == INVALID_HANDLE_VALUE;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+      CompleteOverlappedRead(
+         lpOverlapped,
+         hFile,
+         success,
+         *lpNumberOfBytesTransferred);
+      return success;
+   }
+
+   BOOL WINAPI GetOverlappedResultExHook(
+      _In_ HANDLE hFile,
+      _In_ LPOVERLAPPED lpOverlapped,
+      _Out_ LPDWORD lpNumberOfBytesTransferred,
+      _In_ DWORD dwMilliseconds,
+      _In_ BOOL bAlertable)
+   {
+      const auto success = g_origGetOverlappedResultEx(
+         hFile,
+         lpOverlapped,
+         lpNumberOfBytesTransferred,
+         dwMilliseconds,
+         bAlertable);
 
-      if (skipHook) {
+      if (!HookStatus::ShouldExecute()) {
          return success;
       }
 
       LastErrorRestorer lastErr;
+      if (!success && IsIncomplete(lastErr.m_lastErr)) {
+         return success;
+      }
+
       TDD_PPF_DISABLE_FURTHER_HOOKS();
-      TDD_LOG_INFO() << "Target file closed";
-      g_targetFile = INVALID_HANDLE_VALUE;
+      CompleteOverlappedRead(
+         lpOverlapped,
+         hFile,
+         success,
+         *lpNumberOfBytesTransferred);
+      return success;
+   }
+
+   BOOL WINAPI GetQueuedCompletionStatusHook(
+      _In_ HANDLE CompletionPort,
+      _Out_ LPDWORD lpNumberOfBytesTransferred,
+      _Out_ PULONG_PTR lpCompletionKey,
+      _Out_ LPOVERLAPPED* lpOverlapped,
+      _In_ DWORD dwMilliseconds)
+   {
+      const auto success = g_origGetQueuedCompletionStatus(
+         CompletionPort,
+         lpNumberOfBytesTransferred,
+         lpCompletionKey,
+         lpOverlapped,
+         dwMilliseconds);
+
+      if (!HookStatus::ShouldExecute()) {
+         return success;
+      }
+
+      // A failure without an OVERLAPPED didn't dequeue anything.
+      LastErrorRestorer lastErr;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+      CompleteOverlappedRead(
+         *lpOverlapped,
+         std::nullopt,
+         success,
+         *lpNumberOfBytesTransferred);
+      return success;
+   }
+
+   BOOL WINAPI GetQueuedCompletionStatusExHook(
+      _In_ HANDLE CompletionPort,
+      _Out_ LPOVERLAPPED_ENTRY lpCompletionPortEntries,
+      _In_ ULONG ulCount,
+      _Out_ PULONG ulNumEntriesRemoved,
+      _In_ DWORD dwMilliseconds,
+      _In_ BOOL fAlertable)
+   {
+      const auto success = g_origGetQueuedCompletionStatusEx(
+         CompletionPort,
+         lpCompletionPortEntries,
+         ulCount,
+         ulNumEntriesRemoved,
+         dwMilliseconds,
+         fAlertable);
+
+      if (!success || !HookStatus::ShouldExecute()) {
+         return success;
+      }
+
+      LastErrorRestorer lastErr;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+      const auto entries =
+         std::span(lpCompletionPortEntries, *ulNumEntriesRemoved);
+      for (const auto& entry : entries) {
+         // Each entry carries its own status, in the OVERLAPPED. Packets
+         // posted by the emulator itself may have none.
+         const auto ioSucceeded = nullptr != entry.lpOverlapped
+            && static_cast<LONG>(entry.lpOverlapped->Internal) >= 0;
+         CompleteOverlappedRead(
+            entry.lpOverlapped,
+            std::nullopt,
+            ioSucceeded,
+            entry.dwNumberOfBytesTransferred);
+      }
+
+      return success;
+   }
+
+   BOOL WINAPI CloseHandleHook(HANDLE hObject)
+   {
+      // The session is dropped first. Once the handle is closed, another
+      // thread may get the same value back for a different file.
+      if (HookStatus::ShouldExecute()) {
+         LastErrorRestorer lastErr;
+         TDD_PPF_DISABLE_FURTHER_HOOKS();
+         if (g_sessions.Close(hObject)) {
+            TDD_LOG_INFO() << "Target file closed";
+            const auto dropped = g_overlappedReads.EraseIf(
+               [hObject](const auto& read) {
+                  return hObject == read.context.file;
+               });
+            if (0 != dropped) {
+               TDD_LOG_DEBUG() << dropped << " unseen reads dropped";
+            }
+         }
+      }
+
+      return g_origCloseHandle(hObject);
+   }
+
+   BOOL WINAPI DuplicateHandleHook(
+      _In_ HANDLE hSourceProcessHandle,
+      _In_ HANDLE hSourceHandle,
+      _In_ HANDLE hTargetProcessHandle,
+      _Outptr_ LPHANDLE lpTargetHandle,
+      _In_ DWORD dwDesiredAccess,
+      _In_ BOOL bInheritHandle,
+      _In_ DWORD dwOptions)
+   {
+      const auto success = g_origDuplicateHandle(
+         hSourceProcessHandle,
+         hSourceHandle,
+         hTargetProcessHandle,
+         lpTargetHandle,
+         dwDesiredAccess,
+         bInheritHandle,
+         dwOptions);
+
+      if (!success || !HookStatus::ShouldExecute()) {
+         return success;
+      }
+
+      LastErrorRestorer lastErr;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      if (!IsCurrentProcess(hSourceProcessHandle)) {
+         return success;
+      }
+
+      if (nullptr != lpTargetHandle && IsCurrentProcess(hTargetProcessHandle)
+       && nullptr != g_sessions.Duplicate(hSourceHandle, *lpTargetHandle)) {
+         TDD_LOG_DEBUG() << "Target handle duplicated";
+      }
+
+      if (0 != (DUPLICATE_CLOSE_SOURCE & dwOptions)) {
+         std::ignore = g_sessions.Close(hSourceHandle);
+      }
 
       return success;
    }
@@ -341,10 +831,30 @@ namespace {
 
       DetourAttach(reinterpret_cast<PVOID*>(&g_origReadFileEx), ReadFileExHook);
 
+      DetourAttach(
+         reinterpret_cast<PVOID*>(&g_origGetOverlappedResult),
+         GetOverlappedResultHook);
+
+      DetourAttach(
+         reinterpret_cast<PVOID*>(&g_origGetOverlappedResultEx),
+         GetOverlappedResultExHook);
+
+      DetourAttach(
+         reinterpret_cast<PVOID*>(&g_origGetQueuedCompletionStatus),
+         GetQueuedCompletionStatusHook);
+
+      DetourAttach(
+         reinterpret_cast<PVOID*>(&g_origGetQueuedCompletionStatusEx),
+         GetQueuedCompletionStatusExHook);
+
       DetourAttach(
          reinterpret_cast<PVOID*>(&g_origCloseHandle),
          CloseHandleHook);
 
+      DetourAttach(
+         reinterpret_cast<PVOID*>(&g_origDuplicateHandle),
+         DuplicateHandleHook);
+
       DetourTransactionCommit();
    }
 
@@ -372,6 +882,7 @@ void InitLog()
    }
 
    base::logging::SetMinLogLevel(AppConfig::LogLevel());
+   base::logging::SetArchivePolicy(AppConfig::LogArchivePolicy());
 }
 
 }
@@ -0,0 +1,611 @@
+// LD_PRELOAD counterpart of ppfinjector.dll. The libc file functions are
+// interposed instead of detoured, everything else is shared with the DLL.
+#include "hook_status.h"
+
+#include <ppftk/config/app.h>
+#include <ppftk/rom_patch/async_patcher.h>
+#include <ppftk/rom_patch/extra_reads.h>
+#include <ppftk/rom_patch/patch_loader.h>
+#include <ppftk/rom_patch/patch_sessions.h>
+#include <ppftk/rom_patch/read_trace.h>
+
+#include <ppfbase/logging/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Forward to the definition the interposed function hides. Resolved on first
+// use, other libraries may do file IO in their constructors before ours ran.
+#define TDD_PPF_ORIG(fn)                                                   \
+   ([]() noexcept {                                                        \
+      static const auto orig =                                             \
+         tdd::app::ppfpreload::Next<decltype(::fn)>(#fn);                  \
+      return orig;                                                         \
+   }())
+
+// 'mode' is only passed when the flags create a file.
+#define TDD_PPF_MODE_ARG(flags, mode)                                      \
+   mode_t mode = 0;                                                        \
+   if (tdd::app::ppfpreload::NeedsMode(flags)) {                           \
+      va_list args;                                                        \
+      va_start(args, flags);                                               \
+      mode = va_arg(args, mode_t);                                         \
+      va_end(args);                                                        \
+   }
+
+namespace tdd::app::ppfpreload {
+namespace {
+
+   namespace fs = std::filesystem;
+   namespace AppConfig = tk::config::App;
+   namespace HookStatus = ppfinjector::HookStatus;
+   using TraceClock = tk::rompatch::ReadTrace::Clock;
+
+   template <typename Fn>
+   [[nodiscard]] Fn* Next(const char* name) noexcept
+   {
+      const auto fn = reinterpret_cast<Fn*>(::dlsym(RTLD_NEXT, name));
+      TDD_CHECK(nullptr != fn, "Unable to find the next definition");
+      return fn;
+   }
+
+   [[nodiscard]] constexpr bool NeedsMode(const int flags) noexcept
+   {
+      return 0 != (flags & O_CREAT) || O_TMPFILE == (flags & O_TMPFILE);
+   }
+
+   // Set once logging is up. Hooks running before that only forward.
+   std::atomic<bool> g_ready = false;
+
+   // Set with the first patch session if the config turns the read trace on.
+   // Never freed, the hooks run until the process is gone.
+   std::atomic<tk::rompatch::ReadTrace*> g_trace = nullptr;
+
+   // Taken before a read of a target is issued. Only needed for the trace.
+   [[nodiscard]] TraceClock::time_point ReadStart() noexcept
+   {
+      return nullptr != g_trace.load(std::memory_order_relaxed)
+         ? TraceClock::now()
+         : TraceClock::time_point();
+   }
+
+   struct [[nodiscard]] ErrnoRestorer
+   {
+      ErrnoRestorer() noexcept
+         : m_errno(errno)
+      {}
+
+      ~ErrnoRestorer() noexcept
+      {
+         errno = m_errno;
+      }
+
+      const int m_errno;
+
+   private:
+      TDD_DISABLE_COPY_MOVE(ErrnoRestorer);
+   };
+
+   // Runs on the AsyncPatcher's loader thread.
+   [[nodiscard]] std::unique_ptr<tk::rompatch::IPatcher> LoadTarget(
+      const fs::path& file,
+      const tk::rompatch::AsyncPatcher::Announce& announce)
+   {
+      // The loader opens the PPF and the image itself.
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      std::error_code ec;
+      const auto target = fs::canonical(file, ec);
+      if (ec) {
+         TDD_LOG_DEBUG() << "Target [" << file.wstring()
+                         << "] can't be canonicalized: " << ec.message();
+         return nullptr;
+      }
+
+      return tk::rompatch::LoadPatcher(target, announce);
+   }
+
+   // Everything that belongs to one opened image. Shared by all descriptors
+   // the emulator has open on it. pread() leaves their file position alone,
+   // so no private descriptor is needed for the extra reads.
+   struct [[nodiscard]] Session
+   {
+      explicit Session(const fs::path& file)
+         : patcher(std::make_unique<tk::rompatch::AsyncPatcher>(
+            [file](const tk::rompatch::AsyncPatcher::Announce& announce) {
+               return LoadTarget(file, announce);
+            }))
+      {}
+
+      ~Session() = default;
+      TDD_DISABLE_COPY_MOVE(Session);
+
+      const std::unique_ptr<tk::rompatch::AsyncPatcher> patcher;
+   };
+
+   using SessionPtr = std::shared_ptr<Session>;
+
+   tk::rompatch::PatchSessions<int, Session> g_sessions;
+
+   [[nodiscard]] SessionPtr FindSession(const int fd)
+   {
+      if (!g_ready || !HookStatus::ShouldExecute() || fd < 0) {
+         return nullptr;
+      }
+
+      return g_sessions.Find(fd);
+   }
+
+   // Absolute path of 'path' as openat() resolved it. Empty if unknown.
+   [[nodiscard]] fs::path ResolvePath(const int dirfd, const char* path)
+   {
+      std::error_code ec;
+      fs::path file(path);
+      if (file.is_relative() && AT_FDCWD != dirfd) {
+         const auto dir = fs::read_symlink(
+            fs::path("/proc/self/fd") / std::to_string(dirfd),
+            ec);
+         if (ec) {
+            return {};
+         }
+
+         file = dir / file;
+      }
+
+      auto absolute = fs::absolute(file, ec);
+      return ec ? fs::path() : absolute;
+   }
+
+   // Counts the extra reads in 'extraReads'.
+   void PatchBuffer(
+      Session& session,
+      const int fd,
+      const uint64_t addr,
+      std::span<uint8_t> data,
+      uint32_t& extraReads)
+   {
+      const auto patched = tk::rompatch::PatchRead(
+         *session.patcher,
+         addr,
+         data,
+         [fd, &extraReads](const uint64_t readAddr, std::span<uint8_t> buffer) {
+            ++extraReads;
+            const auto bytesRead = TDD_PPF_ORIG(pread64)(
+               fd,
+               buffer.data(),
+               buffer.size(),
+               static_cast<off64_t>(readAddr));
+            return static_cast<ssize_t>(buffer.size()) == bytesRead;
+         });
+
+      // The patcher asks for the extra reads before it touches 'data'.
+      if (!patched) {
+         TDD_LOG_ERROR() << "Read at [" << addr << "] is left unpatched";
+      }
+   }
+
+   // Patches the 'bytesRead' bytes a read starting at 'addr' scattered over
+   // 'iov'. The read was issued at 'start'.
+   void PatchRead(
+      Session& session,
+      const int fd,
+      const uint64_t addr,
+      const std::span<const iovec> iov,
+      const size_t bytesRead,
+      const TraceClock::time_point start)
+   {
+      ErrnoRestorer err;
+      TDD_VLOG2() << addr << ":" << bytesRead;
+
+      const auto trace = g_trace.load(std::memory_order_relaxed);
+      const auto read =
+         nullptr != trace ? TraceClock::now() : TraceClock::time_point();
+
+      auto bufferAddr = addr;
+      auto remaining = bytesRead;
+      uint32_t extraReads = 0;
+      for (const auto& buffer : iov) {
+         if (0 == remaining) {
+            break;
+         }
+
+         const std::span data(
+            static_cast<uint8_t*>(buffer.iov_base),
+            std::min(buffer.iov_len, remaining));
+         PatchBuffer(session, fd, bufferAddr, data, extraReads);
+
+         bufferAddr += data.size();
+         remaining -= data.size();
+      }
+
+      if (nullptr != trace) {
+         trace->Add({
+            .offset = addr,
+            .length = bytesRead,
+            .patchedBytes = session.patcher->PatchedBytes(addr, bytesRead),
+            .extraReads = extraReads,
+            .start = start,
+            .read = read,
+            .patched = TraceClock::now()});
+      }
+   }
+
+   // Same as PatchRead() for reads at the file position, which needs to be
+   // taken before the read moved it.
+   void PatchReadAtPosition(
+      Session& session,
+      const int fd,
+      const off64_t position,
+      const std::span<const iovec> iov,
+      const ssize_t bytesRead,
+      const TraceClock::time_point start)
+   {
+      if (bytesRead <= 0) {
+         return;
+      }
+
+      if (position < 0) {
+         TDD_LOG_WARN() << "Unable to get file position for read";
+         return;
+      }
+
+      PatchRead(
+         session,
+         fd,
+         static_cast<uint64_t>(position),
+         iov,
+         static_cast<size_t>(bytesRead),
+         start);
+   }
+
+   // The trace belongs to the parent. A child would mix its reads in under
+   // the parent's process id.
+   void StopTraceInChild() noexcept
+   {
+      g_trace = nullptr;
+   }
+
+   // Only processes that open a target get a trace file. A forked child
+   // never does.
+   void StartReadTrace()
+   {
+      static std::once_flag once;
+      std::call_once(once, [] {
+         const auto records = AppConfig::ReadTraceRecords();
+         const auto path = 0 != records
+            ? tk::rompatch::ReadTrace::DllTracePath()
+            : std::nullopt;
+         if (!path.has_value()) {
+            return;
+         }
+
+         g_trace = tk::rompatch::ReadTrace::Create(path.value(), records)
+            .release();
+         ::pthread_atfork(nullptr, nullptr, StopTraceInChild);
+      });
+   }
+
+   int OpenHook(const int fd, const int dirfd, const char* path)
+   {
+      // We are not interested in failed opens.
+      if (fd < 0 || !g_ready || !HookStatus::ShouldExecute()) {
+         return fd;
+      }
+
+      ErrnoRestorer err;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      TDD_LOG_DEBUG() << "Opened: " << path;
+
+      // Only cheap checks here. Everything else happens on the loader thread
+      // while the emulator carries on.
+      const auto file = ResolvePath(dirfd, path);
+      if (file.empty() || !tk::rompatch::IsPatchTarget(file)) {
+         return fd;
+      }
+
+      // Sessions are matched by path.
+      std::ignore = g_sessions.Open(fd, file.lexically_normal(), [&file] {
+         TDD_LOG_INFO() << "New patch session for [" << file.wstring() << "]";
+         StartReadTrace();
+         return std::make_shared<Session>(file);
+      });
+      TDD_LOG_DEBUG() << g_sessions.Size() << " target descriptors open";
+
+      return fd;
+   }
+
+   ssize_t ReadHook(const int fd, void* buf, const size_t count)
+   {
+      const auto session = FindSession(fd);
+      if (nullptr == session) {
+         return TDD_PPF_ORIG(read)(fd, buf, count);
+      }
+
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      const auto position = ::lseek64(fd, 0, SEEK_CUR);
+      const auto start = ReadStart();
+      const auto bytesRead = TDD_PPF_ORIG(read)(fd, buf, count);
+
+      const iovec buffer{.iov_base = buf, .iov_len = count};
+      PatchReadAtPosition(
+         *session,
+         fd,
+         position,
+         std::span(&buffer, 1),
+         bytesRead,
+         start);
+      return bytesRead;
+   }
+
+   ssize_t ReadvHook(const int fd, const iovec* iov, const int iovcnt)
+   {
+      const auto session = iovcnt > 0 ? FindSession(fd) : nullptr;
+      if (nullptr == session) {
+         return TDD_PPF_ORIG(readv)(fd, iov, iovcnt);
+      }
+
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      const auto position = ::lseek64(fd, 0, SEEK_CUR);
+      const auto start = ReadStart();
+      const auto bytesRead = TDD_PPF_ORIG(readv)(fd, iov, iovcnt);
+
+      PatchReadAtPosition(
+         *session,
+         fd,
+         position,
+         std::span(iov, static_cast<size_t>(iovcnt)),
+         bytesRead,
+         start);
+      return bytesRead;
+   }
+
+   // pread() and preadv() don't move the file position, so the offset is all
+   // there is to know.
+   ssize_t PreadHook(
+      const int fd,
+      void* buf,
+      const size_t count,
+      const off64_t offset)
+   {
+      const auto session = FindSession(fd);
+      if (nullptr == session) {
+         return TDD_PPF_ORIG(pread64)(fd, buf, count, offset);
+      }
+
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      const auto start = ReadStart();
+      const auto bytesRead = TDD_PPF_ORIG(pread64)(fd, buf, count, offset);
+
+      const iovec buffer{.iov_base = buf, .iov_len = count};
+      PatchReadAtPosition(
+         *session,
+         fd,
+         offset,
+         std::span(&buffer, 1),
+         bytesRead,
+         start);
+      return bytesRead;
+   }
+
+   ssize_t PreadvHook(
+      const int fd,
+      const iovec* iov,
+      const int iovcnt,
+      const off64_t offset)
+   {
+      const auto session = iovcnt > 0 ? FindSession(fd) : nullptr;
+      if (nullptr == session) {
+         return TDD_PPF_ORIG(preadv64)(fd, iov, iovcnt, offset);
+      }
+
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+
+      const auto start = ReadStart();
+      const auto bytesRead =
+         TDD_PPF_ORIG(preadv64)(fd, iov, iovcnt, offset);
+
+      PatchReadAtPosition(
+         *session,
+         fd,
+         offset,
+         std::span(iov, static_cast<size_t>(iovcnt)),
+         bytesRead,
+         start);
+      return bytesRead;
+   }
+
+   // The session is dropped before the descriptor is closed. Afterwards,
+   // another thread may get the same number back for a different file.
+   void CloseSession(const int fd)
+   {
+      if (!g_ready || !HookStatus::ShouldExecute() || fd < 0) {
+         return;
+      }
+
+      ErrnoRestorer err;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+      if (g_sessions.Close(fd)) {
+         TDD_LOG_INFO() << "Target file closed";
+      }
+   }
+
+   int CloseHook(const int fd)
+   {
+      CloseSession(fd);
+      return TDD_PPF_ORIG(close)(fd);
+   }
+
+   // 'newFd' refers to the same file as 'oldFd' now. Whatever it referred to
+   // before was closed silently.
+   int DupHook(const int oldFd, const int newFd)
+   {
+      if (newFd < 0 || !g_ready || !HookStatus::ShouldExecute()) {
+         return newFd;
+      }
+
+      ErrnoRestorer err;
+      TDD_PPF_DISABLE_FURTHER_HOOKS();
+      if (nullptr != g_sessions.Duplicate(oldFd, newFd)) {
+         TDD_LOG_DEBUG() << "Target descriptor duplicated";
+      }
+
+      return newFd;
+   }
+
+   [[nodiscard]] constexpr bool IsDupCommand(const int cmd) noexcept
+   {
+      return F_DUPFD == cmd || F_DUPFD_CLOEXEC == cmd;
+   }
+
+   [[gnu::constructor]] void Init()
+   {
+      base::logging::InitDllLog();
+      base::logging::SetMinLogLevel(AppConfig::LogLevel());
+      base::logging::SetArchivePolicy(AppConfig::LogArchivePolicy());
+      g_ready = true;
+   }
+}
+}
+
+// The 64-bit variants are separate symbols even where off_t is 64 bits. Both
+// need to be interposed.
+extern "C" {
+
+int open(const char* path, int flags, ...)
+{
+   TDD_PPF_MODE_ARG(flags, mode);
+   return tdd::app::ppfpreload::OpenHook(
+      TDD_PPF_ORIG(open)(path, flags, mode),
+      AT_FDCWD,
+      path);
+}
+
+int open64(const char* path, int flags, ...)
+{
+   TDD_PPF_MODE_ARG(flags, mode);
+   return tdd::app::ppfpreload::OpenHook(
+      TDD_PPF_ORIG(open64)(path, flags, mode),
+      AT_FDCWD,
+      path);
+}
+
+int openat(int dirfd, const char* path, int flags, ...)
+{
+   TDD_PPF_MODE_ARG(flags, mode);
+   return tdd::app::ppfpreload::OpenHook(
+      TDD_PPF_ORIG(openat)(dirfd, path, flags, mode),
+      dirfd,
+      path);
+}
+
+int openat64(int dirfd, const char* path, int flags, ...)
+{
+   TDD_PPF_MODE_ARG(flags, mode);
+   return tdd::app::ppfpreload::OpenHook(
+      TDD_PPF_ORIG(openat64)(dirfd, path, flags, mode),
+      dirfd,
+      path);
+}
+
+ssize_t read(int fd, void* buf, size_t count)
+{
+   return tdd::app::ppfpreload::ReadHook(fd, buf, count);
+}
+
+ssize_t readv(int fd, const iovec* iov, int iovcnt)
+{
+   return tdd::app::ppfpreload::ReadvHook(fd, iov, iovcnt);
+}
+
+ssize_t pread(int fd, void* buf, size_t count, off_t offset)
+{
+   return tdd::app::ppfpreload::PreadHook(fd, buf, count, offset);
+}
+
+ssize_t pread64(int fd, void* buf, size_t count, off64_t offset)
+{
+   return tdd::app::ppfpreload::PreadHook(fd, buf, count, offset);
+}
+
+ssize_t preadv(int fd, const iovec* iov, int iovcnt, off_t offset)
+{
+   return tdd::app::ppfpreload::PreadvHook(fd, iov, iovcnt, offset);
+}
+
+ssize_t preadv64(int fd, const iovec* iov, int iovcnt, off64_t offset)
+{
+   return tdd::app::ppfpreload::PreadvHook(fd, iov, iovcnt, offset);
+}
+
+int close(int fd)
+{
+   return tdd::app::ppfpreload::CloseHook(fd);
+}
+
+int dup(int oldfd)
+{
+   return tdd::app::ppfpreload::DupHook(oldfd, TDD_PPF_ORIG(dup)(oldfd));
+}
+
+int dup2(int oldfd, int newfd)
+{
+   return tdd::app::ppfpreload::DupHook(
+      oldfd,
+      TDD_PPF_ORIG(dup2)(oldfd, newfd));
+}
+
+int dup3(int oldfd, int newfd, int flags)
+{
+   return tdd::app::ppfpreload::DupHook(
+      oldfd,
+      TDD_PPF_ORIG(dup3)(oldfd, newfd, flags));
+}
+
+// The optional argument is an int or a pointer depending on 'cmd'. Both are
+// passed the same way, so it is forwarded as a pointer, the way libc reads
+// it.
+int fcntl(int fd, int cmd, ...)
+{
+   va_list args;
+   va_start(args, cmd);
+   const auto arg = va_arg(args, void*);
+   va_end(args);
+
+   const auto result = TDD_PPF_ORIG(fcntl)(fd, cmd, arg);
+   return tdd::app::ppfpreload::IsDupCommand(cmd)
+      ? tdd::app::ppfpreload::DupHook(fd, result)
+      : result;
+}
+
+int fcntl64(int fd, int cmd, ...)
+{
+   va_list args;
+   va_start(args, cmd);
+   const auto arg = va_arg(args, void*);
+   va_end(args);
+
+   const auto result = TDD_PPF_ORIG(fcntl64)(fd, cmd, arg);
+   return tdd::app::ppfpreload::IsDupCommand(cmd)
+      ? tdd::app::ppfpreload::DupHook(fd, result)
+      : result;
+}
+
+}
\ No newline at end of file
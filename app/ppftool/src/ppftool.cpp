@@ -0,0 +1,373 @@
+#include <ppftk/config/app.h>
+#include <ppftk/rom_patch/offline_apply.h>
+#include <ppftk/rom_patch/patch_file_exts.h>
+#include <ppftk/rom_patch/patchers.h>
+#include <ppftk/rom_patch/cd/spec.h>
+#include <ppftk/rom_patch/cd/verify.h>
+#include <ppftk/rom_patch/ppf/parser.h>
+#include <ppftk/rom_patch/read_trace.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/preprocessor_utils.h>
+
+#include <cli11/CLI11.hpp>
+#include <gsl/pointers>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace tdd::app::ppftool {
+
+namespace {
+   namespace fs = std::filesystem;
+   namespace rompatch = tk::rompatch;
+
+   // ppftool apply --image foo.bin --output foo.patched.bin
+   class [[nodiscard]] Apply
+   {
+   public:
+      Apply(CLI::App& ppftool)
+         : m_cmd(ppftool.add_subcommand(
+              "apply",
+              "Write a patched copy of an image, the way the injector would "
+              "patch it on the fly"))
+         , m_image()
+         , m_patch()
+         , m_output()
+         , m_noEdc(false)
+         , m_stream(false)
+         , m_threads(0)
+         , m_ranges()
+      {
+         m_cmd->add_option("--image", m_image, "The image to patch.")
+            ->required()
+            ->check(CLI::ExistingFile);
+
+         m_cmd->add_option(
+            "--patch",
+            m_patch,
+            "The PPF to apply. Defaults to the PPF next to the image.");
+
+         m_cmd->add_option(
+            "--output",
+            m_output,
+            "Where to write the patched image. Must not be the image.")
+            ->required();
+
+         m_cmd->add_flag(
+            "--no_edc",
+            m_noEdc,
+            "Copy the patch data only. Use for PPFs that already contain the "
+            "recalculated EDC.");
+
+         m_cmd->add_flag(
+            "--stream",
+            m_stream,
+            "Read, patch and write the whole image. By default the image is "
+            "cloned, without copying on btrfs, XFS and ReFS, and only the "
+            "patched sectors are rewritten.");
+
+         m_cmd->add_option(
+            "--threads",
+            m_threads,
+            "Patching threads with --stream. Defaults to one per core.");
+      }
+
+      TDD_DISABLE_COPY_MOVE(Apply);
+
+      [[nodiscard]] bool Execute()
+      {
+         if (m_cmd->count() == 0) {
+            return false;
+         }
+
+         // The parser only takes absolute paths.
+         m_image = fs::weakly_canonical(m_image);
+         m_output = fs::weakly_canonical(m_output);
+         if (m_patch.empty()) {
+            m_patch = m_image;
+            m_patch.replace_extension(rompatch::exts::kPpf);
+         }
+         m_patch = fs::weakly_canonical(m_patch);
+
+         const auto patcher = LoadPatcher();
+
+         const auto start = std::chrono::steady_clock::now();
+         const rompatch::OfflineApplyOptions options{.workers = m_threads};
+         const auto ok = m_stream
+            ? rompatch::ApplyOffline(*patcher, m_image, m_output, options)
+            : rompatch::ApplyToClone(*patcher, m_ranges, m_image, m_output);
+         if (!ok) {
+            throw std::runtime_error("Patching failed. See the log.");
+         }
+
+         const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start);
+         std::cout << "Wrote " << m_output.string() << " in "
+            << elapsed.count() << " ms" << std::endl;
+         return true;
+      }
+
+   private:
+      // Also collects the sectors the patch touches.
+      [[nodiscard]] std::unique_ptr<rompatch::IPatcher> LoadPatcher()
+      {
+         auto patch = rompatch::ppf::Parse(m_patch);
+         if (!patch.has_value()) {
+            throw std::runtime_error("Unable to parse " + m_patch.string());
+         }
+
+         m_ranges = rompatch::AsyncPatcher::CoveredRanges(
+            patch->GetFullPatch(),
+            rompatch::cd::spec::kSectorSize);
+
+         if (m_noEdc) {
+            return std::make_unique<rompatch::SimplePatcher>(
+               std::move(patch).value());
+         }
+         return std::make_unique<rompatch::cd::Patcher>(
+            std::move(patch).value());
+      }
+
+      gsl::not_null<CLI::App*> m_cmd;
+      fs::path m_image;
+      fs::path m_patch;
+      fs::path m_output;
+      bool m_noEdc;
+      bool m_stream;
+      size_t m_threads;
+      rompatch::AsyncPatcher::Ranges m_ranges;
+   };
+
+   // ppftool verify --image foo.patched.bin --verification foo.expected.bin
+   //
+   // Same comparison as 'emulauncher test live_patch', without the injector.
+   class [[nodiscard]] Verify
+   {
+   public:
+      Verify(CLI::App& ppftool)
+         : m_cmd(ppftool.add_subcommand(
+              "verify",
+              "Compare a patched image with a pre-patched verification image "
+              "and list every mismatching sector"))
+         , m_image()
+         , m_verification()
+         , m_checkEdc(false)
+         , m_checkEcc(false)
+         , m_threads(0)
+      {
+         m_cmd->add_option("--image", m_image, "The image to read.")
+            ->required()
+            ->check(CLI::ExistingFile);
+
+         m_cmd->add_option(
+            "--verification",
+            m_verification,
+            "The pre-patched image to compare with.")
+            ->required()
+            ->check(CLI::ExistingFile);
+
+         m_cmd->add_flag(
+            "--check_edc",
+            m_checkEdc,
+            "Compare the EDC of every sector.");
+
+         m_cmd->add_flag(
+            "--check_ecc",
+            m_checkEcc,
+            "Compare every byte, ECC included. Implies --check_edc");
+
+         m_cmd->add_option(
+            "--threads",
+            m_threads,
+            "Comparing threads. Defaults to one per core.");
+      }
+
+      TDD_DISABLE_COPY_MOVE(Verify);
+
+      [[nodiscard]] bool Execute()
+      {
+         if (m_cmd->count() == 0) {
+            return false;
+         }
+
+         rompatch::cd::VerifyOptions options;
+         options.workers = m_threads;
+         if (m_checkEcc) {
+            options.level = rompatch::cd::VerifyLevel::Ecc;
+         }
+         else if (m_checkEdc) {
+            options.level = rompatch::cd::VerifyLevel::Edc;
+         }
+
+         const auto start = std::chrono::steady_clock::now();
+         const auto report =
+            rompatch::cd::Verify(m_image, m_verification, options);
+         if (!report) {
+            throw std::runtime_error("Unable to compare. See the log.");
+         }
+
+         const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start);
+         std::cout << "Compared " << report->sectors << " sectors in "
+            << elapsed.count() << " ms" << std::endl;
+
+         for (const auto& mismatch : report->mismatches) {
+            std::cout << "Sector " << mismatch.sector << " ("
+               << ToString(mismatch.layout) << ") mismatch at offset "
+               << mismatch.offset << std::endl;
+         }
+
+         if (!report->mismatches.empty()) {
+            throw std::runtime_error(
+               std::to_string(report->mismatches.size()) +
+               " sectors mismatch");
+         }
+         return true;
+      }
+
+   private:
+      gsl::not_null<CLI::App*> m_cmd;
+      fs::path m_image;
+      fs::path m_verification;
+      bool m_checkEdc;
+      bool m_checkEcc;
+      size_t m_threads;
+   };
+
+   // ppftool trace --input libppfpreload.foo.1234.trace --csv
+   class [[nodiscard]] Trace
+   {
+   public:
+      Trace(CLI::App& ppftool)
+         : m_cmd(ppftool.add_subcommand(
+              "trace",
+              "Print the reads recorded in a binary read trace"))
+         , m_input()
+         , m_csv(false)
+      {
+         m_cmd->add_option("--input", m_input, "The trace file to print.")
+            ->required()
+            ->check(CLI::ExistingFile);
+
+         m_cmd->add_flag(
+            "--csv",
+            m_csv,
+            "Print comma separated values instead of a table.");
+      }
+
+      TDD_DISABLE_COPY_MOVE(Trace);
+
+      [[nodiscard]] bool Execute()
+      {
+         if (m_cmd->count() == 0) {
+            return false;
+         }
+
+         const auto trace = rompatch::ReadTrace::Load(m_input);
+         if (!trace) {
+            throw std::runtime_error("Unable to load the trace. See the log.");
+         }
+
+         if (m_csv) {
+            PrintCsv(trace.value());
+         }
+         else {
+            PrintTable(trace.value());
+         }
+         return true;
+      }
+
+   private:
+      static void PrintCsv(const rompatch::ReadTrace::Contents& trace)
+      {
+         std::cout << "sequence,time_ns,thread,offset,length,patched_bytes,"
+            "extra_reads,read_ns,patch_ns\n";
+         for (const auto& r : trace.records) {
+            std::cout << r.sequence << ',' << r.time << ',' << r.threadId
+               << ',' << r.offset << ',' << r.length << ','
+               << r.patchedBytes << ',' << r.extraReads << ','
+               << r.readTime << ',' << r.patchTime << '\n';
+         }
+         std::cout << std::flush;
+      }
+
+      // Times in microseconds since the trace started.
+      static void PrintTable(const rompatch::ReadTrace::Contents& trace)
+      {
+         const auto& header = trace.header;
+         std::cout << "Process " << header.processId << ", started at "
+            << header.startTime / 1'000'000'000 << "."
+            << std::setfill('0') << std::setw(3)
+            << header.startTime / 1'000'000 % 1'000
+            << std::setfill(' ') << " Unix time. Last "
+            << trace.records.size() << " of " << header.next
+            << " reads:\n";
+
+         std::cout << std::setw(14) << "time (us)" << std::setw(8) << "thread"
+            << std::setw(14) << "offset" << std::setw(9) << "length"
+            << std::setw(9) << "patched" << std::setw(6) << "extra"
+            << std::setw(11) << "read (ns)" << std::setw(12) << "patch (ns)"
+            << '\n';
+
+         for (const auto& r : trace.records) {
+            std::cout << std::setw(10) << r.time / 1'000 << "."
+               << std::setfill('0') << std::setw(3) << r.time % 1'000
+               << std::setfill(' ') << std::setw(8) << r.threadId
+               << std::setw(14) << r.offset << std::setw(9) << r.length
+               << std::setw(9) << r.patchedBytes << std::setw(6)
+               << r.extraReads << std::setw(11) << r.readTime
+               << std::setw(12) << r.patchTime << '\n';
+         }
+         std::cout << std::flush;
+      }
+
+      gsl::not_null<CLI::App*> m_cmd;
+      fs::path m_input;
+      bool m_csv;
+   };
+
+   [[nodiscard]] int HandleCmdLine(const int argc, const char* const* argv)
+   {
+      CLI::App ppftool("PPF injector offline tools");
+      ppftool.require_subcommand(1);
+
+      Apply apply(ppftool);
+      Verify verify(ppftool);
+      Trace trace(ppftool);
+
+      CLI11_PARSE(ppftool, argc, argv);
+
+      try {
+         if (apply.Execute() || verify.Execute() || trace.Execute()) {
+            return 0;
+         }
+
+         TDD_LOG_FATAL() << "No commands to execute";
+         return 1;
+      }
+      catch (const std::exception& e) {
+         std::cout << "Action failed: " << e.what() << std::endl;
+         return 1;
+      }
+   }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+   tdd::base::logging::InitProcessLog(
+      tdd::base::logging::SharingMode::MultiProcess);
+
+   tdd::base::logging::SetMinLogLevel(
+      tdd::tk::config::App::LogLevel());
+   tdd::base::logging::SetArchivePolicy(
+      tdd::tk::config::App::LogArchivePolicy());
+
+   return tdd::app::ppftool::HandleCmdLine(argc, argv);
+}
\ No newline at end of file
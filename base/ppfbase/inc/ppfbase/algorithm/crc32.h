@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <span>
 #include <limits>
 
@@ -41,6 +42,130 @@ inline consteval LookupTable CompileLookupTable(const uint32_t polynomial)
    return GenerateLookupTable(polynomial);
 }
 
+// Tables for processing 'N' bytes per step. table[k][i] is the CRC of byte 'i'
+// followed by 'k' zero bytes, so table[0] is the regular lookup table.
+template <size_t N>
+using SlicingTable = std::array<LookupTable, N>;
+
+using SlicingBy8Table = SlicingTable<8>;
+using SlicingBy16Table = SlicingTable<16>;
+
+template <size_t N>
+inline constexpr SlicingTable<N> GenerateSlicingTable(const uint32_t polynomial)
+{
+   SlicingTable<N> table{GenerateLookupTable(polynomial)};
+   for (size_t k = 1; k < N; ++k) {
+      for (size_t i = 0; i <= std::numeric_limits<uint8_t>::max(); ++i) {
+         const auto prev = table[k - 1][i];
+         table[k][i] = (prev >> 8) ^ table[0][prev & 0xFF];
+      }
+   }
+   return table;
+}
+
+template <size_t N>
+inline consteval SlicingTable<N> CompileSlicingTable(const uint32_t polynomial)
+{
+   return GenerateSlicingTable<N>(polynomial);
+}
+
+namespace details {
+   // Reverses the lowest 'bits' bits of 'value'.
+   inline constexpr uint64_t Reflect(uint64_t value, const int bits)
+   {
+      uint64_t reflected = 0;
+      for (auto i = 0; i < bits; ++i) {
+         reflected = (reflected << 1) | (value & 1);
+         value >>= 1;
+      }
+      return reflected;
+   }
+
+   // x^n mod P(x), reflected and shifted into the 33-bit form the folding
+   // kernel multiplies with. 'polynomial' is in Reversed form.
+   inline constexpr uint64_t FoldingConstant(
+      const uint32_t polynomial,
+      const int n)
+   {
+      const uint64_t normal = (uint64_t{1} << 32) | Reflect(polynomial, 32);
+
+      uint64_t remainder = 1;
+      for (auto i = 0; i < n; ++i) {
+         remainder <<= 1;
+         if (remainder >> 32) {
+            remainder ^= normal;
+         }
+      }
+      return Reflect(remainder, 32) << 1;
+   }
+
+   // floor(x^64 / P(x)), reflected. 'polynomial' is in Reversed form.
+   inline constexpr uint64_t BarrettConstant(const uint32_t polynomial)
+   {
+      const uint64_t normal = (uint64_t{1} << 32) | Reflect(polynomial, 32);
+
+      // The dividend x^64 does not fit in 64 bits. Its leading term always
+      // produces the x^32 term of the quotient, which leaves x^64 - x^32 P(x)
+      // as the remainder to carry on with.
+      uint64_t quotient = uint64_t{1} << 32;
+      uint64_t remainder = (normal ^ (uint64_t{1} << 32)) << 32;
+      for (auto bit = 63; bit >= 32; --bit) {
+         if ((remainder >> bit) & 1) {
+            quotient |= uint64_t{1} << (bit - 32);
+            remainder ^= normal << (bit - 32);
+         }
+      }
+      return Reflect(quotient, 33);
+   }
+}
+
+// Constants for folding the data with carry-less multiplication. Intel,
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// Each pair is laid out to be loaded straight into an XMM register.
+struct [[nodiscard]] FoldingConstants
+{
+   // x^(4*128+32), x^(4*128-32) mod P(x). Folds 512 bits at a time.
+   std::array<uint64_t, 2> fold512;
+   // x^(128+32), x^(128-32) mod P(x). Folds 128 bits at a time.
+   std::array<uint64_t, 2> fold128;
+   // x^64 mod P(x). Folds the last 96 bits down to 64.
+   std::array<uint64_t, 2> fold64;
+   // P(x) and floor(x^64 / P(x)) for the final Barrett reduction.
+   std::array<uint64_t, 2> barrett;
+};
+
+// The folding kernel needs a CPU with PCLMULQDQ. The slicing table covers
+// everything else: older CPUs, short blocks and the tail of a block.
+struct [[nodiscard]] FoldingTable
+{
+   FoldingConstants constants;
+   SlicingBy8Table fallback;
+};
+
+inline constexpr FoldingTable GenerateFoldingTable(const uint32_t polynomial)
+{
+   using details::FoldingConstant;
+
+   return FoldingTable{
+      .constants = {
+         .fold512 = {
+            FoldingConstant(polynomial, 4 * 128 + 32),
+            FoldingConstant(polynomial, 4 * 128 - 32)},
+         .fold128 = {
+            FoldingConstant(polynomial, 128 + 32),
+            FoldingConstant(polynomial, 128 - 32)},
+         .fold64 = {FoldingConstant(polynomial, 64), 0},
+         .barrett = {
+            (uint64_t{polynomial} << 1) | 1,
+            details::BarrettConstant(polynomial)}},
+      .fallback = GenerateSlicingTable<8>(polynomial)};
+}
+
+inline consteval FoldingTable CompileFoldingTable(const uint32_t polynomial)
+{
+   return GenerateFoldingTable(polynomial);
+}
+
 // Some CRC calculations require the starting value to be 0. The default
 // expectation is that we start with 0xFFFF'FFFF, which is unsigned -1.
 enum class InitialValue
@@ -49,9 +174,34 @@ enum class InitialValue
    MinusOne
 };
 
+// One byte per step.
 [[nodiscard]] uint32_t ComputeCrc(
    std::span<const uint8_t> block,
    const LookupTable& table,
    const InitialValue init) noexcept;
 
+// 8 bytes per step. The tables take 8 KiB.
+[[nodiscard]] uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const SlicingBy8Table& table,
+   const InitialValue init) noexcept;
+
+// 16 bytes per step. The tables take 16 KiB, which competes with the data for
+// L1 cache on small blocks.
+[[nodiscard]] uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const SlicingBy16Table& table,
+   const InitialValue init) noexcept;
+
+// Folds 64 bytes per step with PCLMULQDQ when the CPU supports it. Falls back
+// to slicing-by-8 otherwise.
+[[nodiscard]] uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const FoldingTable& table,
+   const InitialValue init) noexcept;
+
+// True if ComputeCrc with a FoldingTable uses carry-less multiplication on
+// this CPU.
+[[nodiscard]] bool HasFoldingKernel() noexcept;
+
 }
\ No newline at end of file
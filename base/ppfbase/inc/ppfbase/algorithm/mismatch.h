@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tdd::base::algorithm {
+
+// Index of the first byte where 'lhs' and 'rhs' differ. The size of the
+// shorter one if they don't. Compares 64 bytes per step with SSE2 on x86-64
+// and 8 bytes per step elsewhere.
+[[nodiscard]] size_t FindFirstMismatch(
+   std::span<const uint8_t> lhs,
+   std::span<const uint8_t> rhs) noexcept;
+
+}
\ No newline at end of file
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
 #include <string>
 
 namespace tdd::base::chrono::TimeStamp {
+   // "2023-09-03@12:34:56.789+01:00[00:00:01.234]" with room for uptimes of
+   // up to 7 digits of hours.
+   inline constexpr size_t kMaxLength = 48;
+
    std::string Now();
+   // Now() without the allocation. Returns the length written to 'out'.
+   size_t Now(std::span<char, kMaxLength> out) noexcept;
+
    std::wstring FilenameSuffix();
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+namespace tdd::base::fs {
+
+   // A file that is only ever written at its end, by any number of threads
+   // and processes at once. Every Append() goes to the end of the file as it
+   // is at that moment, in one piece. Records appended whole never interleave
+   // and need no lock.
+   //
+   // Other processes may rename or delete the file while it is open.
+   class [[nodiscard]] AppendFile
+   {
+   public:
+#ifdef _WIN32
+      using native_handle_type = void*;
+#else
+      using native_handle_type = int;
+#endif
+
+      struct [[nodiscard]] Status
+      {
+         // Appends of other processes included.
+         uint64_t size;
+         // By another process. Appends still succeed, and are lost.
+         bool deleted;
+      };
+
+      // Closed until Open().
+      AppendFile() noexcept;
+      ~AppendFile() noexcept;
+
+      // Creates 'path' if it doesn't exist. Closes the file open before.
+      [[nodiscard]] std::error_code Open(
+         const std::filesystem::path& path) noexcept;
+      void Close() noexcept;
+      [[nodiscard]] bool IsOpen() const noexcept;
+
+      [[nodiscard]] std::error_code Append(std::string_view data) noexcept;
+
+      [[nodiscard]] std::optional<Status> GetStatus() const noexcept;
+
+      // False once the open file was renamed or deleted, e.g. by another
+      // process rotating it.
+      [[nodiscard]] bool IsAt(
+         const std::filesystem::path& path) const noexcept;
+
+   private:
+      native_handle_type m_handle;
+
+      TDD_DISABLE_COPY_MOVE(AppendFile);
+   };
+
+}
\ No newline at end of file
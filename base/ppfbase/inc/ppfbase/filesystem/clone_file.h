@@ -0,0 +1,26 @@
+#pragma once
+
+#include <ppfbase/stdext/poor_mans_expected.h>
+
+#include <filesystem>
+
+namespace tdd::base::fs {
+
+   enum class [[nodiscard]] CloneMethod
+   {
+      // 'target' shares the extents of 'source'. Nothing was copied and
+      // only what is written to 'target' later takes up space of its own.
+      Reflink,
+      // The data was copied. Holes in 'source' stay holes where the
+      // platform can find them.
+      Copy
+   };
+
+   // Creates or replaces 'target' with the contents of 'source'. Copy-on-write
+   // filesystems clone it, btrfs and XFS through FICLONE, ReFS through block
+   // cloning. Everything else gets a copy.
+   [[nodiscard]] stdext::pm_expected<CloneMethod> CloneFile(
+      const std::filesystem::path& source,
+      const std::filesystem::path& target);
+
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+
+namespace tdd::base::fs {
+
+   // Has the filesystem compress 'path' in place. NTFS marks it compressed
+   // through FSCTL_SET_COMPRESSION, btrfs rewrites its extents compressed.
+   // The file reads the same either way. Other filesystems fail, and the file
+   // stays as it is.
+   [[nodiscard]] std::error_code CompressFile(
+      const std::filesystem::path& path) noexcept;
+
+}
\ No newline at end of file
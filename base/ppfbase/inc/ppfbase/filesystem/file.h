@@ -2,7 +2,9 @@
 
 #include <ppfbase/stdext/type_traits.h>
 
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <system_error>
 
 #include <Windows.h>
@@ -23,4 +25,16 @@ namespace tdd::base::fs::File {
    const HANDLE hFile,
    const FilePointer pos) noexcept;
 
+// Read-only handle to the file behind 'hFile' with a file pointer of its own,
+// opened for overlapped IO. INVALID_HANDLE_VALUE on failure.
+[[nodiscard]] HANDLE ReopenForReadAt(const HANDLE hFile) noexcept;
+
+// Reads buffer.size() bytes at 'pos' and waits for them. Leaves the file
+// pointer alone on handles opened for overlapped IO. Other handles end up
+// after the data read.
+[[nodiscard]] std::error_code ReadAt(
+   const HANDLE hFile,
+   const FilePointer pos,
+   std::span<uint8_t> buffer) noexcept;
+
 }
\ No newline at end of file
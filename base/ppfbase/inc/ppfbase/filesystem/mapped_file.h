@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/stdext/poor_mans_expected.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace tdd::base::fs {
+
+   // Read-only view of a whole file mapped into memory. The view stays valid
+   // until the MappedFile is destroyed. Other processes may still write to
+   // the file, e.g. a read trace that is being recorded.
+   class [[nodiscard]] MappedFile
+   {
+   public:
+      [[nodiscard]] static stdext::pm_expected<MappedFile> Open(
+         const std::filesystem::path& path);
+
+      ~MappedFile() = default;
+      TDD_DEFAULT_MOVE(MappedFile);
+
+      [[nodiscard]] std::span<const uint8_t> Data() const noexcept;
+
+   private:
+      struct [[nodiscard]] Unmapper
+      {
+         void operator()(const uint8_t* view) const noexcept;
+
+         // munmap() needs the length of the view.
+         size_t size;
+      };
+
+      MappedFile(const uint8_t* view, const size_t size) noexcept;
+
+      std::unique_ptr<const uint8_t, Unmapper> m_view;
+      size_t m_size;
+
+      TDD_DISABLE_COPY(MappedFile);
+   };
+
+   // Read-write view of a file of a fixed size. Writes go straight to the
+   // page cache, and other processes mapping the file see them right away.
+   class [[nodiscard]] WritableMappedFile
+   {
+   public:
+      // Replaces whatever 'path' contained with 'size' zeroed bytes.
+      [[nodiscard]] static stdext::pm_expected<WritableMappedFile> Create(
+         const std::filesystem::path& path,
+         const size_t size);
+
+      ~WritableMappedFile() = default;
+      TDD_DEFAULT_MOVE(WritableMappedFile);
+
+      [[nodiscard]] std::span<uint8_t> Data() const noexcept;
+
+   private:
+      struct [[nodiscard]] Unmapper
+      {
+         void operator()(uint8_t* view) const noexcept;
+
+         size_t size;
+      };
+
+      WritableMappedFile(uint8_t* view, const size_t size) noexcept;
+
+      std::unique_ptr<uint8_t, Unmapper> m_view;
+      size_t m_size;
+
+      TDD_DISABLE_COPY(WritableMappedFile);
+   };
+
+}
\ No newline at end of file
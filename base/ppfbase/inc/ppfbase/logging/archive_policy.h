@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace tdd::base::logging {
+
+   // When a log is rotated and how long its archives are kept. A limit of 0
+   // is off.
+   struct [[nodiscard]] ArchivePolicy
+   {
+      // The file is archived once it holds this many bytes...
+      uint64_t maxFileBytes;
+      // ...and at every multiple of this since the epoch, UTC. A day rotates
+      // at midnight.
+      std::chrono::seconds rotationInterval;
+
+      // The oldest archives are deleted until all of these hold.
+      uint32_t maxArchives;
+      // Since the archive was last written.
+      std::chrono::seconds maxArchiveAge;
+      // Uncompressed, all archives together.
+      uint64_t maxArchiveBytes;
+
+      // Has the filesystem compress archives, where it can.
+      bool compress;
+
+      bool operator==(const ArchivePolicy&) const = default;
+   };
+
+   // 10mb per file, ten files with the current one. Compression is opt-in,
+   // it rewrites every archive and only NTFS and btrfs have it.
+   inline constexpr ArchivePolicy kDefaultArchivePolicy{
+      .maxFileBytes = 10 * 1024 * 1024,
+      .rotationInterval = std::chrono::seconds(0),
+      .maxArchives = 9,
+      .maxArchiveAge = std::chrono::seconds(0),
+      .maxArchiveBytes = 0,
+      .compress = false};
+
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ppfbase/logging/archive_policy.h>
+
 #include <filesystem>
 #include <string>
 
@@ -13,6 +15,10 @@ namespace tdd::base::logging {
 
       virtual const std::filesystem::path& path() const noexcept = 0;
       virtual void Write(const char* msg) = 0;
+      // Writes out anything the log held back.
+      virtual void Flush() = 0;
+      // Applies to the rotations from now on.
+      virtual void SetArchivePolicy(const ArchivePolicy& policy) = 0;
 
       inline static constexpr auto kExt = L".log";
    };
@@ -25,6 +31,8 @@ namespace tdd::base::logging {
 
       virtual const std::filesystem::path& path() const noexcept override { return m_empty; }
       virtual void Write(const char*) override {}
+      virtual void Flush() override {}
+      virtual void SetArchivePolicy(const ArchivePolicy&) override {}
    private:
       const std::filesystem::path m_empty;
    };
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/filesystem/append_file.h>
+#include <ppfbase/logging/archive_policy.h>
+#include <ppfbase/logging/sharing_mode.h>
+#include <ppfbase/stdext/mutex.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+
+namespace tdd::base::logging {
+
+   // Looks after a log file on a thread of its own. Writers append to the
+   // current file and only flag it once it is due. The archivist renames it,
+   // swaps a new file in for the writers, then compresses and prunes the
+   // archives. Appending never waits on a rename or a directory scan.
+   //
+   // Archives are named <stem>.<YYYYMMDD-HHMMSS>[-N].log, next to the log.
+   // With SharingMode::MultiProcess, the processes sharing the file take a
+   // named mutex to rotate it and pick up each other's rotations.
+   //
+   // A child process after fork() has no archivist thread. It leaves the
+   // rotations to its parent and follows them.
+   class [[nodiscard]] LogArchivist
+   {
+   public:
+      LogArchivist(
+         const std::filesystem::path& logFile,
+         const ArchivePolicy& policy,
+         SharingMode sharing);
+      ~LogArchivist();
+
+      TDD_DISABLE_COPY_MOVE(LogArchivist);
+
+      const std::filesystem::path& path() const noexcept;
+
+      // Appends 'msg' to the current file in one piece. Throws
+      // std::system_error if the file can't be opened or written.
+      void Append(std::string_view msg);
+
+      // The archivist thread prunes by the new policy right away.
+      void SetPolicy(const ArchivePolicy& policy);
+
+      // Archives the file unless it is empty, then compresses and prunes the
+      // archives, on the calling thread.
+      void Rotate();
+
+   private:
+      using Clock = std::chrono::system_clock;
+      using FilePtr = std::shared_ptr<fs::AppendFile>;
+
+      enum class Trigger : uint8_t
+      {
+         Request,
+         Size,
+         Interval
+      };
+
+      void Run(std::stop_token stop);
+      void Wake();
+
+      // Archives the file and compresses the archive, if 'trigger' still
+      // holds.
+      void Archive(Trigger trigger, const ArchivePolicy& policy);
+      // Returns the archive, nullopt if there was nothing to do.
+      [[nodiscard]] std::optional<std::filesystem::path> RotateFile(
+         Trigger trigger,
+         const ArchivePolicy& policy);
+      void Prune(const ArchivePolicy& policy) const;
+
+      // Swaps a file newly opened at m_path in for 'stale'. Whatever another
+      // thread swapped in first wins. Returns the current file.
+      FilePtr Reopen(FilePtr stale);
+
+      // Requires m_lock.
+      void ScheduleInterval(Clock::time_point now);
+
+#ifndef _WIN32
+      static void PrepareFork() noexcept;
+      static void AfterForkInParent() noexcept;
+      static void AfterForkInChild() noexcept;
+#endif
+
+      const std::filesystem::path m_path;
+
+      std::atomic<FilePtr> m_file;
+      std::atomic<uint64_t> m_maxFileBytes;
+      std::atomic<bool> m_rotationDue;
+      // No archivist thread, in a child after fork().
+      std::atomic<bool> m_orphaned;
+
+      // Held to rename the file. The named one keeps other processes out.
+      std::mutex m_rotationLock;
+      std::optional<stdext::mp_mutex> m_sharedLock;
+
+      std::mutex m_lock;
+      std::condition_variable_any m_wake;
+      ArchivePolicy m_policy;
+      bool m_policyChanged;
+      std::optional<Clock::time_point> m_nextInterval;
+
+      std::jthread m_thread;
+   };
+
+}
\ No newline at end of file
@@ -4,17 +4,38 @@
 #include <ppfbase/preprocessor_utils.h>
 
 #include <sstream>
+#include <string_view>
 
 namespace tdd::base::logging {
+   namespace details {
+      class LogStream;
+
+      // The file name at the end of __FILE__, found at compile time.
+      consteval const char* SourceFileName(const char* path)
+      {
+         const char* name = path;
+         for (auto it = path; *it != '\0'; ++it) {
+            if (*it == '/' || *it == '\\') {
+               name = it + 1;
+            }
+         }
+         return name;
+      }
+   }
+
    class LogMsg
    {
    public:
+      // 'file' is only the file name. See TDD_LOG_EX.
       LogMsg(const char* file, int line, const char* func, Severity severity);
       ~LogMsg();
       std::ostream& stream() noexcept;
 
+      // The message so far, prefix included.
+      [[nodiscard]] std::string_view str() const noexcept;
+
    private:
-      std::ostringstream m_os;
+      details::LogStream& m_stream;
       const Severity m_severity;
 
       TDD_DISABLE_COPY_MOVE(LogMsg);
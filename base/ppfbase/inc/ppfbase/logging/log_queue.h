@@ -0,0 +1,66 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace tdd::base::logging {
+
+   // Bounded lock-free queue of log messages. Any number of threads push,
+   // one thread at a time pops.
+   //
+   // Messages are copied into fixed-size slots. A message takes as many
+   // consecutive slots as it needs, claimed with a single CAS on the tail.
+   class [[nodiscard]] LogQueue
+   {
+   public:
+      // Message bytes per slot.
+      static constexpr size_t kSlotBytes = 240;
+
+      // Longer messages are cut.
+      static constexpr size_t kMaxSlotsPerMessage = 64;
+      static constexpr size_t kMaxMessageBytes =
+         kMaxSlotsPerMessage * kSlotBytes;
+
+      // 'slots' is rounded up to a power of 2, and to kMaxSlotsPerMessage.
+      explicit LogQueue(size_t slots);
+      ~LogQueue();
+
+      TDD_DISABLE_COPY_MOVE(LogQueue);
+
+      // false if there is no room for 'msg' right now. A message that is
+      // cut keeps its line break.
+      [[nodiscard]] bool TryPush(std::string_view msg) noexcept;
+
+      // Appends the queued messages to 'out' in order. Stops at the first
+      // message still being copied in. Returns the number of messages
+      // popped.
+      size_t PopAll(std::string& out);
+
+      // Nothing to pop.
+      [[nodiscard]] bool Empty() const noexcept;
+
+      // Slots claimed but not popped yet. Only a hint while other threads
+      // push or pop.
+      [[nodiscard]] size_t Used() const noexcept;
+      [[nodiscard]] size_t Capacity() const noexcept;
+
+   private:
+      struct Slot;
+
+      [[nodiscard]] Slot& At(uint64_t position) const noexcept;
+
+      const uint64_t m_mask;
+      const std::unique_ptr<Slot[]> m_slots;
+
+      // Producers and the consumer each get a cache line.
+      alignas(64) std::atomic<uint64_t> m_tail;
+      alignas(64) std::atomic<uint64_t> m_head;
+   };
+
+}
\ No newline at end of file
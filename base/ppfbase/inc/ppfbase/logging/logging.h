@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ppfbase/diagnostics/assert.h>
+#include <ppfbase/logging/archive_policy.h>
 #include <ppfbase/logging/log_msg.h>
 #include <ppfbase/logging/sharing_mode.h>
 #include <ppfbase/stdext/stream_operator.h>
@@ -16,12 +17,20 @@ namespace tdd::base::logging {
 
    void SetMinLogLevel(Severity severity) noexcept;
    Severity GetMinLogLevel() noexcept;
+
+   // How the log is rotated and its archives pruned. Applies to the open log
+   // and the ones opened later. kDefaultArchivePolicy until set.
+   void SetArchivePolicy(const ArchivePolicy& policy);
 }
 
 #define TDD_LOG_LEVEL(l) tdd::base::logging::Severity::l
 
 #define TDD_LOG_EX(level) \
-   tdd::base::logging::LogMsg(__FILE__, __LINE__, __func__, TDD_LOG_LEVEL(level))
+   tdd::base::logging::LogMsg( \
+      tdd::base::logging::details::SourceFileName(__FILE__), \
+      __LINE__, \
+      __func__, \
+      TDD_LOG_LEVEL(level))
 
 #define TDD_LOG_IS_ON(level) \
    (TDD_LOG_LEVEL(level) >= tdd::base::logging::GetMinLogLevel())
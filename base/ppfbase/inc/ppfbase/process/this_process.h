@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 
 namespace tdd::base::process::ThisProcess {
    const std::filesystem::path& ImagePath();
    const std::filesystem::path& Name();
+
+   [[nodiscard]] uint32_t Id() noexcept;
+   [[nodiscard]] uint32_t CurrentThreadId() noexcept;
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+
+// C11 Annex K. The CRT provides it on Windows, glibc doesn't.
+inline int memcpy_s(
+   void* dest,
+   const size_t destSize,
+   const void* src,
+   const size_t count) noexcept
+{
+   if (count == 0) {
+      return 0;
+   }
+
+   if (nullptr == dest) {
+      return EINVAL;
+   }
+
+   if (nullptr == src || count > destSize) {
+      std::memset(dest, 0, destSize);
+      return nullptr == src ? EINVAL : ERANGE;
+   }
+
+   std::memcpy(dest, src, count);
+   return 0;
+}
+#endif
\ No newline at end of file
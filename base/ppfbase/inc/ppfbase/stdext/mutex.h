@@ -6,19 +6,29 @@
 
 #include <string>
 
+#ifndef _WIN32
+#include <mutex>
+#endif
+
 namespace tdd::stdext {
    // Multi-process mutex
    class [[nodiscard]] mp_mutex
    {
    public:
+#ifdef _WIN32
       using native_handle_type = void*;
+#else
+      // File descriptor of the lock file.
+      using native_handle_type = int;
+#endif
 
       mp_mutex(std::wstring_view name);
       mp_mutex(std::wstring&& name);
       ~mp_mutex() noexcept;
 
-      TDD_DEFAULT_MOVE(mp_mutex);
+      TDD_DISABLE_COPY_MOVE(mp_mutex);
 
+      // Throws std::system_error if the mutex can't be taken.
       void lock();
       [[nodiscard]] bool try_lock();
       void unlock();
@@ -30,7 +40,10 @@ namespace tdd::stdext {
    private:
       std::wstring m_name;
       native_handle_type m_hMutex;
-
-      TDD_DISABLE_COPY(mp_mutex);
+#ifndef _WIN32
+      // flock() only keeps other processes out. Threads of this one queue up
+      // here first.
+      std::mutex m_threadLock;
+#endif
    };
 }
\ No newline at end of file
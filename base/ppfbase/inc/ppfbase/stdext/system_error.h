@@ -1,12 +1,23 @@
 #pragma once
 
+#include <cstdint>
 #include <system_error>
 
 namespace tdd::stdext {
+#ifdef _WIN32
    inline [[nodiscard]] std::error_code make_win32_ec(uint32_t err) noexcept
    {
       return std::error_code(err, std::system_category());
    }
+#else
+   // Win32 error codes mean something else to the POSIX system category.
+   [[nodiscard]] const std::error_category& win32_category() noexcept;
+
+   [[nodiscard]] inline std::error_code make_win32_ec(uint32_t err) noexcept
+   {
+      return std::error_code(static_cast<int>(err), win32_category());
+   }
+#endif
 
    [[nodiscard]] std::error_code make_last_error() noexcept;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+// The Win32 error codes the portable code reports through make_win32_ec(),
+// with their Win32 values, so the same failure compares equal everywhere.
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_INVALID_DATA 13L
+#define ERROR_WRITE_FAULT 29L
+#define ERROR_READ_FAULT 30L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_ALREADY_EXISTS 183L
+#define ERROR_FILE_NOT_SUPPORTED 425L
+#define ERROR_NOT_FOUND 1168L
+#define ERROR_FILE_INVALID 1006L
+#define E_FAIL 0x80004005L
+#endif
\ No newline at end of file
@@ -1,23 +1,277 @@
 #include <ppfbase/algorithm/crc32.h>
 
+#include <cstring>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TDD_CRC32_FOLDING 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TDD_TARGET_PCLMUL
+#else
+#include <cpuid.h>
+#define TDD_TARGET_PCLMUL __attribute__((target("pclmul")))
+#endif
+#else
+#define TDD_CRC32_FOLDING 0
+#endif
+
 namespace tdd::base::algorithm::crc32 {
 
+namespace {
+   [[nodiscard]] constexpr uint32_t ToInitValue(
+      const InitialValue init) noexcept
+   {
+      return init == InitialValue::Zero ? 0 : 0xFFFF'FFFF;
+   }
+
+   [[nodiscard]] uint32_t Update(
+      uint32_t crc,
+      std::span<const uint8_t> block,
+      const LookupTable& table) noexcept
+   {
+      for (const auto c : block) {
+         crc = (crc >> 8) ^ table[(crc ^ c) & 0xFF];
+      }
+      return crc;
+   }
+
+   [[nodiscard]] uint32_t LoadLe32(const uint8_t* data) noexcept
+   {
+      // Only little endian targets are supported. memcpy keeps the unaligned
+      // load well-defined and compiles down to a single mov.
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+   }
+
+   // Sarwate's algorithm extended to 'N' bytes per step. The CRC is folded
+   // into the first word, after which every byte of the step is looked up
+   // independently, so the loads can be issued in parallel.
+   template <size_t N>
+   [[nodiscard]] uint32_t UpdateSliced(
+      uint32_t crc,
+      std::span<const uint8_t> block,
+      const SlicingTable<N>& table) noexcept
+   {
+      static_assert(N % sizeof(uint32_t) == 0);
+
+      auto data = block.data();
+      auto remaining = block.size();
+
+      while (remaining >= N) {
+         uint32_t next = 0;
+         for (size_t word = 0; word < N / sizeof(uint32_t); ++word) {
+            auto value = LoadLe32(data + word * sizeof(uint32_t));
+            if (word == 0) {
+               value ^= crc;
+            }
+
+            // The first byte of the step is furthest from the end.
+            const auto slice = N - 1 - word * sizeof(uint32_t);
+            next ^= table[slice][value & 0xFF]
+               ^ table[slice - 1][(value >> 8) & 0xFF]
+               ^ table[slice - 2][(value >> 16) & 0xFF]
+               ^ table[slice - 3][value >> 24];
+         }
+
+         crc = next;
+         data += N;
+         remaining -= N;
+      }
+
+      return Update(crc, std::span(data, remaining), table[0]);
+   }
+
+#if TDD_CRC32_FOLDING
+   [[nodiscard]] bool DetectPclmul() noexcept
+   {
+      // CPUID.01H:ECX.PCLMULQDQ[bit 1]
+      static constexpr uint32_t kPclmulBit = 1u << 1;
+
+#if defined(_MSC_VER)
+      int regs[4] = {0};
+      __cpuid(regs, 1);
+      const auto ecx = static_cast<uint32_t>(regs[2]);
+#else
+      unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+      if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+         return false;
+      }
+#endif
+      return (ecx & kPclmulBit) != 0;
+   }
+
+   [[nodiscard]] TDD_TARGET_PCLMUL __m128i Load(const uint8_t* data) noexcept
+   {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+   }
+
+   [[nodiscard]] TDD_TARGET_PCLMUL __m128i Load(
+      const std::array<uint64_t, 2>& constants) noexcept
+   {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&constants));
+   }
+
+   // Multiplies both halves of 'x' with their constants, which moves them
+   // forward onto the position of 'next', and adds them to it.
+   [[nodiscard]] TDD_TARGET_PCLMUL __m128i Fold(
+      const __m128i x,
+      const __m128i constants,
+      const __m128i next) noexcept
+   {
+      const auto low = _mm_clmulepi64_si128(x, constants, 0x00);
+      const auto high = _mm_clmulepi64_si128(x, constants, 0x11);
+      return _mm_xor_si128(_mm_xor_si128(low, high), next);
+   }
+
+   // Requires at least 64 bytes. Processes whole 16 byte chunks and returns
+   // the number of bytes consumed through 'consumed'.
+   [[nodiscard]] TDD_TARGET_PCLMUL uint32_t UpdateFolded(
+      const uint32_t crc,
+      std::span<const uint8_t> block,
+      const FoldingConstants& k,
+      size_t& consumed) noexcept
+   {
+      static constexpr size_t kChunk = sizeof(__m128i);
+      static constexpr size_t kStep = 4 * kChunk;
+
+      auto data = block.data();
+      auto remaining = block.size();
+
+      auto x1 = _mm_xor_si128(Load(data), _mm_cvtsi32_si128(crc));
+      auto x2 = Load(data + kChunk);
+      auto x3 = Load(data + 2 * kChunk);
+      auto x4 = Load(data + 3 * kChunk);
+      data += kStep;
+      remaining -= kStep;
+
+      // Four independent accumulators hide the latency of the multiplier.
+      const auto fold512 = Load(k.fold512);
+      while (remaining >= kStep) {
+         x1 = Fold(x1, fold512, Load(data));
+         x2 = Fold(x2, fold512, Load(data + kChunk));
+         x3 = Fold(x3, fold512, Load(data + 2 * kChunk));
+         x4 = Fold(x4, fold512, Load(data + 3 * kChunk));
+         data += kStep;
+         remaining -= kStep;
+      }
+
+      const auto fold128 = Load(k.fold128);
+      x1 = Fold(x1, fold128, x2);
+      x1 = Fold(x1, fold128, x3);
+      x1 = Fold(x1, fold128, x4);
+
+      while (remaining >= kChunk) {
+         x1 = Fold(x1, fold128, Load(data));
+         data += kChunk;
+         remaining -= kChunk;
+      }
+
+      const auto mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+
+      // 128 bits down to 64.
+      auto x = _mm_xor_si128(
+         _mm_srli_si128(x1, 8),
+         _mm_clmulepi64_si128(x1, fold128, 0x10));
+
+      x = _mm_xor_si128(
+         _mm_srli_si128(x, 4),
+         _mm_clmulepi64_si128(_mm_and_si128(x, mask32), Load(k.fold64), 0x00));
+
+      // Barrett reduction down to 32 bits.
+      const auto barrett = Load(k.barrett);
+      auto t = _mm_clmulepi64_si128(_mm_and_si128(x, mask32), barrett, 0x10);
+      t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), barrett, 0x00);
+      x = _mm_xor_si128(x, t);
+
+      consumed = block.size() - remaining;
+      return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x, 4)));
+   }
+#endif
+
+   [[nodiscard]] uint32_t UpdateFolded(
+      uint32_t crc,
+      std::span<const uint8_t> block,
+      const FoldingTable& table) noexcept
+   {
+#if TDD_CRC32_FOLDING
+      // Below this the setup and the final reduction cost more than the
+      // table lookups they replace.
+      static constexpr size_t kMinFoldingSize = 64;
+
+      if (block.size() >= kMinFoldingSize && HasFoldingKernel()) {
+         size_t consumed = 0;
+         crc = UpdateFolded(crc, block, table.constants, consumed);
+         block = block.subspan(consumed);
+      }
+#endif
+      return UpdateSliced(crc, block, table.fallback);
+   }
+
+   template <typename Table>
+   [[nodiscard]] uint32_t Compute(
+      std::span<const uint8_t> block,
+      const Table& table,
+      const InitialValue init) noexcept
+   {
+      const auto initValue = ToInitValue(init);
+
+      // Hacker's Delight stars with '-1' and ends with '~crc'. This negation
+      // is the same as 'crc ^ -1' if we started with '-1'. XORing 0 is a nop.
+      if constexpr (std::is_same_v<Table, LookupTable>) {
+         return Update(initValue, block, table) ^ initValue;
+      }
+      else if constexpr (std::is_same_v<Table, FoldingTable>) {
+         return UpdateFolded(initValue, block, table) ^ initValue;
+      }
+      else {
+         return UpdateSliced(initValue, block, table) ^ initValue;
+      }
+   }
+}
+
 uint32_t ComputeCrc(
    std::span<const uint8_t> block,
    const LookupTable& table,
    const InitialValue init) noexcept
 {
-   const uint32_t initValue = init == InitialValue::Zero ? 0 : 0xFFFF'FFFF;
+   return Compute(block, table, init);
+}
 
-   uint32_t crc = initValue;
+uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const SlicingBy8Table& table,
+   const InitialValue init) noexcept
+{
+   return Compute(block, table, init);
+}
 
-   for (const auto c : block) {
-      crc = (crc >> 8) ^ table[(crc ^ c) & 0xFF];
-   }
+uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const SlicingBy16Table& table,
+   const InitialValue init) noexcept
+{
+   return Compute(block, table, init);
+}
 
-   // Hacker's Delight stars with '-1' and ends with '~crc'. This negation is
-   // the same as 'crc ^ -1' if we started with '-1'. XORing 0 is a nop.
-   return crc ^ initValue;
+uint32_t ComputeCrc(
+   std::span<const uint8_t> block,
+   const FoldingTable& table,
+   const InitialValue init) noexcept
+{
+   return Compute(block, table, init);
+}
+
+bool HasFoldingKernel() noexcept
+{
+#if TDD_CRC32_FOLDING
+   static const bool kHasPclmul = DetectPclmul();
+   return kHasPclmul;
+#else
+   return false;
+#endif
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <ppfbase/algorithm/mismatch.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TDD_MISMATCH_SSE2 1
+#include <emmintrin.h>
+#else
+#define TDD_MISMATCH_SSE2 0
+#endif
+
+namespace tdd::base::algorithm {
+
+namespace {
+   [[nodiscard]] uint64_t LoadLe64(const uint8_t* data) noexcept
+   {
+      // Only little endian targets are supported, the lowest differing byte
+      // is the lowest set bit.
+      uint64_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+   }
+
+#if TDD_MISMATCH_SSE2
+   [[nodiscard]] __m128i Equal(
+      const uint8_t* lhs,
+      const uint8_t* rhs,
+      const size_t offset) noexcept
+   {
+      return _mm_cmpeq_epi8(
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + offset)),
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + offset)));
+   }
+
+   // Bit 'i' is set if byte 'i' of the 64 byte block is equal.
+   [[nodiscard]] uint64_t EqualMask(
+      const __m128i e0,
+      const __m128i e1,
+      const __m128i e2,
+      const __m128i e3) noexcept
+   {
+      const auto m0 = static_cast<uint64_t>(_mm_movemask_epi8(e0) & 0xFFFF);
+      const auto m1 = static_cast<uint64_t>(_mm_movemask_epi8(e1) & 0xFFFF);
+      const auto m2 = static_cast<uint64_t>(_mm_movemask_epi8(e2) & 0xFFFF);
+      const auto m3 = static_cast<uint64_t>(_mm_movemask_epi8(e3) & 0xFFFF);
+      return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+   }
+#endif
+}
+
+size_t FindFirstMismatch(
+   std::span<const uint8_t> lhs,
+   std::span<const uint8_t> rhs) noexcept
+{
+   const auto size = std::min(lhs.size(), rhs.size());
+   const auto a = lhs.data();
+   const auto b = rhs.data();
+   size_t i = 0;
+
+#if TDD_MISMATCH_SSE2
+   // The 4 comparisons are only turned into a mask once a block differs.
+   for (; i + 64 <= size; i += 64) {
+      const auto e0 = Equal(a, b, i);
+      const auto e1 = Equal(a, b, i + 16);
+      const auto e2 = Equal(a, b, i + 32);
+      const auto e3 = Equal(a, b, i + 48);
+      const auto all =
+         _mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3));
+      if (0xFFFF != _mm_movemask_epi8(all)) {
+         return i + std::countr_zero(~EqualMask(e0, e1, e2, e3));
+      }
+   }
+#endif
+
+   for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      const auto diff = LoadLe64(a + i) ^ LoadLe64(b + i);
+      if (0 != diff) {
+         return i + std::countr_zero(diff) / 8;
+      }
+   }
+
+   for (; i < size; ++i) {
+      if (a[i] != b[i]) {
+         return i;
+      }
+   }
+   return size;
+}
+
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include <ppfbase/chrono/timestamp.h>
 
+#include "timestamp_format.h"
+
+#include <array>
 #include <chrono>
 #include <iomanip>
+#include <optional>
 #include <sstream>
 
 #include <Windows.h>
@@ -9,60 +13,48 @@
 namespace tdd::base::chrono::TimeStamp {
 
 namespace {
-   void AddProcessUptime(std::ostream& os)
+   [[nodiscard]] uint64_t ProcessUptimeMs() noexcept
    {
       static const auto kStartTime = ::GetTickCount64();
-
-      static constexpr auto kSecInMs = 1000ull;
-      static constexpr auto kMinInMs = 60 * kSecInMs;
-      static constexpr auto kHrInMs = 60 * kMinInMs;
-
-      const auto uptime = ::GetTickCount64() - kStartTime;
-      const auto ms = uptime % kSecInMs;
-      const auto sec = uptime % kMinInMs / kSecInMs;
-      const auto min = uptime % kHrInMs / kMinInMs;
-      const auto hr = uptime / kHrInMs;
-
-      os << '[' << std::setw(2) << hr
-         << ':' << std::setw(2) << min
-         << ':' << std::setw(2) << sec
-         << '.' << std::setw(3) << ms << ']';
+      return ::GetTickCount64() - kStartTime;
    }
 
-   void AddTimezoneBias(std::ostream& os)
+   [[nodiscard]] std::optional<int32_t> TimezoneBias() noexcept
    {
       TIME_ZONE_INFORMATION tz = { 0 };
       const auto res = ::GetTimeZoneInformation(&tz);
       if (TIME_ZONE_ID_INVALID == res) {
-         os << "+XX:XX";
-         return;
+         return std::nullopt;
       }
 
-      const auto bias = tz.Bias + tz.DaylightBias;
-      const auto absBias = std::abs(bias);
-      os << (bias < 0 ? '-' : '+')
-         << std::setw(2) << absBias / 60 << ':'
-         << std::setw(2) << absBias % 60;
+      return static_cast<int32_t>(tz.Bias + tz.DaylightBias);
    }
 }
 
 std::string Now()
+{
+   std::array<char, kMaxLength> buffer;
+   return std::string(buffer.data(), Now(buffer));
+}
+
+size_t Now(const std::span<char, kMaxLength> out) noexcept
 {
    SYSTEMTIME now = { 0 };
    ::GetLocalTime(&now);
-   std::ostringstream ss;
-   ss << std::setfill('0')
-      << now.wYear << '-'
-      << std::setw(2) << now.wMonth << '-'
-      << std::setw(2) << now.wDay << '@'
-      << std::setw(2) << now.wHour << ':'
-      << std::setw(2) << now.wMinute << ':'
-      << std::setw(2) << now.wSecond << '.'
-      << std::setw(3) << now.wMilliseconds;
-   AddTimezoneBias(ss);
-   AddProcessUptime(ss);
-   return ss.str();
 
+   return details::Format(
+      out,
+      {
+         .year = now.wYear,
+         .month = now.wMonth,
+         .day = now.wDay,
+         .hour = now.wHour,
+         .minute = now.wMinute,
+         .second = now.wSecond,
+         .millisecond = now.wMilliseconds,
+         .bias = TimezoneBias()
+      },
+      ProcessUptimeMs());
 }
 
 std::wstring FilenameSuffix()
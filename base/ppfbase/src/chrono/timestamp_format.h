@@ -0,0 +1,93 @@
+#pragma once
+
+#include <ppfbase/chrono/timestamp.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+
+namespace tdd::base::chrono::details {
+
+   struct [[nodiscard]] LocalTime
+   {
+      uint32_t year;
+      uint32_t month;
+      uint32_t day;
+      uint32_t hour;
+      uint32_t minute;
+      uint32_t second;
+      uint32_t millisecond;
+      // Minutes west of UTC. nullopt if unknown.
+      std::optional<int32_t> bias;
+   };
+
+   // At least 'width' digits, zero padded.
+   inline char* PutNumber(
+      char* out,
+      const uint64_t value,
+      const ptrdiff_t width) noexcept
+   {
+      char digits[20];
+      const auto end =
+         std::to_chars(std::begin(digits), std::end(digits), value).ptr;
+      const auto padding = std::max<ptrdiff_t>(0, width - (end - digits));
+      out = std::fill_n(out, padding, '0');
+      return std::copy(digits, end, out);
+   }
+
+   // "2023-09-03@12:34:56.789+01:00[00:00:01.234]"
+   inline size_t Format(
+      const std::span<char, TimeStamp::kMaxLength> out,
+      const LocalTime& time,
+      const uint64_t uptimeMs) noexcept
+   {
+      static constexpr auto kSecInMs = 1000ull;
+      static constexpr auto kMinInMs = 60 * kSecInMs;
+      static constexpr auto kHrInMs = 60 * kMinInMs;
+      static constexpr auto kMaxYear = 9999u;
+      static constexpr auto kMaxHours = 9'999'999ull;
+
+      auto it = out.data();
+      it = PutNumber(it, std::min(time.year, kMaxYear), 4);
+      *it++ = '-';
+      it = PutNumber(it, time.month, 2);
+      *it++ = '-';
+      it = PutNumber(it, time.day, 2);
+      *it++ = '@';
+      it = PutNumber(it, time.hour, 2);
+      *it++ = ':';
+      it = PutNumber(it, time.minute, 2);
+      *it++ = ':';
+      it = PutNumber(it, time.second, 2);
+      *it++ = '.';
+      it = PutNumber(it, time.millisecond, 3);
+
+      if (time.bias.has_value()) {
+         const auto bias = *time.bias;
+         const auto absBias = static_cast<uint32_t>(std::abs(bias));
+         *it++ = bias < 0 ? '-' : '+';
+         it = PutNumber(it, absBias / 60 % 100, 2);
+         *it++ = ':';
+         it = PutNumber(it, absBias % 60, 2);
+      }
+      else {
+         it = std::copy_n("+XX:XX", 6, it);
+      }
+
+      *it++ = '[';
+      it = PutNumber(it, std::min(uptimeMs / kHrInMs, kMaxHours), 2);
+      *it++ = ':';
+      it = PutNumber(it, uptimeMs % kHrInMs / kMinInMs, 2);
+      *it++ = ':';
+      it = PutNumber(it, uptimeMs % kMinInMs / kSecInMs, 2);
+      *it++ = '.';
+      it = PutNumber(it, uptimeMs % kSecInMs, 3);
+      *it++ = ']';
+
+      return static_cast<size_t>(it - out.data());
+   }
+
+}
\ No newline at end of file
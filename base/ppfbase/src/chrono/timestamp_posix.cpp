@@ -0,0 +1,89 @@
+#include <ppfbase/chrono/timestamp.h>
+
+#include "timestamp_format.h"
+
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+#include <time.h>
+
+namespace tdd::base::chrono::TimeStamp {
+
+namespace {
+   [[nodiscard]] uint64_t ProcessUptimeMs() noexcept
+   {
+      using Clock = std::chrono::steady_clock;
+      static const auto kStartTime = Clock::now();
+
+      return static_cast<uint64_t>(
+         std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - kStartTime).count());
+   }
+
+   // localtime_r() takes a lock. Logging threads convert each second once.
+   [[nodiscard]] const std::tm& LocalTime(const std::time_t seconds) noexcept
+   {
+      thread_local std::time_t t_seconds = -1;
+      thread_local std::tm t_local{};
+
+      if (seconds != t_seconds) {
+         ::localtime_r(&seconds, &t_local);
+         t_seconds = seconds;
+      }
+      return t_local;
+   }
+}
+
+std::string Now()
+{
+   std::array<char, kMaxLength> buffer;
+   return std::string(buffer.data(), Now(buffer));
+}
+
+size_t Now(const std::span<char, kMaxLength> out) noexcept
+{
+   const auto now = std::chrono::system_clock::now();
+   const auto seconds = std::chrono::system_clock::to_time_t(now);
+   const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      now.time_since_epoch()).count() % 1000;
+
+   const auto& local = LocalTime(seconds);
+
+   // tm_gmtoff is east of UTC. The Windows bias is west of it.
+   return details::Format(
+      out,
+      {
+         .year = static_cast<uint32_t>(local.tm_year + 1900),
+         .month = static_cast<uint32_t>(local.tm_mon + 1),
+         .day = static_cast<uint32_t>(local.tm_mday),
+         .hour = static_cast<uint32_t>(local.tm_hour),
+         .minute = static_cast<uint32_t>(local.tm_min),
+         .second = static_cast<uint32_t>(local.tm_sec),
+         .millisecond = static_cast<uint32_t>(ms),
+         .bias = static_cast<int32_t>(-local.tm_gmtoff / 60)
+      },
+      ProcessUptimeMs());
+}
+
+std::wstring FilenameSuffix()
+{
+   const auto now = std::chrono::system_clock::to_time_t(
+      std::chrono::system_clock::now());
+
+   std::tm tp{};
+   ::gmtime_r(&now, &tp);
+
+   std::wostringstream ss;
+   ss << std::setfill(L'0') << '.'
+      << (tp.tm_year + 1900)
+      << std::setw(2) << tp.tm_mon + 1
+      << std::setw(2) << tp.tm_mday << '-'
+      << std::setw(2) << tp.tm_hour
+      << std::setw(2) << tp.tm_min
+      << std::setw(2) << tp.tm_sec;
+   return ss.str();
+}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <ppfbase/diagnostics/debugger.h>
+
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <csignal>
+
+namespace tdd::base::diagnostics::Debugger {
+
+namespace {
+   [[nodiscard]] bool IsDebuggerPresent()
+   {
+      // A traced process has the tracer's pid here.
+      static constexpr auto kTracerPid = "TracerPid:";
+
+      std::ifstream status("/proc/self/status");
+      std::string line;
+      while (std::getline(status, line)) {
+         if (line.starts_with(kTracerPid)) {
+            return std::stoi(line.substr(std::char_traits<char>::length(
+               kTracerPid))) != 0;
+         }
+      }
+      return false;
+   }
+}
+
+void Break()
+{
+   // Like DebugBreak(), this ends the process when there is no debugger.
+   std::raise(SIGTRAP);
+}
+
+void DbgPrint(const char*)
+{
+   // There is no OutputDebugString() equivalent. The message still goes to
+   // the log.
+}
+
+void WaitForDebugger(const std::chrono::seconds waitFor)
+{
+   static constexpr std::chrono::milliseconds kInterval(50);
+
+   const auto startTime = std::chrono::steady_clock::now();
+   while (std::chrono::steady_clock::now() - startTime < waitFor) {
+      if (IsDebuggerPresent()) {
+         Break();
+         break;
+      }
+
+      std::this_thread::sleep_for(kInterval);
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <ppfbase/filesystem/append_file.h>
+
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <algorithm>
+
+#include <Windows.h>
+
+namespace tdd::base::fs {
+
+namespace {
+   // The log of every process is opened with FILE_SHARE_DELETE, so that any
+   // of them can rotate it.
+   [[nodiscard]] HANDLE OpenShared(
+      const std::filesystem::path& path,
+      const DWORD access,
+      const DWORD disposition) noexcept
+   {
+      return ::CreateFileW(
+         path.c_str(),
+         access,
+         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+         nullptr,
+         disposition,
+         FILE_ATTRIBUTE_NORMAL,
+         nullptr);
+   }
+
+   [[nodiscard]] std::optional<BY_HANDLE_FILE_INFORMATION> FileInfo(
+      const HANDLE hFile) noexcept
+   {
+      BY_HANDLE_FILE_INFORMATION info{};
+      if (!::GetFileInformationByHandle(hFile, &info)) {
+         return std::nullopt;
+      }
+      return info;
+   }
+}
+
+AppendFile::AppendFile() noexcept
+   : m_handle(INVALID_HANDLE_VALUE)
+{}
+
+AppendFile::~AppendFile() noexcept
+{
+   Close();
+}
+
+std::error_code AppendFile::Open(const std::filesystem::path& path) noexcept
+{
+   Close();
+
+   // Without FILE_WRITE_DATA, every write goes to the end of the file.
+   m_handle = OpenShared(
+      path,
+      FILE_APPEND_DATA | FILE_READ_ATTRIBUTES | SYNCHRONIZE,
+      OPEN_ALWAYS);
+   return IsOpen() ? std::error_code() : stdext::make_last_error();
+}
+
+void AppendFile::Close() noexcept
+{
+   if (IsOpen()) {
+      ::CloseHandle(m_handle);
+      m_handle = INVALID_HANDLE_VALUE;
+   }
+}
+
+bool AppendFile::IsOpen() const noexcept
+{
+   return INVALID_HANDLE_VALUE != m_handle;
+}
+
+std::error_code AppendFile::Append(std::string_view data) noexcept
+{
+   while (!data.empty()) {
+      const auto size = static_cast<DWORD>(
+         std::min<size_t>(data.size(), MAXDWORD));
+      DWORD written = 0;
+      if (!::WriteFile(m_handle, data.data(), size, &written, nullptr)) {
+         return stdext::make_last_error();
+      }
+
+      if (0 == written) {
+         return stdext::make_win32_ec(ERROR_WRITE_FAULT);
+      }
+
+      data.remove_prefix(written);
+   }
+
+   return {};
+}
+
+std::optional<AppendFile::Status> AppendFile::GetStatus() const noexcept
+{
+   FILE_STANDARD_INFO info{};
+   if (!::GetFileInformationByHandleEx(
+         m_handle,
+         FileStandardInfo,
+         &info,
+         sizeof(info))) {
+      return std::nullopt;
+   }
+
+   return Status{
+      .size = static_cast<uint64_t>(info.EndOfFile.QuadPart),
+      .deleted = info.DeletePending || 0 == info.NumberOfLinks};
+}
+
+bool AppendFile::IsAt(const std::filesystem::path& path) const noexcept
+{
+   const auto hNamed = OpenShared(path, FILE_READ_ATTRIBUTES, OPEN_EXISTING);
+   if (INVALID_HANDLE_VALUE == hNamed) {
+      return false;
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hNamed););
+
+   const auto open = FileInfo(m_handle);
+   const auto named = FileInfo(hNamed);
+   return open.has_value() && named.has_value()
+       && open->dwVolumeSerialNumber == named->dwVolumeSerialNumber
+       && open->nFileIndexHigh == named->nFileIndexHigh
+       && open->nFileIndexLow == named->nFileIndexLow;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <ppfbase/filesystem/append_file.h>
+
+#include <ppfbase/stdext/system_error.h>
+#include <ppfbase/stdext/win32_error_codes.h>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tdd::base::fs {
+
+namespace {
+   inline constexpr int kClosed = -1;
+}
+
+AppendFile::AppendFile() noexcept
+   : m_handle(kClosed)
+{}
+
+AppendFile::~AppendFile() noexcept
+{
+   Close();
+}
+
+std::error_code AppendFile::Open(const std::filesystem::path& path) noexcept
+{
+   Close();
+
+   m_handle = ::open(
+      path.c_str(),
+      O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+      0666);
+   return IsOpen() ? std::error_code() : stdext::make_last_error();
+}
+
+void AppendFile::Close() noexcept
+{
+   if (IsOpen()) {
+      ::close(m_handle);
+      m_handle = kClosed;
+   }
+}
+
+bool AppendFile::IsOpen() const noexcept
+{
+   return kClosed != m_handle;
+}
+
+std::error_code AppendFile::Append(std::string_view data) noexcept
+{
+   // O_APPEND moves to the end and writes in one step. A regular file only
+   // comes back short when it is out of space, or interrupted. The rest
+   // follows as a record of its own.
+   while (!data.empty()) {
+      const auto written = ::write(m_handle, data.data(), data.size());
+      if (written < 0) {
+         if (EINTR == errno) {
+            continue;
+         }
+         return stdext::make_last_error();
+      }
+
+      if (0 == written) {
+         return stdext::make_win32_ec(ERROR_WRITE_FAULT);
+      }
+
+      data.remove_prefix(static_cast<size_t>(written));
+   }
+
+   return {};
+}
+
+std::optional<AppendFile::Status> AppendFile::GetStatus() const noexcept
+{
+   struct stat info{};
+   if (0 != ::fstat(m_handle, &info)) {
+      return std::nullopt;
+   }
+
+   return Status{
+      .size = static_cast<uint64_t>(info.st_size),
+      .deleted = 0 == info.st_nlink};
+}
+
+bool AppendFile::IsAt(const std::filesystem::path& path) const noexcept
+{
+   struct stat open{};
+   struct stat named{};
+   return 0 == ::fstat(m_handle, &open)
+       && 0 == ::stat(path.c_str(), &named)
+       && open.st_dev == named.st_dev
+       && open.st_ino == named.st_ino;
+}
+
+}
\ No newline at end of file
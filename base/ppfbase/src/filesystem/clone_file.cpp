@@ -0,0 +1,155 @@
+#include <ppfbase/filesystem/clone_file.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <algorithm>
+
+#include <Windows.h>
+#include <winioctl.h>
+
+namespace tdd::base::fs {
+
+namespace {
+   // FSCTL_DUPLICATE_EXTENTS_TO_FILE only takes a ByteCount below 4 GiB.
+   // 1 GiB per request stays well under it and is a multiple of every ReFS
+   // cluster size.
+   static constexpr int64_t kMaxCloneChunk = 1ll << 30;
+
+   // ReFS block cloning. Both handles must be on the same ReFS volume. The
+   // ranges have to be cluster aligned, the last one may run past the end of
+   // the file.
+   [[nodiscard]] bool BlockClone(const HANDLE hSource, const HANDLE hTarget)
+   {
+      FSCTL_GET_INTEGRITY_INFORMATION_BUFFER integrity{};
+      DWORD returned = 0;
+      if (!::DeviceIoControl(
+            hSource,
+            FSCTL_GET_INTEGRITY_INFORMATION,
+            nullptr,
+            0,
+            &integrity,
+            sizeof(integrity),
+            &returned,
+            nullptr)) {
+         return false;
+      }
+
+      FILE_END_OF_FILE_INFO eof{};
+      if (!::GetFileSizeEx(hSource, &eof.EndOfFile)) {
+         return false;
+      }
+
+      FILE_BASIC_INFO basic{};
+      if (::GetFileInformationByHandleEx(
+            hSource,
+            FileBasicInfo,
+            &basic,
+            sizeof(basic))
+       && 0 != (basic.FileAttributes & FILE_ATTRIBUTE_SPARSE_FILE)) {
+         if (!::DeviceIoControl(
+               hTarget,
+               FSCTL_SET_SPARSE,
+               nullptr,
+               0,
+               nullptr,
+               0,
+               &returned,
+               nullptr)) {
+            return false;
+         }
+      }
+
+      if (!::SetFileInformationByHandle(
+            hTarget,
+            FileEndOfFileInfo,
+            &eof,
+            sizeof(eof))) {
+         return false;
+      }
+
+      const int64_t cluster = integrity.ClusterSizeInBytes;
+      const auto size = eof.EndOfFile.QuadPart;
+      for (int64_t offset = 0; offset < size; offset += kMaxCloneChunk) {
+         const auto count = std::min(kMaxCloneChunk, size - offset);
+
+         DUPLICATE_EXTENTS_DATA extents{};
+         extents.FileHandle = hSource;
+         extents.SourceFileOffset.QuadPart = offset;
+         extents.TargetFileOffset.QuadPart = offset;
+         extents.ByteCount.QuadPart = (count + cluster - 1) / cluster * cluster;
+
+         if (!::DeviceIoControl(
+               hTarget,
+               FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+               &extents,
+               sizeof(extents),
+               nullptr,
+               0,
+               &returned,
+               nullptr)) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   [[nodiscard]] bool TryBlockClone(
+      const std::filesystem::path& source,
+      const std::filesystem::path& target)
+   {
+      const auto hSource = ::CreateFileW(
+         source.c_str(),
+         GENERIC_READ,
+         FILE_SHARE_READ,
+         nullptr,
+         OPEN_EXISTING,
+         FILE_ATTRIBUTE_NORMAL,
+         nullptr);
+      if (INVALID_HANDLE_VALUE == hSource) {
+         return false;
+      }
+
+      TDD_ON_SCOPE_EXIT(::CloseHandle(hSource););
+
+      const auto hTarget = ::CreateFileW(
+         target.c_str(),
+         GENERIC_READ | GENERIC_WRITE,
+         0,
+         nullptr,
+         CREATE_ALWAYS,
+         FILE_ATTRIBUTE_NORMAL,
+         nullptr);
+      if (INVALID_HANDLE_VALUE == hTarget) {
+         return false;
+      }
+
+      TDD_ON_SCOPE_EXIT(::CloseHandle(hTarget););
+
+      return BlockClone(hSource, hTarget);
+   }
+}
+
+stdext::pm_expected<CloneMethod> CloneFile(
+   const std::filesystem::path& source,
+   const std::filesystem::path& target)
+{
+   if (TryBlockClone(source, target)) {
+      return CloneMethod::Reflink;
+   }
+
+   TDD_LOG_DEBUG() << "No block cloning for [" << target.wstring() << "]: "
+      << stdext::make_last_error();
+
+   if (!::CopyFileW(source.c_str(), target.c_str(), FALSE)) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to copy [" << source.wstring() << "] to ["
+         << target.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return CloneMethod::Copy;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <ppfbase/filesystem/clone_file.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace tdd::base::fs {
+
+namespace {
+   // Fallback for filesystems that copy_file_range() doesn't work across.
+   [[nodiscard]] bool CopyRangeByHand(
+      const int src,
+      const int dst,
+      off_t offset,
+      off_t end)
+   {
+      std::vector<char> buffer(1024 * 1024);
+      while (offset < end) {
+         const auto want = static_cast<size_t>(
+            std::min<off_t>(end - offset, buffer.size()));
+         const auto got = ::pread(src, buffer.data(), want, offset);
+         if (got <= 0) {
+            return false;
+         }
+
+         for (ssize_t written = 0; written < got;) {
+            const auto res = ::pwrite(
+               dst,
+               buffer.data() + written,
+               got - written,
+               offset + written);
+            if (res < 0) {
+               return false;
+            }
+            written += res;
+         }
+         offset += got;
+      }
+      return true;
+   }
+
+   [[nodiscard]] bool CopyRange(
+      const int src,
+      const int dst,
+      off_t offset,
+      const off_t end)
+   {
+      while (offset < end) {
+         off_t in = offset;
+         off_t out = offset;
+         const auto res = ::copy_file_range(
+            src,
+            &in,
+            dst,
+            &out,
+            static_cast<size_t>(end - offset),
+            0);
+
+         if (res > 0) {
+            offset += res;
+            continue;
+         }
+
+         if (res == 0) {
+            return false;
+         }
+
+         if (EXDEV == errno || ENOSYS == errno || EINVAL == errno
+          || EOPNOTSUPP == errno) {
+            return CopyRangeByHand(src, dst, offset, end);
+         }
+         return false;
+      }
+      return true;
+   }
+
+   // Copies the data regions of 'src' only. The holes are left to the
+   // ftruncate() that sized 'dst'.
+   [[nodiscard]] bool SparseCopy(const int src, const int dst, const off_t size)
+   {
+      for (off_t offset = 0; offset < size;) {
+         const auto data = ::lseek(src, offset, SEEK_DATA);
+         if (data < 0) {
+            // ENXIO: only a hole is left. Anything else: no hole support,
+            // the rest is data.
+            return ENXIO == errno || CopyRange(src, dst, offset, size);
+         }
+
+         auto hole = ::lseek(src, data, SEEK_HOLE);
+         if (hole < 0) {
+            hole = size;
+         }
+
+         if (!CopyRange(src, dst, data, hole)) {
+            return false;
+         }
+         offset = hole;
+      }
+      return true;
+   }
+}
+
+stdext::pm_expected<CloneMethod> CloneFile(
+   const std::filesystem::path& source,
+   const std::filesystem::path& target)
+{
+   const auto src = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+   if (src < 0) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to open [" << source.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::close(src););
+
+   struct stat info{};
+   if (0 != ::fstat(src, &info)) {
+      return stdext::make_last_error();
+   }
+
+   const auto dst = ::open(
+      target.c_str(),
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      info.st_mode & 0777);
+   if (dst < 0) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to create [" << target.wstring() << "]: "
+         << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::close(dst););
+
+#ifdef FICLONE
+   if (0 == ::ioctl(dst, FICLONE, src)) {
+      return CloneMethod::Reflink;
+   }
+   TDD_LOG_DEBUG() << "No reflink for [" << target.wstring() << "]: "
+      << stdext::make_last_error();
+#endif
+
+   if (0 != ::ftruncate(dst, info.st_size)
+    || !SparseCopy(src, dst, info.st_size)) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to copy [" << source.wstring() << "] to ["
+         << target.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return CloneMethod::Copy;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <ppfbase/filesystem/compress_file.h>
+
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <Windows.h>
+#include <winioctl.h>
+
+namespace tdd::base::fs {
+
+std::error_code CompressFile(const std::filesystem::path& path) noexcept
+{
+   // Shared like the log files, which may still be open elsewhere.
+   const auto hFile = ::CreateFileW(
+      path.c_str(),
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+   if (INVALID_HANDLE_VALUE == hFile) {
+      return stdext::make_last_error();
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hFile););
+
+   USHORT format = COMPRESSION_FORMAT_DEFAULT;
+   DWORD returned = 0;
+   if (!::DeviceIoControl(
+         hFile,
+         FSCTL_SET_COMPRESSION,
+         &format,
+         sizeof(format),
+         nullptr,
+         0,
+         &returned,
+         nullptr)) {
+      return stdext::make_last_error();
+   }
+   return {};
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include <ppfbase/filesystem/compress_file.h>
+
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/btrfs.h>
+#endif
+
+namespace tdd::base::fs {
+
+std::error_code CompressFile(const std::filesystem::path& path) noexcept
+{
+#ifdef BTRFS_IOC_DEFRAG_RANGE
+   // Defragmenting needs write access without CAP_SYS_ADMIN.
+   const auto fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+   if (fd < 0) {
+      return stdext::make_last_error();
+   }
+
+   TDD_ON_SCOPE_EXIT(::close(fd););
+
+   // A compress_type of 0 is the default of the filesystem, zlib.
+   btrfs_ioctl_defrag_range_args args{};
+   args.len = static_cast<__u64>(-1);
+   args.flags = BTRFS_DEFRAG_RANGE_COMPRESS | BTRFS_DEFRAG_RANGE_START_IO;
+
+   // ENOTTY everywhere but on btrfs.
+   if (0 != ::ioctl(fd, BTRFS_IOC_DEFRAG_RANGE, &args)) {
+      return stdext::make_last_error();
+   }
+   return {};
+#else
+   (void)path;
+   return std::make_error_code(std::errc::not_supported);
+#endif
+}
+
+}
\ No newline at end of file
@@ -11,6 +11,30 @@ namespace {
    {
       return LARGE_INTEGER{.QuadPart = pos.get()};
    }
+
+   // Completion event for the overlapped reads of the calling thread. Threads
+   // reading through the same handle can't wait on the handle itself.
+   [[nodiscard]] HANDLE ThreadReadEvent() noexcept
+   {
+      struct [[nodiscard]] Event
+      {
+         Event() noexcept
+            : hEvent(::CreateEventW(nullptr, TRUE, FALSE, nullptr))
+         {}
+
+         ~Event() noexcept
+         {
+            if (nullptr != hEvent) {
+               ::CloseHandle(hEvent);
+            }
+         }
+
+         const HANDLE hEvent;
+      };
+
+      thread_local const Event event;
+      return event.hEvent;
+   }
 }
 
 std::optional<FilePointer> GetFilePointer(const HANDLE hFile) noexcept
@@ -40,4 +64,55 @@ std::error_code Seek(const HANDLE hFile, const FilePointer pos) noexcept
    return stdext::make_last_error();
 }
 
+HANDLE ReopenForReadAt(const HANDLE hFile) noexcept
+{
+   const auto hReopened = ::ReOpenFile(
+      hFile,
+      GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      FILE_FLAG_OVERLAPPED);
+
+   if (INVALID_HANDLE_VALUE == hReopened) {
+      TDD_LOG_WARN() << "Unable to reopen file: "
+                     << stdext::make_last_error().message();
+   }
+
+   return hReopened;
+}
+
+std::error_code ReadAt(
+   const HANDLE hFile,
+   const FilePointer pos,
+   std::span<uint8_t> buffer) noexcept
+{
+   const auto offset = static_cast<uint64_t>(pos.get());
+   OVERLAPPED overlapped{};
+   overlapped.Offset = static_cast<DWORD>(offset);
+   overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+   // The low bit keeps the completion off any IO completion port the handle
+   // is associated with. The owner of the port would not expect it.
+   overlapped.hEvent = reinterpret_cast<HANDLE>(
+      reinterpret_cast<uintptr_t>(ThreadReadEvent()) | 1);
+
+   DWORD bytesRead = 0;
+   const auto success = ::ReadFile(
+      hFile,
+      buffer.data(),
+      static_cast<DWORD>(buffer.size()),
+      &bytesRead,
+      &overlapped);
+
+   if (!success
+    && (ERROR_IO_PENDING != ::GetLastError()
+     || !::GetOverlappedResult(hFile, &overlapped, &bytesRead, TRUE))) {
+      return stdext::make_last_error();
+   }
+
+   if (buffer.size() != bytesRead) {
+      return stdext::make_win32_ec(ERROR_HANDLE_EOF);
+   }
+
+   return {};
+}
+
 }
\ No newline at end of file
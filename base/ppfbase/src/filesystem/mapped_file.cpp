@@ -0,0 +1,154 @@
+#include <ppfbase/filesystem/mapped_file.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+
+#include <Windows.h>
+
+namespace tdd::base::fs {
+
+stdext::pm_expected<MappedFile> MappedFile::Open(
+   const std::filesystem::path& path)
+{
+   const auto hFile = ::CreateFileW(
+      path.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+
+   if (INVALID_HANDLE_VALUE == hFile) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to open [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hFile););
+
+   LARGE_INTEGER fileSize{0};
+   if (!::GetFileSizeEx(hFile, &fileSize)) {
+      return stdext::make_last_error();
+   }
+
+   // Empty files cannot be mapped. Anything that does not fit the address
+   // space is left to the caller's fallback.
+   if (fileSize.QuadPart == 0
+    || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX) {
+      return stdext::make_win32_ec(ERROR_FILE_INVALID);
+   }
+
+   // The view keeps the section alive, so neither handle is needed once it is
+   // mapped.
+   const auto hMapping =
+      ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+   if (NULL == hMapping) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hMapping););
+
+   const auto view = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+   if (nullptr == view) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return MappedFile(
+      static_cast<const uint8_t*>(view),
+      static_cast<size_t>(fileSize.QuadPart));
+}
+
+MappedFile::MappedFile(const uint8_t* view, const size_t size) noexcept
+   : m_view(view, Unmapper{.size = size})
+   , m_size(size)
+{}
+
+std::span<const uint8_t> MappedFile::Data() const noexcept
+{
+   return std::span(m_view.get(), m_size);
+}
+
+void MappedFile::Unmapper::operator()(const uint8_t* view) const noexcept
+{
+   ::UnmapViewOfFile(view);
+}
+
+stdext::pm_expected<WritableMappedFile> WritableMappedFile::Create(
+   const std::filesystem::path& path,
+   const size_t size)
+{
+   if (0 == size) {
+      return stdext::make_win32_ec(ERROR_INVALID_PARAMETER);
+   }
+
+   // Others may read the file while it is written.
+   const auto hFile = ::CreateFileW(
+      path.c_str(),
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr,
+      CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+
+   if (INVALID_HANDLE_VALUE == hFile) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to create [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hFile););
+
+   // Mapping more than the file holds extends it.
+   const auto size64 = static_cast<uint64_t>(size);
+   const auto hMapping = ::CreateFileMappingW(
+      hFile,
+      nullptr,
+      PAGE_READWRITE,
+      static_cast<DWORD>(size64 >> 32),
+      static_cast<DWORD>(size64),
+      nullptr);
+
+   if (NULL == hMapping) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::CloseHandle(hMapping););
+
+   const auto view = ::MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, size);
+   if (nullptr == view) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return WritableMappedFile(static_cast<uint8_t*>(view), size);
+}
+
+WritableMappedFile::WritableMappedFile(
+   uint8_t* view,
+   const size_t size) noexcept
+   : m_view(view, Unmapper{.size = size})
+   , m_size(size)
+{}
+
+std::span<uint8_t> WritableMappedFile::Data() const noexcept
+{
+   return std::span(m_view.get(), m_size);
+}
+
+void WritableMappedFile::Unmapper::operator()(uint8_t* view) const noexcept
+{
+   ::UnmapViewOfFile(view);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <ppfbase/filesystem/mapped_file.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/scope_exit.h>
+#include <ppfbase/stdext/system_error.h>
+#include <ppfbase/stdext/win32_error_codes.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tdd::base::fs {
+
+stdext::pm_expected<MappedFile> MappedFile::Open(
+   const std::filesystem::path& path)
+{
+   const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to open [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::close(fd););
+
+   struct stat info{};
+   if (0 != ::fstat(fd, &info)) {
+      return stdext::make_last_error();
+   }
+
+   // Empty files cannot be mapped. Anything that does not fit the address
+   // space is left to the caller's fallback.
+   if (info.st_size <= 0
+    || static_cast<uint64_t>(info.st_size) > SIZE_MAX) {
+      return stdext::make_win32_ec(ERROR_FILE_INVALID);
+   }
+
+   const auto size = static_cast<size_t>(info.st_size);
+
+   // The mapping keeps the file alive, so the descriptor isn't needed once
+   // it is mapped.
+   const auto view = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+   if (MAP_FAILED == view) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return MappedFile(static_cast<const uint8_t*>(view), size);
+}
+
+MappedFile::MappedFile(const uint8_t* view, const size_t size) noexcept
+   : m_view(view, Unmapper{.size = size})
+   , m_size(size)
+{}
+
+std::span<const uint8_t> MappedFile::Data() const noexcept
+{
+   return std::span(m_view.get(), m_size);
+}
+
+void MappedFile::Unmapper::operator()(const uint8_t* view) const noexcept
+{
+   ::munmap(const_cast<uint8_t*>(view), size);
+}
+
+stdext::pm_expected<WritableMappedFile> WritableMappedFile::Create(
+   const std::filesystem::path& path,
+   const size_t size)
+{
+   if (0 == size) {
+      return stdext::make_win32_ec(ERROR_INVALID_PARAMETER);
+   }
+
+   const auto fd =
+      ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd < 0) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to create [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   TDD_ON_SCOPE_EXIT(::close(fd););
+
+   if (0 != ::ftruncate(fd, static_cast<off_t>(size))) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to size [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   const auto view =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (MAP_FAILED == view) {
+      const auto ec = stdext::make_last_error();
+      TDD_LOG_WARN() << "Unable to map [" << path.wstring() << "]: " << ec;
+      return ec;
+   }
+
+   return WritableMappedFile(static_cast<uint8_t*>(view), size);
+}
+
+WritableMappedFile::WritableMappedFile(
+   uint8_t* view,
+   const size_t size) noexcept
+   : m_view(view, Unmapper{.size = size})
+   , m_size(size)
+{}
+
+std::span<uint8_t> WritableMappedFile::Data() const noexcept
+{
+   return std::span(m_view.get(), m_size);
+}
+
+void WritableMappedFile::Unmapper::operator()(uint8_t* view) const noexcept
+{
+   ::munmap(view, size);
+}
+
+}
\ No newline at end of file
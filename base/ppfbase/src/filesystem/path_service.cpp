@@ -4,8 +4,8 @@
 #include <ppfbase/process/this_module.h>
 #include <ppfbase/process/this_process.h>
 #include <ppfbase/stdext/string.h>
-
-#include <Windows.h>
+#include <ppfbase/stdext/system_error.h>
+#include <ppfbase/stdext/win32_error_codes.h>
 
 
 namespace tdd::base::fs::PathService {
@@ -21,7 +21,7 @@ std::error_code EnsureDirectoryExist(const std::filesystem::path& dir)
 {
    std::error_code ec;
    if (!dir.is_absolute()) {
-      ec.assign(ERROR_INVALID_PARAMETER, std::system_category());
+      ec = stdext::make_win32_ec(ERROR_INVALID_PARAMETER);
       return ec;
    }
 
@@ -31,7 +31,7 @@ std::error_code EnsureDirectoryExist(const std::filesystem::path& dir)
    }
 
    if (!fs::is_directory(dir)) {
-      ec.assign(ERROR_ALREADY_EXISTS, std::system_category());
+      ec = stdext::make_win32_ec(ERROR_ALREADY_EXISTS);
    }
 
    return ec;
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "async_writer.h"
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/logging/ilog.h>
+
+namespace tdd::base::logging::details {
+
+   // Queues messages for LogT, which is written to on a thread of its own.
+   template <typename LogT>
+   class [[nodiscard]] AsyncDecorator final : public ILog
+   {
+   public:
+      AsyncDecorator(
+         const std::filesystem::path& filepath,
+         const ArchivePolicy& policy)
+         : m_log(filepath, policy)
+         , m_writer(m_log)
+      {}
+
+      ~AsyncDecorator() override = default;
+
+      const std::filesystem::path& path() const noexcept override
+      {
+         return m_log.path();
+      }
+
+      void Write(const char* msg) override
+      {
+         m_writer.Write(msg);
+      }
+
+      void Flush() override
+      {
+         m_writer.Flush();
+      }
+
+      void SetArchivePolicy(const ArchivePolicy& policy) override
+      {
+         m_log.SetArchivePolicy(policy);
+      }
+
+   private:
+      LogT m_log;
+      // Goes first, writing what is left to m_log.
+      AsyncWriter m_writer;
+
+      TDD_DISABLE_COPY_MOVE(AsyncDecorator);
+   };
+
+}
\ No newline at end of file
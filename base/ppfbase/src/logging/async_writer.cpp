@@ -0,0 +1,279 @@
+#include "async_writer.h"
+
+#include <algorithm>
+#include <optional>
+#include <system_error>
+
+#ifndef _WIN32
+#include <vector>
+
+#include <pthread.h>
+#endif
+
+namespace tdd::base::logging::details {
+
+namespace {
+   using Clock = std::chrono::steady_clock;
+
+   // Long enough for the writer to finish a batch.
+   constexpr std::chrono::seconds kFlushTimeout{1};
+
+   // Set while this thread writes a batch. Whatever m_log.Write() logs
+   // itself can only be queued.
+   thread_local bool t_draining = false;
+
+#ifndef _WIN32
+   std::once_flag g_atfork;
+   std::mutex g_writersLock;
+   std::vector<AsyncWriter*> g_writers;
+#endif
+}
+
+AsyncWriter::AsyncWriter(ILog& log)
+   : m_log(log)
+   , m_queue(kQueueSlots)
+   , m_drainLock()
+   , m_batch()
+   , m_batchDeadline()
+   , m_sleepLock()
+   , m_wake()
+   , m_sleep(Sleep::Awake)
+   , m_synchronous(false)
+   , m_thread()
+{
+   m_batch.reserve(kBatchBytes);
+
+#ifndef _WIN32
+   std::call_once(g_atfork, [] {
+      pthread_atfork(&PrepareFork, &AfterForkInParent, &AfterForkInChild);
+   });
+
+   {
+      std::lock_guard l(g_writersLock);
+      g_writers.push_back(this);
+   }
+#endif
+
+   try {
+      m_thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+   }
+   catch (const std::system_error&) {
+      m_synchronous = true;
+   }
+}
+
+AsyncWriter::~AsyncWriter()
+{
+#ifndef _WIN32
+   {
+      std::lock_guard l(g_writersLock);
+      std::erase(g_writers, this);
+   }
+#endif
+
+   if (m_thread.joinable()) {
+      m_thread.request_stop();
+      m_thread.join();
+   }
+
+   std::lock_guard l(m_drainLock);
+   Drain(true);
+}
+
+void AsyncWriter::Write(const char* msg)
+{
+   const std::string_view text(msg);
+
+   if (t_draining) {
+      // Dropped if there is no room. Draining from here would recurse.
+      (void)m_queue.TryPush(text);
+      return;
+   }
+
+   while (!m_queue.TryPush(text)) {
+      // The writer is behind, or gone. Write the backlog here.
+      if (m_drainLock.try_lock()) {
+         std::lock_guard l(m_drainLock, std::adopt_lock);
+         Drain(true);
+      }
+      else {
+         std::this_thread::yield();
+      }
+   }
+
+   if (m_synchronous.load(std::memory_order_relaxed)) {
+      std::lock_guard l(m_drainLock);
+      Drain(true);
+      return;
+   }
+
+   Wake();
+}
+
+void AsyncWriter::Flush()
+{
+   if (t_draining) {
+      return;
+   }
+
+   const auto giveUp = Clock::now() + kFlushTimeout;
+   while (!m_drainLock.try_lock()) {
+      if (Clock::now() >= giveUp) {
+         return;
+      }
+      std::this_thread::yield();
+   }
+
+   std::lock_guard l(m_drainLock, std::adopt_lock);
+   Drain(true);
+   m_log.Flush();
+}
+
+void AsyncWriter::Run(std::stop_token stop)
+{
+   while (!stop.stop_requested()) {
+      std::optional<Clock::time_point> flushBy;
+      {
+         std::lock_guard l(m_drainLock);
+         if (Drain(false)) {
+            flushBy = m_batchDeadline;
+         }
+      }
+
+      WaitForWork(stop, flushBy);
+   }
+}
+
+void AsyncWriter::WaitForWork(
+   std::stop_token& stop,
+   const std::optional<Clock::time_point>& flushBy)
+{
+   std::unique_lock l(m_sleepLock);
+
+   const auto state = flushBy.has_value() ? Sleep::Batching : Sleep::Idle;
+   m_sleep.store(state, std::memory_order_relaxed);
+
+   // Pairs with the fence in Wake(). Either this sees the message that was
+   // just pushed, or the thread that pushed it sees this asleep.
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   const auto woken = [this, state] {
+      return m_sleep.load(std::memory_order_relaxed) != state;
+   };
+
+   if (flushBy.has_value()) {
+      m_wake.wait_until(l, stop, *flushBy, woken);
+   }
+   else if (m_queue.Empty()) {
+      m_wake.wait(l, stop, woken);
+   }
+
+   m_sleep.store(Sleep::Awake, std::memory_order_relaxed);
+}
+
+void AsyncWriter::Wake()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   auto state = m_sleep.load(std::memory_order_relaxed);
+   if (state == Sleep::Awake) {
+      return;
+   }
+
+   // Let a batch fill up unless the queue is getting full.
+   if (state == Sleep::Batching &&
+      m_queue.Used() < m_queue.Capacity() / 2)
+   {
+      return;
+   }
+
+   // Only one thread gets to wake the writer.
+   if (!m_sleep.compare_exchange_strong(
+         state,
+         Sleep::Awake,
+         std::memory_order_relaxed))
+   {
+      return;
+   }
+
+   // The writer checks m_sleep with the lock held before it waits.
+   {
+      std::lock_guard l(m_sleepLock);
+   }
+   m_wake.notify_one();
+}
+
+bool AsyncWriter::Drain(const bool force)
+{
+   const auto hadBatch = !m_batch.empty();
+   const auto popped = m_queue.PopAll(m_batch);
+   if (m_batch.empty()) {
+      return false;
+   }
+
+   if (!force) {
+      const auto now = Clock::now();
+      if (!hadBatch && popped > 0) {
+         m_batchDeadline = now + kFlushInterval;
+      }
+
+      if (m_batch.size() < kBatchBytes && now < m_batchDeadline) {
+         return true;
+      }
+   }
+
+   t_draining = true;
+   try {
+      m_log.Write(m_batch.c_str());
+   }
+   catch (const std::exception&) {
+      // Nowhere to report it. The batch is lost.
+   }
+   t_draining = false;
+
+   m_batch.clear();
+   return false;
+}
+
+#ifndef _WIN32
+// The writer thread doesn't survive fork(). Keep it from holding the locks
+// while the child is made, and have the child write synchronously.
+void AsyncWriter::PrepareFork() noexcept
+{
+   g_writersLock.lock();
+   for (auto* writer : g_writers) {
+      writer->m_drainLock.lock();
+      writer->m_sleepLock.lock();
+   }
+}
+
+void AsyncWriter::AfterForkInParent() noexcept
+{
+   for (auto* writer : g_writers) {
+      writer->m_sleepLock.unlock();
+      writer->m_drainLock.unlock();
+   }
+   g_writersLock.unlock();
+}
+
+void AsyncWriter::AfterForkInChild() noexcept
+{
+   for (auto* writer : g_writers) {
+      writer->m_synchronous = true;
+
+      // Copies of what the parent still has to write.
+      writer->m_queue.PopAll(writer->m_batch);
+      writer->m_batch.clear();
+
+      // Joining a thread of the parent would never return.
+      if (writer->m_thread.joinable()) {
+         writer->m_thread.detach();
+      }
+      writer->m_sleepLock.unlock();
+      writer->m_drainLock.unlock();
+   }
+   g_writersLock.unlock();
+}
+#endif
+
+}
\ No newline at end of file
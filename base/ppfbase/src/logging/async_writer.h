@@ -0,0 +1,87 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/logging/ilog.h>
+#include <ppfbase/logging/log_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+namespace tdd::base::logging::details {
+
+   // Hands messages to 'log' on a writer thread of its own. Callers only copy
+   // the message into a LogQueue. The writer keeps collecting until it has
+   // kBatchBytes or the oldest message is kFlushInterval old, and writes
+   // them to 'log' in one go.
+   //
+   // Callers never wait on the writer. When the queue is full they write the
+   // backlog themselves. In a child process after fork(), which has no
+   // writer thread, every message is written right away.
+   class [[nodiscard]] AsyncWriter
+   {
+   public:
+      static constexpr size_t kQueueSlots = 4096;
+      static constexpr size_t kBatchBytes = 64 * 1024;
+      static constexpr std::chrono::milliseconds kFlushInterval{100};
+
+      explicit AsyncWriter(ILog& log);
+      // Writes out what is left.
+      ~AsyncWriter();
+
+      TDD_DISABLE_COPY_MOVE(AsyncWriter);
+
+      void Write(const char* msg);
+
+      // Writes out everything queued so far on the calling thread. Gives up
+      // after a while if the writer thread holds on to the log, which it
+      // does forever if the process killed it mid-write on exit.
+      void Flush();
+
+   private:
+      enum class Sleep : uint8_t
+      {
+         Awake,
+         // Waiting for more before writing what it has.
+         Batching,
+         // Nothing to write.
+         Idle
+      };
+
+      void Run(std::stop_token stop);
+      void WaitForWork(
+         std::stop_token& stop,
+         const std::optional<std::chrono::steady_clock::time_point>& flushBy);
+      void Wake();
+
+      // Requires m_drainLock. Returns true if messages are left in m_batch.
+      bool Drain(bool force);
+
+#ifndef _WIN32
+      static void PrepareFork() noexcept;
+      static void AfterForkInParent() noexcept;
+      static void AfterForkInChild() noexcept;
+#endif
+
+      ILog& m_log;
+      LogQueue m_queue;
+
+      // Held by whoever pops from m_queue and writes to m_log.
+      std::mutex m_drainLock;
+      std::string m_batch;
+      std::chrono::steady_clock::time_point m_batchDeadline;
+
+      std::mutex m_sleepLock;
+      std::condition_variable_any m_wake;
+      std::atomic<Sleep> m_sleep;
+
+      std::atomic<bool> m_synchronous;
+      std::jthread m_thread;
+   };
+
+}
\ No newline at end of file
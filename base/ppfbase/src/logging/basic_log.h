@@ -1,29 +1,33 @@
 #pragma once
 
 #include <ppfbase/logging/ilog.h>
+#include <ppfbase/logging/log_archivist.h>
 
 #include <filesystem>
-#include <fstream>
 
 namespace tdd::base::logging::details {
+   // Appends to the file 'archivist' keeps current. Safe to write from any
+   // number of threads and processes.
    class BasicLog final : public ILog
    {
    public:
       BasicLog(
          const std::filesystem::path& filepath,
-         size_t maxBytesPerFile,
-         size_t numberOfFilesToKeep);
-      ~BasicLog();
+         const ArchivePolicy& policy,
+         SharingMode sharing);
+      ~BasicLog() override = default;
 
       // ILog
-      const std::filesystem::path& path() const noexcept override { return m_file; }
+      const std::filesystem::path& path() const noexcept override
+      {
+         return m_archivist.path();
+      }
       void Write(const char* msg) override;
-   private:
-      void RotateAsRequired();
+      // Every write goes straight to the file.
+      void Flush() override {}
+      void SetArchivePolicy(const ArchivePolicy& policy) override;
 
-      const std::filesystem::directory_entry m_file;
-      const size_t m_maxBytesPerFile;
-      const size_t m_archiveSize;
-      std::ofstream m_os;
+   private:
+      LogArchivist m_archivist;
    };
 }
\ No newline at end of file
@@ -0,0 +1,580 @@
+#include <ppfbase/logging/log_archivist.h>
+
+#include <ppfbase/diagnostics/assert.h>
+#include <ppfbase/filesystem/compress_file.h>
+#include <ppfbase/logging/ilog.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace tdd::base::logging {
+
+namespace {
+   namespace stdfs = std::filesystem;
+   using Clock = std::chrono::system_clock;
+
+   // How often archives are checked for their age, when nothing else wakes
+   // the archivist.
+   constexpr std::chrono::hours kPruneInterval{1};
+
+   // YYYYMMDD-HHMMSS
+   constexpr size_t kStampLength = 15;
+
+#ifndef _WIN32
+   std::once_flag g_atfork;
+   std::mutex g_archivistsLock;
+   std::vector<LogArchivist*> g_archivists;
+#endif
+
+   struct [[nodiscard]] ArchiveFile
+   {
+      stdfs::path path;
+      std::wstring stamp;
+      // Of archives made within the same second.
+      uint64_t counter;
+      uint64_t size;
+      stdfs::file_time_type lastWrite;
+   };
+
+   [[nodiscard]] std::wstring GenerateLockName(const stdfs::path& logFile)
+   {
+      static constexpr auto kLockSuffix = L"-TddLogLock";
+      auto lockStem = logFile.stem().wstring();
+      lockStem.append(kLockSuffix);
+      return lockStem;
+   }
+
+   // UTC, so that it sorts by time.
+   [[nodiscard]] std::wstring Stamp(const Clock::time_point time)
+   {
+      const auto day = std::chrono::floor<std::chrono::days>(time);
+      const std::chrono::year_month_day date(day);
+      const std::chrono::hh_mm_ss clock(
+         std::chrono::floor<std::chrono::seconds>(time - day));
+
+      std::wostringstream ss;
+      ss << std::setfill(L'0')
+         << static_cast<int>(date.year())
+         << std::setw(2) << static_cast<unsigned>(date.month())
+         << std::setw(2) << static_cast<unsigned>(date.day()) << L'-'
+         << std::setw(2) << clock.hours().count()
+         << std::setw(2) << clock.minutes().count()
+         << std::setw(2) << clock.seconds().count();
+      return ss.str();
+   }
+
+   [[nodiscard]] Clock::time_point PeriodStart(
+      const Clock::time_point time,
+      const std::chrono::seconds interval)
+   {
+      const auto sinceEpoch =
+         std::chrono::floor<std::chrono::seconds>(time.time_since_epoch());
+      return Clock::time_point(interval * (sinceEpoch / interval));
+   }
+
+   [[nodiscard]] bool IsDigits(const std::wstring_view text)
+   {
+      return !text.empty()
+         && std::all_of(text.begin(), text.end(), [](const wchar_t c) {
+            return c >= L'0' && c <= L'9';
+         });
+   }
+
+   [[nodiscard]] uint64_t ToNumber(const std::wstring_view digits)
+   {
+      uint64_t number = 0;
+      for (const auto c : digits) {
+         number = number * 10 + static_cast<uint64_t>(c - L'0');
+      }
+      return number;
+   }
+
+   // <logStem>.<YYYYMMDD-HHMMSS>[-N].log. The logs of other processes, e.g.
+   // <logStem>.<pid>.log, don't match.
+   [[nodiscard]] std::optional<ArchiveFile> AsArchive(
+      const stdfs::directory_entry& entry,
+      const std::wstring_view logStem)
+   {
+      std::error_code ec;
+      if (!entry.is_regular_file(ec)
+       || entry.path().extension() != ILog::kExt) {
+         return std::nullopt;
+      }
+
+      const auto stem = entry.path().stem().wstring();
+      const std::wstring_view name(stem);
+      if (name.size() < logStem.size() + 1 + kStampLength
+       || !name.starts_with(logStem)
+       || name[logStem.size()] != L'.') {
+         return std::nullopt;
+      }
+
+      const auto suffix = name.substr(logStem.size() + 1);
+      const auto stamp = suffix.substr(0, kStampLength);
+      if (!IsDigits(stamp.substr(0, 8))
+       || stamp[8] != L'-'
+       || !IsDigits(stamp.substr(9))) {
+         return std::nullopt;
+      }
+
+      const auto counter = suffix.substr(kStampLength);
+      if (!counter.empty()
+       && (counter.front() != L'-' || !IsDigits(counter.substr(1)))) {
+         return std::nullopt;
+      }
+
+      ArchiveFile archive{
+         .path = entry.path(),
+         .stamp = std::wstring(stamp),
+         .counter = counter.empty() ? 0 : ToNumber(counter.substr(1)),
+         .size = entry.file_size(ec),
+         .lastWrite = {}};
+      if (!ec) {
+         archive.lastWrite = entry.last_write_time(ec);
+      }
+
+      // Pruned by another process meanwhile.
+      if (ec) {
+         return std::nullopt;
+      }
+      return archive;
+   }
+
+   // Oldest first.
+   [[nodiscard]] std::vector<ArchiveFile> EnumerateArchives(
+      const stdfs::path& logFile)
+   {
+      const auto logStem = logFile.stem().wstring();
+      std::vector<ArchiveFile> archives;
+
+      std::error_code ec;
+      for (stdfs::directory_iterator it(logFile.parent_path(), ec), end;
+         !ec && it != end;
+         it.increment(ec)) {
+         auto archive = AsArchive(*it, logStem);
+         if (archive.has_value()) {
+            archives.push_back(std::move(archive.value()));
+         }
+      }
+
+      std::sort(
+         archives.begin(),
+         archives.end(),
+         [](const ArchiveFile& lhs, const ArchiveFile& rhs) {
+            return std::tie(lhs.stamp, lhs.counter)
+               < std::tie(rhs.stamp, rhs.counter);
+         });
+      return archives;
+   }
+
+   // Archives made within the same second are counted up, so that none
+   // replaces another and they still sort in order.
+   [[nodiscard]] stdfs::path ArchiveName(
+      const stdfs::path& logFile,
+      const std::vector<ArchiveFile>& archives,
+      const std::wstring& stamp)
+   {
+      uint64_t counter = 0;
+      for (const auto& archive : archives) {
+         if (archive.stamp == stamp) {
+            counter = std::max(counter, archive.counter + 1);
+         }
+      }
+
+      for (;; ++counter) {
+         auto name = logFile.parent_path();
+         name /= logFile.stem();
+         name += L".";
+         name += stamp;
+         if (0 != counter) {
+            name += L"-";
+            name += std::to_wstring(counter);
+         }
+         name += ILog::kExt;
+
+         std::error_code ec;
+         if (!stdfs::exists(name, ec)) {
+            return name;
+         }
+      }
+   }
+}
+
+LogArchivist::LogArchivist(
+   const std::filesystem::path& logFile,
+   const ArchivePolicy& policy,
+   const SharingMode sharing)
+   : m_path(logFile)
+   , m_file()
+   , m_maxFileBytes(policy.maxFileBytes)
+   , m_rotationDue(false)
+   , m_orphaned(false)
+   , m_rotationLock()
+   , m_sharedLock()
+   , m_lock()
+   , m_wake()
+   , m_policy(policy)
+   // Prunes what earlier runs left.
+   , m_policyChanged(true)
+   , m_nextInterval()
+   , m_thread()
+{
+   TDD_ASSERT(logFile.is_absolute());
+
+   if (SharingMode::MultiProcess == sharing) {
+      m_sharedLock.emplace(GenerateLockName(logFile));
+   }
+
+   ScheduleInterval(Clock::now());
+
+#ifndef _WIN32
+   std::call_once(g_atfork, [] {
+      pthread_atfork(&PrepareFork, &AfterForkInParent, &AfterForkInChild);
+   });
+
+   {
+      std::lock_guard l(g_archivistsLock);
+      g_archivists.push_back(this);
+   }
+#endif
+
+   try {
+      m_thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+   }
+   catch (const std::system_error&) {
+      m_orphaned = true;
+   }
+}
+
+LogArchivist::~LogArchivist()
+{
+#ifndef _WIN32
+   {
+      std::lock_guard l(g_archivistsLock);
+      std::erase(g_archivists, this);
+   }
+#endif
+
+   if (m_thread.joinable()) {
+      m_thread.request_stop();
+      m_thread.join();
+   }
+}
+
+const std::filesystem::path& LogArchivist::path() const noexcept
+{
+   return m_path;
+}
+
+void LogArchivist::Append(const std::string_view msg)
+{
+   auto file = m_file.load();
+   if (nullptr == file) {
+      file = Reopen(file);
+   }
+
+   // One fstat per batch. The size has to include the appends of other
+   // processes, and it is the only way to see the file pruned under us.
+   auto ec = file->Append(msg);
+   auto status = file->GetStatus();
+
+   // An idle process may still hold an archive another process has pruned
+   // since.
+   if (!ec && status.has_value() && status->deleted) {
+      file = Reopen(file);
+      ec = file->Append(msg);
+      status = file->GetStatus();
+   }
+
+   // Reopened on the next write.
+   if (ec) {
+      m_file.compare_exchange_strong(file, nullptr);
+      throw std::system_error(ec, "Unable to write the log");
+   }
+
+   const auto maxBytes = m_maxFileBytes.load(std::memory_order_relaxed);
+   if (0 == maxBytes || !status.has_value() || status->size < maxBytes) {
+      return;
+   }
+
+   if (m_orphaned.load(std::memory_order_relaxed)) {
+      if (!file->IsAt(m_path)) {
+         (void)Reopen(file);
+      }
+      return;
+   }
+
+   // Only the first writer to see it due wakes the archivist.
+   if (!m_rotationDue.exchange(true)) {
+      Wake();
+   }
+}
+
+void LogArchivist::SetPolicy(const ArchivePolicy& policy)
+{
+   m_maxFileBytes = policy.maxFileBytes;
+   {
+      std::lock_guard l(m_lock);
+      m_policy = policy;
+      m_policyChanged = true;
+      ScheduleInterval(Clock::now());
+   }
+   m_wake.notify_one();
+}
+
+void LogArchivist::Rotate()
+{
+   ArchivePolicy policy;
+   {
+      std::lock_guard l(m_lock);
+      policy = m_policy;
+   }
+
+   Archive(Trigger::Request, policy);
+   Prune(policy);
+}
+
+void LogArchivist::Run(std::stop_token stop)
+{
+   while (!stop.stop_requested()) {
+      std::optional<Trigger> trigger;
+      ArchivePolicy policy;
+      {
+         std::unique_lock l(m_lock);
+
+         auto wakeBy = m_nextInterval;
+         if (m_policy.maxArchiveAge.count() > 0) {
+            const auto prune = Clock::now() + kPruneInterval;
+            wakeBy = std::min(wakeBy.value_or(prune), prune);
+         }
+
+         const auto woken = [this] {
+            return m_policyChanged || m_rotationDue.load();
+         };
+
+         if (wakeBy.has_value()) {
+            m_wake.wait_until(l, stop, *wakeBy, woken);
+         }
+         else {
+            m_wake.wait(l, stop, woken);
+         }
+
+         if (stop.stop_requested()) {
+            return;
+         }
+
+         const auto now = Clock::now();
+         if (m_rotationDue.exchange(false)) {
+            trigger = Trigger::Size;
+         }
+
+         if (m_nextInterval.has_value() && now >= *m_nextInterval) {
+            trigger = Trigger::Interval;
+            ScheduleInterval(now);
+         }
+
+         m_policyChanged = false;
+         policy = m_policy;
+      }
+
+      if (trigger.has_value()) {
+         Archive(*trigger, policy);
+      }
+      Prune(policy);
+   }
+}
+
+void LogArchivist::Wake()
+{
+   // The archivist checks m_rotationDue with the lock held before it waits.
+   {
+      std::lock_guard l(m_lock);
+   }
+   m_wake.notify_one();
+}
+
+void LogArchivist::Archive(const Trigger trigger, const ArchivePolicy& policy)
+{
+   const auto archive = RotateFile(trigger, policy);
+   if (archive.has_value() && policy.compress) {
+      // Not every filesystem can. The archive stays as it is then.
+      (void)fs::CompressFile(*archive);
+   }
+}
+
+std::optional<std::filesystem::path> LogArchivist::RotateFile(
+   const Trigger trigger,
+   const ArchivePolicy& policy)
+{
+   std::lock_guard threads(m_rotationLock);
+   std::unique_lock<stdext::mp_mutex> processes;
+   if (m_sharedLock.has_value()) {
+      // Renaming the file under the other processes could lose their
+      // rotations. Left for the next trigger.
+      try {
+         processes = std::unique_lock(*m_sharedLock);
+      }
+      catch (const std::system_error&) {
+         return std::nullopt;
+      }
+   }
+
+   auto file = m_file.load();
+
+   try {
+      // Another process archived it already. Follow it to the new file.
+      if (nullptr != file && !file->IsAt(m_path)) {
+         (void)Reopen(file);
+         return std::nullopt;
+      }
+   }
+   catch (const std::system_error&) {
+      return std::nullopt;
+   }
+
+   std::error_code ec;
+   const auto size = stdfs::file_size(m_path, ec);
+   if (ec || 0 == size) {
+      return std::nullopt;
+   }
+
+   const auto archives = EnumerateArchives(m_path);
+   const auto now = Clock::now();
+
+   if (Trigger::Size == trigger) {
+      const auto maxBytes = m_maxFileBytes.load(std::memory_order_relaxed);
+      if (0 == maxBytes || size < maxBytes) {
+         return std::nullopt;
+      }
+   }
+   else if (Trigger::Interval == trigger) {
+      // Every process sharing the file wakes up for the same interval. Only
+      // the first one archives it.
+      const auto periodStart = PeriodStart(now, policy.rotationInterval);
+      if (!archives.empty() && archives.back().stamp >= Stamp(periodStart)) {
+         return std::nullopt;
+      }
+   }
+
+   const auto archive = ArchiveName(m_path, archives, Stamp(now));
+   stdfs::rename(m_path, archive, ec);
+   if (ec) {
+      return std::nullopt;
+   }
+
+   // New appends go to the new file. Those already under way land in the
+   // archive.
+   try {
+      (void)Reopen(file);
+   }
+   catch (const std::system_error&) {
+      // Writers open it themselves.
+      m_file.compare_exchange_strong(file, nullptr);
+   }
+   return archive;
+}
+
+void LogArchivist::Prune(const ArchivePolicy& policy) const
+{
+   const auto archives = EnumerateArchives(m_path);
+
+   auto count = archives.size();
+   uint64_t total = 0;
+   for (const auto& archive : archives) {
+      total += archive.size;
+   }
+
+   const auto now = stdfs::file_time_type::clock::now();
+   for (const auto& archive : archives) {
+      const auto tooMany =
+         0 != policy.maxArchives && count > policy.maxArchives;
+      const auto tooBig =
+         0 != policy.maxArchiveBytes && total > policy.maxArchiveBytes;
+      const auto tooOld = policy.maxArchiveAge.count() > 0
+         && now - archive.lastWrite > policy.maxArchiveAge;
+      if (!tooMany && !tooBig && !tooOld) {
+         continue;
+      }
+
+      // Another process sharing the log may have pruned it already.
+      std::error_code ec;
+      stdfs::remove(archive.path, ec);
+      --count;
+      total -= archive.size;
+   }
+}
+
+LogArchivist::FilePtr LogArchivist::Reopen(FilePtr stale)
+{
+   auto fresh = std::make_shared<fs::AppendFile>();
+   const auto ec = fresh->Open(m_path);
+   if (ec) {
+      throw std::system_error(ec, "Unable to open the log");
+   }
+
+   while (!m_file.compare_exchange_strong(stale, fresh)) {
+      if (nullptr != stale) {
+         return stale;
+      }
+   }
+   return fresh;
+}
+
+void LogArchivist::ScheduleInterval(const Clock::time_point now)
+{
+   const auto interval = m_policy.rotationInterval;
+   if (interval.count() <= 0) {
+      m_nextInterval.reset();
+      return;
+   }
+
+   m_nextInterval = PeriodStart(now, interval) + interval;
+}
+
+#ifndef _WIN32
+// The archivist thread doesn't survive fork(). Keep it from holding the locks
+// while the child is made, and have the child follow its parent's rotations.
+void LogArchivist::PrepareFork() noexcept
+{
+   g_archivistsLock.lock();
+   for (auto* archivist : g_archivists) {
+      archivist->m_rotationLock.lock();
+      archivist->m_lock.lock();
+   }
+}
+
+void LogArchivist::AfterForkInParent() noexcept
+{
+   for (auto* archivist : g_archivists) {
+      archivist->m_lock.unlock();
+      archivist->m_rotationLock.unlock();
+   }
+   g_archivistsLock.unlock();
+}
+
+void LogArchivist::AfterForkInChild() noexcept
+{
+   for (auto* archivist : g_archivists) {
+      archivist->m_orphaned = true;
+
+      // Joining a thread of the parent would never return.
+      if (archivist->m_thread.joinable()) {
+         archivist->m_thread.detach();
+      }
+      archivist->m_lock.unlock();
+      archivist->m_rotationLock.unlock();
+   }
+   g_archivistsLock.unlock();
+}
+#endif
+
+}
\ No newline at end of file
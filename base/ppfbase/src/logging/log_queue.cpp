@@ -0,0 +1,149 @@
+#include <ppfbase/logging/log_queue.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace tdd::base::logging {
+
+// The sequence of a slot is its position while it is free for that position,
+// and the position + 1 once a message starting there is published. Only the
+// first slot of a message is published. The rest are covered by its release
+// store and freed together with it.
+struct alignas(64) LogQueue::Slot
+{
+   std::atomic<uint64_t> sequence;
+   // Bytes of the whole message. Only set on its first slot.
+   uint32_t size;
+   char data[kSlotBytes];
+};
+
+namespace {
+   [[nodiscard]] constexpr size_t SlotsFor(const size_t bytes) noexcept
+   {
+      return std::max<size_t>(
+         1,
+         (bytes + LogQueue::kSlotBytes - 1) / LogQueue::kSlotBytes);
+   }
+}
+
+LogQueue::LogQueue(const size_t slots)
+   : m_mask(std::bit_ceil(std::max(slots, kMaxSlotsPerMessage)) - 1)
+   , m_slots(std::make_unique<Slot[]>(m_mask + 1))
+   , m_tail(0)
+   , m_head(0)
+{
+   static_assert(sizeof(Slot) == 256);
+
+   for (uint64_t i = 0; i <= m_mask; ++i) {
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+   }
+}
+
+LogQueue::~LogQueue() = default;
+
+bool LogQueue::TryPush(const std::string_view msg) noexcept
+{
+   const auto size = std::min(msg.size(), kMaxMessageBytes);
+   const auto count = SlotsFor(size);
+
+   // The consumer frees slots in order. If the last slot is free for this
+   // round, so are the ones before it.
+   auto position = m_tail.load(std::memory_order_relaxed);
+   for (;;) {
+      const auto last = position + count - 1;
+      const auto sequence = At(last).sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<int64_t>(sequence - last);
+      if (diff == 0) {
+         if (m_tail.compare_exchange_weak(
+               position,
+               position + count,
+               std::memory_order_relaxed))
+         {
+            break;
+         }
+      }
+      else if (diff < 0) {
+         return false;
+      }
+      else {
+         position = m_tail.load(std::memory_order_relaxed);
+      }
+   }
+
+   auto left = msg.substr(0, size);
+   for (size_t i = 0; i < count; ++i) {
+      const auto bytes = std::min(left.size(), kSlotBytes);
+      std::memcpy(At(position + i).data, left.data(), bytes);
+      left.remove_prefix(bytes);
+   }
+
+   if (size < msg.size() && msg.back() == '\n') {
+      const auto lastByte = size - 1;
+      At(position + lastByte / kSlotBytes).data[lastByte % kSlotBytes] = '\n';
+   }
+
+   auto& first = At(position);
+   first.size = static_cast<uint32_t>(size);
+   first.sequence.store(position + 1, std::memory_order_release);
+   return true;
+}
+
+size_t LogQueue::PopAll(std::string& out)
+{
+   size_t popped = 0;
+   auto position = m_head.load(std::memory_order_relaxed);
+   for (;;) {
+      auto& first = At(position);
+      if (first.sequence.load(std::memory_order_acquire) != position + 1) {
+         break;
+      }
+
+      const size_t size = first.size;
+      const auto count = SlotsFor(size);
+      for (size_t i = 0; i < count; ++i) {
+         const auto bytes = std::min(size - i * kSlotBytes, kSlotBytes);
+         out.append(At(position + i).data, bytes);
+      }
+
+      // Free the slots for the next round in order, so that a producer
+      // never sees the last slot of its claim free before the first one.
+      for (size_t i = 0; i < count; ++i) {
+         At(position + i).sequence.store(
+            position + i + m_mask + 1,
+            std::memory_order_release);
+      }
+
+      position += count;
+      m_head.store(position, std::memory_order_relaxed);
+      ++popped;
+   }
+   return popped;
+}
+
+bool LogQueue::Empty() const noexcept
+{
+   const auto position = m_head.load(std::memory_order_relaxed);
+   return At(position).sequence.load(std::memory_order_acquire) !=
+      position + 1;
+}
+
+size_t LogQueue::Used() const noexcept
+{
+   // Only a hint. The two may be read from different moments.
+   const auto head = m_head.load(std::memory_order_relaxed);
+   const auto tail = m_tail.load(std::memory_order_relaxed);
+   return static_cast<size_t>(tail - std::min(head, tail));
+}
+
+size_t LogQueue::Capacity() const noexcept
+{
+   return m_mask + 1;
+}
+
+LogQueue::Slot& LogQueue::At(const uint64_t position) const noexcept
+{
+   return m_slots[position & m_mask];
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "log_stream.h"
+
+#include <ppfbase/chrono/timestamp.h>
+#include <ppfbase/process/this_process.h>
+#include <ppfbase/stdext/string.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace tdd::base::logging::details {
+
+namespace {
+   static constexpr size_t kInitialBytes = 1024;
+   // A thread that logged something huge once gives the memory back.
+   static constexpr size_t kMaxKeptBytes = 64 * 1024;
+
+   // Bumped in the child after fork(), where the ids are different.
+   std::atomic<uint32_t> g_forks = 0;
+
+   struct Pool
+   {
+      std::vector<std::unique_ptr<LogStream>> streams;
+      size_t used = 0;
+
+      ~Pool();
+   };
+
+   // Stays readable after t_pool is gone, e.g. when a thread_local
+   // destructor logs after it.
+   thread_local bool t_poolGone = false;
+   thread_local Pool t_pool;
+
+   Pool::~Pool()
+   {
+      t_poolGone = true;
+   }
+
+   // At least 'width' digits, zero padded.
+   char* PutNumber(char* out, const uint32_t value, const ptrdiff_t width)
+   {
+      char digits[10];
+      const auto end =
+         std::to_chars(std::begin(digits), std::end(digits), value).ptr;
+      const auto padding = std::max<ptrdiff_t>(0, width - (end - digits));
+      out = std::fill_n(out, padding, '0');
+      return std::copy(digits, end, out);
+   }
+
+   [[nodiscard]] const std::string& ProcessName()
+   {
+      static const auto kName =
+         stdext::WideToUtf8(process::ThisProcess::Name().wstring());
+      return kName;
+   }
+
+   // "P01234T01240"
+   [[nodiscard]] std::string_view PidTidTag()
+   {
+#ifndef _WIN32
+      [[maybe_unused]] static const auto kForkHandler = pthread_atfork(
+         nullptr,
+         nullptr,
+         [] { g_forks.fetch_add(1, std::memory_order_relaxed); });
+#endif
+
+      struct Tag
+      {
+         bool valid = false;
+         uint32_t forks = 0;
+         size_t size = 0;
+         std::array<char, 24> text;
+      };
+      thread_local Tag t_tag;
+
+      const auto forks = g_forks.load(std::memory_order_relaxed);
+      if (!t_tag.valid || t_tag.forks != forks) {
+         auto it = t_tag.text.data();
+         *it++ = 'P';
+         it = PutNumber(it, process::ThisProcess::Id(), 5);
+         *it++ = 'T';
+         it = PutNumber(it, process::ThisProcess::CurrentThreadId(), 5);
+
+         t_tag.valid = true;
+         t_tag.forks = forks;
+         t_tag.size = static_cast<size_t>(it - t_tag.text.data());
+      }
+      return std::string_view(t_tag.text.data(), t_tag.size);
+   }
+
+   // Right aligned in 4 columns.
+   [[nodiscard]] std::string_view SeverityLabel(
+      const Severity severity,
+      std::array<char, 8>& buffer) noexcept
+   {
+      const auto level = static_cast<int>(severity);
+      if (level < 0) {
+         buffer = {' ', ' ', 'V', '_'};
+         const auto end = std::to_chars(
+            buffer.data() + 4,
+            buffer.data() + buffer.size(),
+            -level).ptr;
+         const auto size = static_cast<size_t>(end - buffer.data());
+         const auto skip = std::min<size_t>(2, size - 4);
+         return std::string_view(buffer.data() + skip, size - skip);
+      }
+
+      switch (severity) {
+      case Severity::Debug:
+         return " DBG";
+      case Severity::Info:
+         return "INFO";
+      case Severity::Warning:
+         return "WARN";
+      case Severity::Error:
+         return " ERR";
+      case Severity::Fatal:
+         return "FATL";
+      default:
+         return " UNK";
+      }
+   }
+}
+
+LogStream::LogStream()
+   : std::streambuf()
+   , std::ostream(this)
+   , m_buffer(kInitialBytes, '\0')
+{
+   // One byte is kept back for End()'s terminating null.
+   setp(m_buffer.data(), m_buffer.data() + m_buffer.size() - 1);
+}
+
+LogStream::~LogStream() = default;
+
+LogStream& LogStream::Acquire()
+{
+   if (t_poolGone) {
+      return *new LogStream();
+   }
+
+   auto& pool = t_pool;
+   if (pool.used == pool.streams.size()) {
+      pool.streams.push_back(std::make_unique<LogStream>());
+   }
+   return *pool.streams[pool.used++];
+}
+
+void LogStream::Release(LogStream& stream) noexcept
+{
+   if (t_poolGone) {
+      delete &stream;
+      return;
+   }
+
+   --t_pool.used;
+}
+
+void LogStream::Begin(
+   const char* file,
+   const int line,
+   const char* func,
+   const Severity severity)
+{
+   if (m_buffer.size() > kMaxKeptBytes) {
+      m_buffer.resize(kInitialBytes);
+      m_buffer.shrink_to_fit();
+   }
+   setp(m_buffer.data(), m_buffer.data() + m_buffer.size() - 1);
+
+   // A fresh ostringstream used to be made for every message.
+   clear();
+   flags(std::ios_base::skipws | std::ios_base::dec);
+   width(0);
+   precision(6);
+   fill(' ');
+
+   std::array<char, chrono::TimeStamp::kMaxLength> time;
+   Append(std::string_view(time.data(), chrono::TimeStamp::Now(time)));
+   Append(" ");
+   Append(PidTidTag());
+   Append(" ");
+
+   std::array<char, 8> label;
+   Append(SeverityLabel(severity, label));
+   Append(" ");
+   Append(ProcessName());
+   Append(" ");
+   Append(file);
+   Append("<");
+
+   std::array<char, 12> number;
+   const auto end =
+      std::to_chars(number.data(), number.data() + number.size(), line).ptr;
+   Append(std::string_view(number.data(), end));
+   Append(">:");
+   Append(func);
+   Append("(): ");
+}
+
+const char* LogStream::End()
+{
+   Append("\n");
+   *pptr() = '\0';
+   return pbase();
+}
+
+std::string_view LogStream::View() const noexcept
+{
+   return std::string_view(pbase(), pptr());
+}
+
+LogStream::int_type LogStream::overflow(const int_type ch)
+{
+   if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+   }
+
+   const auto c = traits_type::to_char_type(ch);
+   Append(std::string_view(&c, 1));
+   return ch;
+}
+
+std::streamsize LogStream::xsputn(const char* s, const std::streamsize count)
+{
+   Append(std::string_view(s, static_cast<size_t>(count)));
+   return count;
+}
+
+void LogStream::Append(const std::string_view text)
+{
+   if (static_cast<size_t>(epptr() - pptr()) < text.size()) {
+      Grow(text.size());
+   }
+
+   std::memcpy(pptr(), text.data(), text.size());
+   pbump(static_cast<int>(text.size()));
+}
+
+void LogStream::Grow(const size_t atLeast)
+{
+   const auto used = static_cast<size_t>(pptr() - pbase());
+   m_buffer.resize(std::max(m_buffer.size() * 2, used + atLeast + 1));
+   setp(m_buffer.data(), m_buffer.data() + m_buffer.size() - 1);
+   pbump(static_cast<int>(used));
+}
+
+}
\ No newline at end of file
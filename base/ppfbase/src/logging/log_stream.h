@@ -0,0 +1,60 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/logging/severity.h>
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace tdd::base::logging::details {
+
+   // Formats one message at a time into a buffer that is kept for the next
+   // one. Each thread keeps one per level of nested logging, so formatting a
+   // message allocates nothing once the thread logged a few.
+   class [[nodiscard]] LogStream final
+      : private std::streambuf
+      , public std::ostream
+   {
+   public:
+      LogStream();
+      ~LogStream() override;
+
+      TDD_DISABLE_COPY_MOVE(LogStream);
+
+      // A free stream of the calling thread. Released by the matching
+      // Release(), in reverse order.
+      [[nodiscard]] static LogStream& Acquire();
+      static void Release(LogStream& stream) noexcept;
+
+      // Drops the previous message, resets the formatting flags and writes
+      // the prefix of a new one.
+      void Begin(
+         const char* file,
+         int line,
+         const char* func,
+         Severity severity);
+
+      // Ends the message with a line break. The returned string is valid
+      // until the next Begin().
+      [[nodiscard]] const char* End();
+
+      // The message so far.
+      [[nodiscard]] std::string_view View() const noexcept;
+
+   private:
+      // Both bases have these.
+      using int_type = std::streambuf::int_type;
+      using traits_type = std::streambuf::traits_type;
+
+      int_type overflow(int_type ch) override;
+      std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+      void Append(std::string_view text);
+      void Grow(size_t atLeast);
+
+      std::string m_buffer;
+   };
+
+}
\ No newline at end of file
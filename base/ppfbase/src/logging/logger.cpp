@@ -1,5 +1,6 @@
 #include "logger.h"
 
+#include "async_log.h"
 #include "multi_process_log.h"
 #include "single_process_log.h"
 
@@ -10,32 +11,50 @@
 #include <ppfbase/process/this_process.h>
 
 #include <atomic>
+#include <cstdlib>
 #include <memory>
-
-#include <Windows.h>
+#include <mutex>
 
 namespace tdd::base::logging::details::Logger {
 
 namespace {
-   // 10mb
-   static constexpr size_t kBytesPerFile = 10 * 1024 * 1024;
-   static constexpr size_t kFilesToKeep = 10;
-
    std::atomic<Severity> g_severity = Severity::Info;
    std::atomic<ILog*> g_log = nullptr;
 
+   // For the logs opened from now on. The open one is told itself.
+   std::mutex g_policyLock;
+   ArchivePolicy g_policy = kDefaultArchivePolicy;
+
+   // The log is never destroyed, so that static destructors can still log.
+   // Whatever they log goes straight to the file.
+   std::atomic<bool> g_exiting = false;
+   std::once_flag g_flushAtExit;
+
+   void FlushAtExit()
+   {
+      g_exiting = true;
+      Flush();
+   }
+
    template <typename LogT>
    void InitLog(const std::filesystem::path& logPath)
    {
+      ArchivePolicy policy;
+      {
+         std::lock_guard l(g_policyLock);
+         policy = g_policy;
+      }
+
       try {
-         g_log = std::make_unique<LogT>(
+         g_log = std::make_unique<AsyncDecorator<LogT>>(
             logPath,
-            kBytesPerFile,
-            kFilesToKeep).release();
+            policy).release();
       }
       catch (const std::exception&) {
          g_log = std::make_unique<NullLog>().release();
       }
+
+      std::call_once(g_flushAtExit, [] { std::atexit(&FlushAtExit); });
    }
 }
 
@@ -73,7 +92,7 @@ void InitDllLog()
    std::wostringstream logFileName;
    logFileName << process::ThisModule::Name().stem().wstring() << "."
       << process::ThisProcess::Name().stem().wstring() << "."
-      << ::GetCurrentProcessId() << ILog::kExt;
+      << process::ThisProcess::Id() << ILog::kExt;
 
    const auto logPath = logDir.value() / logFileName.str();
    InitLog<SingleProcessLog>(logPath);
@@ -101,10 +120,38 @@ Severity GetMinLogLevel() noexcept
    return g_severity.load();
 }
 
+void SetArchivePolicy(const ArchivePolicy& policy)
+{
+   std::lock_guard l(g_policyLock);
+   g_policy = policy;
+
+   const auto log = g_log.load();
+   if (log != nullptr) {
+      log->SetArchivePolicy(policy);
+   }
+}
+
 void Write(const char* msg)
 {
    diagnostics::Debugger::DbgPrint(msg);
-   g_log.load()->Write(msg);
+
+   // Nothing to write to before one of the Init functions ran, e.g. in tests.
+   const auto log = g_log.load();
+   if (log != nullptr) {
+      log->Write(msg);
+
+      if (g_exiting.load(std::memory_order_relaxed)) {
+         log->Flush();
+      }
+   }
+}
+
+void Flush()
+{
+   const auto log = g_log.load();
+   if (log != nullptr) {
+      log->Flush();
+   }
 }
 
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ppfbase/logging/archive_policy.h>
 #include <ppfbase/logging/severity.h>
 #include <ppfbase/logging/sharing_mode.h>
 
@@ -15,5 +16,8 @@ namespace tdd::base::logging::details::Logger {
    void SetMinLogLevel(Severity severity) noexcept;
    Severity GetMinLogLevel() noexcept;
 
+   void SetArchivePolicy(const ArchivePolicy& policy);
+
    void Write(const char* msg);
+   void Flush();
 }
\ No newline at end of file
@@ -28,4 +28,9 @@ namespace tdd::base::logging {
    {
       return details::Logger::GetMinLogLevel();
    }
+
+   void SetArchivePolicy(const ArchivePolicy& policy)
+   {
+      details::Logger::SetArchivePolicy(policy);
+   }
 }
\ No newline at end of file
@@ -4,30 +4,23 @@
 
 #include <ppfbase/preprocessor_utils.h>
 #include <ppfbase/logging/ilog.h>
-#include <ppfbase/stdext/mutex.h>
 
 #include <mutex>
 
 namespace tdd::base::logging::details {
 
-   inline std::wstring GenerateLockName(const std::filesystem::path& logFile)
-   {
-      static constexpr auto kLockSuffix = L"-TddLogLock";
-      auto lockStem = logFile.stem().wstring();
-      lockStem.append(kLockSuffix);
-      return lockStem;
-   }
-
+   // Every process appends to the shared file on its own. A batch of lines
+   // lands in one piece, so lines of different processes never interleave.
+   // The archivists of the processes take a named mutex to rotate the file.
    template <typename LogT>
    class [[nodiscard]] MultiProcessDecorator final : public ILog
    {
    public:
       MultiProcessDecorator(
          const std::filesystem::path& filepath,
-         size_t maxBytesPerFile,
-         size_t numberOfFilesToKeep)
-         : m_lock(GenerateLockName(filepath))
-         , m_log(filepath, maxBytesPerFile, numberOfFilesToKeep)
+         const ArchivePolicy& policy)
+         : m_threadLock()
+         , m_log(filepath, policy, SharingMode::MultiProcess)
       {}
 
       ~MultiProcessDecorator() override = default;
@@ -39,12 +32,24 @@ namespace tdd::base::logging::details {
 
       void Write(const char* msg) override
       {
-         std::lock_guard l(m_lock);
+         std::lock_guard l(m_threadLock);
          m_log.Write(msg);
       }
 
+      void Flush() override
+      {
+         std::lock_guard l(m_threadLock);
+         m_log.Flush();
+      }
+
+      void SetArchivePolicy(const ArchivePolicy& policy) override
+      {
+         m_log.SetArchivePolicy(policy);
+      }
+
    private:
-      stdext::mp_mutex m_lock;
+      // Only keeps the threads of this process apart.
+      std::mutex m_threadLock;
       LogT m_log;
 
       TDD_DISABLE_COPY_MOVE(MultiProcessDecorator);
@@ -15,10 +15,9 @@ namespace tdd::base::logging::details {
    public:
       SingleProcessDecorator(
          const std::filesystem::path& filepath,
-         size_t maxBytesPerFile,
-         size_t numberOfFilesToKeep)
+         const ArchivePolicy& policy)
          : m_lock()
-         , m_log(filepath, maxBytesPerFile, numberOfFilesToKeep)
+         , m_log(filepath, policy, SharingMode::SingleProcess)
       {}
 
       ~SingleProcessDecorator() override = default;
@@ -34,6 +33,17 @@ namespace tdd::base::logging::details {
          m_log.Write(msg);
       }
 
+      void Flush() override
+      {
+         std::lock_guard l(m_lock);
+         m_log.Flush();
+      }
+
+      void SetArchivePolicy(const ArchivePolicy& policy) override
+      {
+         m_log.SetArchivePolicy(policy);
+      }
+
    private:
       std::mutex m_lock;
       LogT m_log;
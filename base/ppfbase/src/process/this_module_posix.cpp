@@ -0,0 +1,45 @@
+#include <ppfbase/process/this_module.h>
+
+#include <ppfbase/diagnostics/assert.h>
+
+#include <dlfcn.h>
+
+namespace tdd::base::process::ThisModule {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   fs::path ThisModulePath()
+   {
+      Dl_info info{};
+      if (0 == ::dladdr(reinterpret_cast<void*>(&ThisModulePath), &info)
+       || nullptr == info.dli_fname) {
+         TDD_DASSERT(false && "Unable to get module path");
+         return "";
+      }
+
+      // The main executable reports the name it was started with, which
+      // may be relative.
+      std::error_code ec;
+      auto path = fs::canonical(info.dli_fname, ec);
+      if (ec) {
+         return info.dli_fname;
+      }
+
+      return path;
+   }
+}
+
+const fs::path& ImagePath()
+{
+   static const auto kPath = ThisModulePath();
+   return kPath;
+}
+
+const fs::path& Name()
+{
+   static const auto kName = ImagePath().filename();
+   return kName;
+}
+
+}
\ No newline at end of file
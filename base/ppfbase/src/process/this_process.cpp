@@ -34,4 +34,14 @@ const fs::path& Name()
    return kName;
 }
 
+uint32_t Id() noexcept
+{
+   return ::GetCurrentProcessId();
+}
+
+uint32_t CurrentThreadId() noexcept
+{
+   return ::GetCurrentThreadId();
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <ppfbase/process/this_process.h>
+
+#include <system_error>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace tdd::base::process::ThisProcess {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   fs::path GetImagePath()
+   {
+      std::error_code ec;
+      auto path = fs::read_symlink("/proc/self/exe", ec);
+      if (ec) {
+         return "";
+      }
+
+      return path;
+   }
+}
+
+const fs::path& ImagePath()
+{
+   static const auto kPath = GetImagePath();
+   return kPath;
+}
+
+const fs::path& Name()
+{
+   static const auto kName = ImagePath().filename();
+   return kName;
+}
+
+uint32_t Id() noexcept
+{
+   return static_cast<uint32_t>(::getpid());
+}
+
+uint32_t CurrentThreadId() noexcept
+{
+   return static_cast<uint32_t>(::syscall(SYS_gettid));
+}
+
+}
\ No newline at end of file
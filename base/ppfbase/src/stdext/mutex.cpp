@@ -2,6 +2,10 @@
 
 #include <ppfbase/diagnostics/assert.h>
 
+#include <ppfbase/stdext/string.h>
+
+#include <system_error>
+
 #include <Windows.h>
 
 namespace tdd::stdext {
@@ -36,7 +40,12 @@ mp_mutex::~mp_mutex() noexcept
 
 void mp_mutex::lock()
 {
-   ::WaitForSingleObject(m_hMutex, INFINITE);
+   // An abandoned mutex is taken all the same.
+   if (WAIT_FAILED == ::WaitForSingleObject(m_hMutex, INFINITE)) {
+      throw std::system_error(
+         make_last_error(),
+         "Unable to lock " + WideToUtf8(m_name));
+   }
 }
 
 bool mp_mutex::try_lock()
@@ -0,0 +1,94 @@
+#include <ppfbase/stdext/mutex.h>
+
+#include <ppfbase/diagnostics/assert.h>
+#include <ppfbase/stdext/string.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace tdd::stdext {
+
+namespace {
+   // Named mutexes become lock files in the temp directory. The kernel drops
+   // the lock when its holder dies, like an abandoned Windows mutex.
+   [[nodiscard]] int MakeMutex(const std::wstring& name)
+   {
+      auto lockFile = std::filesystem::temp_directory_path();
+      lockFile /= WideToUtf8(name) + ".lock";
+
+      return ::open(lockFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+   }
+}
+
+mp_mutex::mp_mutex(std::wstring_view name)
+   : mp_mutex(std::wstring(name))
+{}
+
+mp_mutex::mp_mutex(std::wstring&& name)
+   : m_name(std::move(name))
+   , m_hMutex(MakeMutex(m_name))
+   , m_threadLock()
+{
+   if (m_hMutex < 0) {
+      throw std::runtime_error(make_last_error().message());
+   }
+}
+
+mp_mutex::~mp_mutex() noexcept
+{
+   ::close(m_hMutex);
+}
+
+void mp_mutex::lock()
+{
+   m_threadLock.lock();
+
+   int result = 0;
+   do {
+      result = ::flock(m_hMutex, LOCK_EX);
+   } while (0 != result && EINTR == errno);
+
+   if (0 != result) {
+      const auto ec = make_last_error();
+      m_threadLock.unlock();
+      throw std::system_error(ec, "Unable to lock " + WideToUtf8(m_name));
+   }
+}
+
+bool mp_mutex::try_lock()
+{
+   if (!m_threadLock.try_lock()) {
+      return false;
+   }
+
+   if (0 == ::flock(m_hMutex, LOCK_EX | LOCK_NB)) {
+      return true;
+   }
+
+   m_threadLock.unlock();
+   return false;
+}
+
+void mp_mutex::unlock()
+{
+   TDD_ASSERT(0 == ::flock(m_hMutex, LOCK_UN));
+   m_threadLock.unlock();
+}
+
+mp_mutex::native_handle_type mp_mutex::native_handle() const noexcept
+{
+   return m_hMutex;
+}
+
+std::wstring_view mp_mutex::name() const noexcept
+{
+   return m_name;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <ppfbase/stdext/string.h>
+
+#include <cstdint>
+
+namespace tdd::stdext {
+
+namespace {
+   // wchar_t holds whole code points here, so the conversion is plain UTF-8
+   // encoding and decoding. Invalid input becomes U+FFFD, like it does with
+   // the Win32 conversion functions.
+   static_assert(sizeof(wchar_t) == 4);
+
+   static constexpr char32_t kReplacement = 0xFFFD;
+
+   [[nodiscard]] bool IsValidCodePoint(const char32_t cp) noexcept
+   {
+      return cp <= 0x10FFFF && (cp < 0xD800 || cp > 0xDFFF);
+   }
+
+   void AppendUtf8(std::string& out, char32_t cp)
+   {
+      if (!IsValidCodePoint(cp)) {
+         cp = kReplacement;
+      }
+
+      if (cp < 0x80) {
+         out.push_back(static_cast<char>(cp));
+      }
+      else if (cp < 0x800) {
+         out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+         out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+      }
+      else if (cp < 0x10000) {
+         out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+         out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+         out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+      }
+      else {
+         out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+         out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+         out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+         out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+      }
+   }
+
+   // Decodes the code point starting at 'pos' and moves 'pos' past it.
+   [[nodiscard]] char32_t NextCodePoint(const std::string& src, size_t& pos)
+   {
+      const auto lead = static_cast<uint8_t>(src[pos++]);
+      if (lead < 0x80) {
+         return lead;
+      }
+
+      size_t trailing = 0;
+      char32_t cp = 0;
+      char32_t min = 0;
+      if ((lead & 0xE0) == 0xC0) {
+         trailing = 1;
+         cp = lead & 0x1F;
+         min = 0x80;
+      }
+      else if ((lead & 0xF0) == 0xE0) {
+         trailing = 2;
+         cp = lead & 0x0F;
+         min = 0x800;
+      }
+      else if ((lead & 0xF8) == 0xF0) {
+         trailing = 3;
+         cp = lead & 0x07;
+         min = 0x10000;
+      }
+      else {
+         return kReplacement;
+      }
+
+      for (; trailing > 0; --trailing) {
+         if (pos == src.size()) {
+            return kReplacement;
+         }
+
+         const auto next = static_cast<uint8_t>(src[pos]);
+         if ((next & 0xC0) != 0x80) {
+            return kReplacement;
+         }
+
+         cp = (cp << 6) | (next & 0x3F);
+         ++pos;
+      }
+
+      // Overlong encodings are as invalid as surrogates.
+      if (cp < min || !IsValidCodePoint(cp)) {
+         return kReplacement;
+      }
+      return cp;
+   }
+}
+
+std::string WideToUtf8(const std::wstring& src)
+{
+   std::string utf8;
+   utf8.reserve(src.size());
+   for (const auto c : src) {
+      AppendUtf8(utf8, static_cast<char32_t>(c));
+   }
+   return utf8;
+}
+
+std::wstring Utf8ToWide(const std::string& src)
+{
+   std::wstring wide;
+   wide.reserve(src.size());
+   for (size_t pos = 0; pos < src.size();) {
+      wide.push_back(static_cast<wchar_t>(NextCodePoint(src, pos)));
+   }
+   return wide;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <ppfbase/stdext/system_error.h>
+
+#include <cerrno>
+#include <string>
+
+namespace tdd::stdext {
+
+namespace {
+   class Win32Category final : public std::error_category
+   {
+   public:
+      const char* name() const noexcept override
+      {
+         return "win32";
+      }
+
+      std::string message(int err) const override
+      {
+         return "Win32 error " + std::to_string(err);
+      }
+   };
+}
+
+const std::error_category& win32_category() noexcept
+{
+   static const Win32Category kCategory;
+   return kCategory;
+}
+
+std::error_code make_last_error() noexcept
+{
+   return std::error_code(errno, std::system_category());
+}
+
+}
\ No newline at end of file
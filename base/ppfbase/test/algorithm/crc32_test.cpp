@@ -2,6 +2,7 @@
 
 #include <doctest/doctest.h>
 
+#include <numeric>
 #include <string>
 
 namespace tdd::base::algorithm::crc32 {
@@ -30,6 +31,20 @@ namespace {
 
    static constexpr auto kCdTable = CompileLookupTable(polynomials::kCdRom);
 
+   static constexpr auto kDefaultTable8 =
+      CompileSlicingTable<8>(polynomials::kDefault);
+   static constexpr auto kCdTable8 =
+      CompileSlicingTable<8>(polynomials::kCdRom);
+
+   static constexpr auto kDefaultTable16 =
+      CompileSlicingTable<16>(polynomials::kDefault);
+   static constexpr auto kCdTable16 =
+      CompileSlicingTable<16>(polynomials::kCdRom);
+
+   static constexpr auto kDefaultFolding =
+      CompileFoldingTable(polynomials::kDefault);
+   static constexpr auto kCdFolding = CompileFoldingTable(polynomials::kCdRom);
+
    // Test value provided by https://simplycalc.com/crc32-text.php
    static const std::string kTestData("123456789abcdefg");
    static constexpr uint32_t kExpectedDefaultCrc = 0xA2CA'AFFF;
@@ -40,6 +55,8 @@ TEST_CASE("Crc32: Generate correct lookup table")
 {
    const auto zlibTable = ZlibCrcTable();
    CHECK(zlibTable == kDefaultTable);
+   CHECK(zlibTable == kDefaultTable8[0]);
+   CHECK(zlibTable == kDefaultTable16[0]);
 }
 
 TEST_CASE("Crc32: Produces expected CRC-32 checksum")
@@ -52,12 +69,107 @@ TEST_CASE("Crc32: Produces expected CRC-32 checksum")
    {
       const auto crc = ComputeCrc(block, kDefaultTable, InitialValue::MinusOne);
       CHECK(kExpectedDefaultCrc == crc);
+
+      CHECK(kExpectedDefaultCrc
+         == ComputeCrc(block, kDefaultTable8, InitialValue::MinusOne));
+      CHECK(kExpectedDefaultCrc
+         == ComputeCrc(block, kDefaultTable16, InitialValue::MinusOne));
+      CHECK(kExpectedDefaultCrc
+         == ComputeCrc(block, kDefaultFolding, InitialValue::MinusOne));
    }
 
    SUBCASE("CD-ROM polynomial")
    {
       const auto crc = ComputeCrc(block, kCdTable, InitialValue::MinusOne);
       CHECK(kExpectedCdRomCrc == crc);
+
+      CHECK(kExpectedCdRomCrc
+         == ComputeCrc(block, kCdTable8, InitialValue::MinusOne));
+      CHECK(kExpectedCdRomCrc
+         == ComputeCrc(block, kCdTable16, InitialValue::MinusOne));
+      CHECK(kExpectedCdRomCrc
+         == ComputeCrc(block, kCdFolding, InitialValue::MinusOne));
+   }
+}
+
+TEST_CASE("Crc32: Slicing matches the byte-wise calculation")
+{
+   std::array<uint8_t, 2352> data;
+   std::iota(data.begin(), data.end(), static_cast<uint8_t>(0x5A));
+
+   // Every length up to a few steps past the widest slice, at every offset
+   // within a step, so both the main loop and the tail are covered.
+   for (size_t offset = 0; offset < 16; ++offset) {
+      for (size_t length = 0; length < 64; ++length) {
+         const auto block =
+            std::span<const uint8_t>(data).subspan(offset, length);
+
+         for (const auto init : {InitialValue::Zero, InitialValue::MinusOne}) {
+            const auto expected = ComputeCrc(block, kDefaultTable, init);
+            REQUIRE(expected == ComputeCrc(block, kDefaultTable8, init));
+            REQUIRE(expected == ComputeCrc(block, kDefaultTable16, init));
+
+            const auto expectedCd = ComputeCrc(block, kCdTable, init);
+            REQUIRE(expectedCd == ComputeCrc(block, kCdTable8, init));
+            REQUIRE(expectedCd == ComputeCrc(block, kCdTable16, init));
+         }
+      }
+   }
+
+   // EDC block sizes
+   for (const size_t length : {2056, 2064, 2332}) {
+      const auto block = std::span<const uint8_t>(data).first(length);
+      const auto expected = ComputeCrc(block, kCdTable, InitialValue::Zero);
+      CHECK(expected == ComputeCrc(block, kCdTable8, InitialValue::Zero));
+      CHECK(expected == ComputeCrc(block, kCdTable16, InitialValue::Zero));
+   }
+}
+
+TEST_CASE("Crc32: Generate correct folding constants")
+{
+   // Published constants for CRC-32, e.g. zlib's crc32_simd.c
+   CHECK(0x0154442bd4 == kDefaultFolding.constants.fold512[0]);
+   CHECK(0x01c6e41596 == kDefaultFolding.constants.fold512[1]);
+   CHECK(0x01751997d0 == kDefaultFolding.constants.fold128[0]);
+   CHECK(0x00ccaa009e == kDefaultFolding.constants.fold128[1]);
+   CHECK(0x0163cd6124 == kDefaultFolding.constants.fold64[0]);
+   CHECK(0x01db710641 == kDefaultFolding.constants.barrett[0]);
+   CHECK(0x01f7011641 == kDefaultFolding.constants.barrett[1]);
+
+   CHECK(kDefaultTable8 == kDefaultFolding.fallback);
+   CHECK(kCdTable8 == kCdFolding.fallback);
+}
+
+TEST_CASE("Crc32: Folding matches the byte-wise calculation")
+{
+   MESSAGE("Folding kernel available: " << HasFoldingKernel());
+
+   std::array<uint8_t, 4096> data;
+   for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<uint8_t>(i * 131 + (i >> 8));
+   }
+
+   // Lengths around every branch of the kernel: too short to fold, exactly
+   // one step, trailing 16 byte chunks and a trailing partial chunk.
+   for (size_t offset = 0; offset < 16; ++offset) {
+      for (size_t length = 0; length < 300; ++length) {
+         const auto block =
+            std::span<const uint8_t>(data).subspan(offset, length);
+
+         for (const auto init : {InitialValue::Zero, InitialValue::MinusOne}) {
+            REQUIRE(ComputeCrc(block, kDefaultTable, init)
+               == ComputeCrc(block, kDefaultFolding, init));
+            REQUIRE(ComputeCrc(block, kCdTable, init)
+               == ComputeCrc(block, kCdFolding, init));
+         }
+      }
+   }
+
+   // EDC block sizes
+   for (const size_t length : {2056, 2064, 2332, 4096}) {
+      const auto block = std::span<const uint8_t>(data).first(length);
+      CHECK(ComputeCrc(block, kCdTable, InitialValue::Zero)
+         == ComputeCrc(block, kCdFolding, InitialValue::Zero));
    }
 }
 
@@ -0,0 +1,87 @@
+#include <ppfbase/algorithm/mismatch.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace tdd::base::algorithm {
+
+TEST_CASE("FindFirstMismatch: finds every single differing byte")
+{
+   std::vector<uint8_t> lhs(300);
+   std::iota(lhs.begin(), lhs.end(), uint8_t(0));
+
+   // Every size around the 64 and 8 byte steps and every position.
+   for (size_t size = 0; size < lhs.size(); ++size) {
+      const auto a = std::span<const uint8_t>(lhs).first(size);
+      auto rhs = lhs;
+      CHECK(FindFirstMismatch(a, std::span(rhs).first(size)) == size);
+
+      for (size_t pos = 0; pos < size; ++pos) {
+         rhs = lhs;
+         rhs[pos] ^= 0x80;
+         CAPTURE(size);
+         CAPTURE(pos);
+         REQUIRE(FindFirstMismatch(a, std::span(rhs).first(size)) == pos);
+      }
+   }
+}
+
+TEST_CASE("FindFirstMismatch: reports the first of several")
+{
+   std::vector<uint8_t> lhs(256, 0);
+   auto rhs = lhs;
+   rhs[200] = 1;
+   rhs[70] = 1;
+   rhs[71] = 1;
+   CHECK(FindFirstMismatch(lhs, rhs) == 70);
+}
+
+TEST_CASE("FindFirstMismatch: stops at the shorter input")
+{
+   const std::vector<uint8_t> lhs(100, 7);
+   const std::vector<uint8_t> rhs(90, 7);
+   CHECK(FindFirstMismatch(lhs, rhs) == 90);
+   CHECK(FindFirstMismatch(rhs, lhs) == 90);
+}
+
+TEST_CASE("FindFirstMismatch: benchmark" * doctest::skip())
+{
+   static constexpr size_t kSize = 64 * 1024 * 1024;
+   static constexpr int kRounds = 10;
+
+   std::vector<uint8_t> lhs(kSize);
+   std::iota(lhs.begin(), lhs.end(), uint8_t(0));
+   auto rhs = lhs;
+   rhs.back() ^= 1;
+
+   const auto measure = [](const std::string& name, auto&& find) {
+      size_t found = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kRounds; ++i) {
+         found += find();
+      }
+      const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::steady_clock::now() - start);
+      MESSAGE(name << ": " << ms.count() << " ms, " << found / kRounds);
+   };
+
+   measure("std::mismatch", [&] {
+      return static_cast<size_t>(
+         std::mismatch(lhs.begin(), lhs.end(), rhs.begin()).first -
+         lhs.begin());
+   });
+   // Called through a volatile pointer, or the loop is folded into one call.
+   int (*volatile cmp)(const void*, const void*, size_t) = &std::memcmp;
+   measure("memcmp", [&] {
+      return static_cast<size_t>(cmp(lhs.data(), rhs.data(), kSize));
+   });
+   measure("FindFirstMismatch", [&] { return FindFirstMismatch(lhs, rhs); });
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <ppfbase/filesystem/append_file.h>
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace tdd::base::fs {
+
+namespace {
+   namespace stdfs = std::filesystem;
+
+   struct [[nodiscard]] TempFile
+   {
+      explicit TempFile(const char* name)
+         : path(stdfs::temp_directory_path() / name)
+      {
+         std::error_code ec;
+         stdfs::remove(path, ec);
+      }
+
+      ~TempFile()
+      {
+         std::error_code ec;
+         stdfs::remove(path, ec);
+      }
+
+      stdfs::path path;
+   };
+
+   // Lines of different lengths, so that a torn append shows.
+   [[nodiscard]] std::string Record(const size_t writer, const size_t n)
+   {
+      auto line = std::to_string(writer) + ":" + std::to_string(n) + ":";
+      line.append(n % 500, static_cast<char>('a' + writer));
+      line += '\n';
+      return line;
+   }
+
+   // No checks in here, it runs in forked children too.
+   [[nodiscard]] bool AppendRecords(
+      const stdfs::path& path,
+      const size_t writer,
+      const size_t count)
+   {
+      AppendFile file;
+      if (file.Open(path)) {
+         return false;
+      }
+
+      for (size_t n = 0; n < count; ++n) {
+         if (file.Append(Record(writer, n))) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // Every record appears once and whole.
+   void CheckRecords(
+      const stdfs::path& path,
+      const size_t writers,
+      const size_t count)
+   {
+      std::set<std::string> expected;
+      for (size_t w = 0; w < writers; ++w) {
+         for (size_t n = 0; n < count; ++n) {
+            expected.insert(Record(w, n));
+         }
+      }
+
+      std::ifstream is(path, std::ifstream::binary);
+      std::string line;
+      size_t lines = 0;
+      while (std::getline(is, line)) {
+         ++lines;
+         CHECK(1 == expected.erase(line + '\n'));
+      }
+
+      CHECK(writers * count == lines);
+      CHECK(expected.empty());
+   }
+}
+
+TEST_CASE("AppendFile")
+{
+   TempFile temp("ppfbase_append_file.log");
+
+   AppendFile file;
+   CHECK_FALSE(file.IsOpen());
+   REQUIRE(!file.Open(temp.path));
+   CHECK(file.IsOpen());
+
+   SUBCASE("Appends at the end")
+   {
+      {
+         std::ofstream os(temp.path, std::ofstream::binary);
+         os << "first\n";
+      }
+
+      CHECK(!file.Append("second\n"));
+
+      const auto status = file.GetStatus();
+      REQUIRE(status.has_value());
+      CHECK(13 == status->size);
+      CHECK_FALSE(status->deleted);
+      CHECK(file.IsAt(temp.path));
+   }
+
+   SUBCASE("Notices the file was renamed")
+   {
+      TempFile archive("ppfbase_append_file.1.log");
+      stdfs::rename(temp.path, archive.path);
+      CHECK_FALSE(file.IsAt(temp.path));
+      CHECK(file.IsAt(archive.path));
+   }
+
+   SUBCASE("Notices the file was deleted")
+   {
+      stdfs::remove(temp.path);
+      CHECK_FALSE(file.IsAt(temp.path));
+
+      const auto status = file.GetStatus();
+      REQUIRE(status.has_value());
+      CHECK(status->deleted);
+   }
+
+   file.Close();
+   CHECK_FALSE(file.IsOpen());
+}
+
+TEST_CASE("AppendFile: concurrent appends don't interleave")
+{
+   static constexpr size_t kWriters = 4;
+   static constexpr size_t kRecords = 5000;
+
+   TempFile temp("ppfbase_append_file_mt.log");
+
+   SUBCASE("Threads")
+   {
+      std::vector<char> done(kWriters, false);
+      {
+         std::vector<std::jthread> writers;
+         for (size_t w = 0; w < kWriters; ++w) {
+            writers.emplace_back([&temp, &done, w] {
+               done[w] = AppendRecords(temp.path, w, kRecords);
+            });
+         }
+      }
+
+      CHECK(std::vector<char>(kWriters, true) == done);
+      CheckRecords(temp.path, kWriters, kRecords);
+   }
+
+#ifndef _WIN32
+   SUBCASE("Processes")
+   {
+      std::vector<pid_t> children;
+      for (size_t w = 0; w < kWriters; ++w) {
+         const auto pid = ::fork();
+         REQUIRE(pid >= 0);
+         if (0 == pid) {
+            ::_exit(AppendRecords(temp.path, w, kRecords) ? 0 : 1);
+         }
+         children.push_back(pid);
+      }
+
+      for (const auto pid : children) {
+         int status = 0;
+         CHECK(pid == ::waitpid(pid, &status, 0));
+         CHECK(WIFEXITED(status));
+         CHECK(0 == WEXITSTATUS(status));
+      }
+
+      CheckRecords(temp.path, kWriters, kRecords);
+   }
+#endif
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include <ppfbase/filesystem/clone_file.h>
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+namespace tdd::base::fs {
+
+namespace {
+   namespace stdfs = std::filesystem;
+
+   [[nodiscard]] std::vector<char> Read(const stdfs::path& file)
+   {
+      std::ifstream is(file, std::ifstream::binary);
+      return {
+         std::istreambuf_iterator<char>(is),
+         std::istreambuf_iterator<char>()};
+   }
+}
+
+TEST_CASE("CloneFile")
+{
+   const auto source = stdfs::temp_directory_path() / "ppfbase_clone_src.bin";
+   const auto target = stdfs::temp_directory_path() / "ppfbase_clone_dst.bin";
+
+   // Data, a hole of a few MiB and more data.
+   std::vector<char> data(64 * 1024);
+   std::iota(data.begin(), data.end(), char(0));
+   {
+      std::ofstream os(source, std::ofstream::binary | std::ofstream::trunc);
+      os.write(data.data(), data.size());
+      os.seekp(4 * 1024 * 1024, std::ios::cur);
+      os.write(data.data(), data.size());
+   }
+
+   SUBCASE("Same content")
+   {
+      const auto res = CloneFile(source, target);
+      REQUIRE(res.has_value());
+      CHECK(Read(target) == Read(source));
+   }
+
+   SUBCASE("Replaces the target")
+   {
+      {
+         std::ofstream os(target, std::ofstream::binary | std::ofstream::trunc);
+         std::vector<char> junk(16 * 1024 * 1024, 'x');
+         os.write(junk.data(), junk.size());
+      }
+
+      REQUIRE(CloneFile(source, target).has_value());
+      CHECK(stdfs::file_size(target) == stdfs::file_size(source));
+      CHECK(Read(target) == Read(source));
+   }
+
+   SUBCASE("Missing source")
+   {
+      stdfs::remove(source);
+      CHECK_FALSE(CloneFile(source, target).has_value());
+   }
+
+   stdfs::remove(source);
+   stdfs::remove(target);
+}
+
+}
\ No newline at end of file
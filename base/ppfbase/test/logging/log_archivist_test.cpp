@@ -0,0 +1,252 @@
+#include <ppfbase/logging/log_archivist.h>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tdd::base::logging {
+
+namespace {
+   namespace stdfs = std::filesystem;
+   using namespace std::chrono_literals;
+
+   struct [[nodiscard]] TempDir
+   {
+      explicit TempDir(const char* name)
+         : path(stdfs::temp_directory_path() / name)
+      {
+         std::error_code ec;
+         stdfs::remove_all(path, ec);
+         stdfs::create_directories(path);
+      }
+
+      ~TempDir()
+      {
+         std::error_code ec;
+         stdfs::remove_all(path, ec);
+      }
+
+      stdfs::path path;
+   };
+
+   constexpr ArchivePolicy kNoLimits{
+      .maxFileBytes = 0,
+      .rotationInterval = 0s,
+      .maxArchives = 0,
+      .maxArchiveAge = 0s,
+      .maxArchiveBytes = 0,
+      .compress = false};
+
+   [[nodiscard]] std::string ReadAll(const stdfs::path& path)
+   {
+      std::ifstream is(path, std::ifstream::binary);
+      return std::string(
+         std::istreambuf_iterator<char>(is),
+         std::istreambuf_iterator<char>());
+   }
+
+   // Everything in 'dir' but 'log'.
+   [[nodiscard]] std::vector<stdfs::path> Archives(
+      const stdfs::path& dir,
+      const stdfs::path& log)
+   {
+      std::vector<stdfs::path> archives;
+      for (const auto& entry : stdfs::directory_iterator(dir)) {
+         if (entry.path() != log) {
+            archives.push_back(entry.path());
+         }
+      }
+      return archives;
+   }
+
+   [[nodiscard]] std::multiset<std::string> Contents(
+      const std::vector<stdfs::path>& files)
+   {
+      std::multiset<std::string> contents;
+      for (const auto& file : files) {
+         contents.insert(ReadAll(file));
+      }
+      return contents;
+   }
+
+   // The archivist thread works on its own time.
+   [[nodiscard]] bool WaitForArchive(
+      const stdfs::path& dir,
+      const stdfs::path& log)
+   {
+      const auto giveUp = std::chrono::steady_clock::now() + 10s;
+      while (Archives(dir, log).empty()) {
+         if (std::chrono::steady_clock::now() > giveUp) {
+            return false;
+         }
+         std::this_thread::sleep_for(10ms);
+      }
+      return true;
+   }
+}
+
+TEST_CASE("LogArchivist: archives made within a second are all kept")
+{
+   TempDir temp("ppfbase_log_archivist_names");
+   const auto log = temp.path / "test.log";
+
+   LogArchivist archivist(log, kNoLimits, SharingMode::SingleProcess);
+   CHECK(log == archivist.path());
+
+   for (int i = 0; i < 5; ++i) {
+      archivist.Append(std::to_string(i) + "\n");
+      archivist.Rotate();
+   }
+
+   // Nothing to archive.
+   archivist.Rotate();
+
+   const auto archives = Archives(temp.path, log);
+   CHECK(5 == archives.size());
+   CHECK(std::multiset<std::string>{"0\n", "1\n", "2\n", "3\n", "4\n"}
+      == Contents(archives));
+
+   archivist.Append("5\n");
+   CHECK("5\n" == ReadAll(log));
+}
+
+TEST_CASE("LogArchivist: prunes the oldest archives")
+{
+   TempDir temp("ppfbase_log_archivist_prune");
+   const auto log = temp.path / "test.log";
+
+   auto policy = kNoLimits;
+
+   SUBCASE("By count")
+   {
+      policy.maxArchives = 2;
+   }
+
+   SUBCASE("By size")
+   {
+      // The archives are 2 bytes each.
+      policy.maxArchiveBytes = 5;
+   }
+
+   LogArchivist archivist(log, policy, SharingMode::SingleProcess);
+   for (int i = 0; i < 5; ++i) {
+      archivist.Append(std::to_string(i) + "\n");
+      archivist.Rotate();
+   }
+
+   CHECK(std::multiset<std::string>{"3\n", "4\n"}
+      == Contents(Archives(temp.path, log)));
+}
+
+TEST_CASE("LogArchivist: prunes archives by age")
+{
+   TempDir temp("ppfbase_log_archivist_age");
+   const auto log = temp.path / "test.log";
+   const auto old = stdfs::file_time_type::clock::now() - 48h;
+
+   const auto archive = temp.path / "test.20000101-000000.log";
+   std::ofstream(archive) << "old\n";
+   stdfs::last_write_time(archive, old);
+
+   // The log of another process, not an archive.
+   const auto other = temp.path / "test.1234.log";
+   std::ofstream(other) << "other\n";
+   stdfs::last_write_time(other, old);
+
+   auto policy = kNoLimits;
+   policy.maxArchiveAge = 24h;
+
+   LogArchivist archivist(log, policy, SharingMode::SingleProcess);
+   archivist.Append("new\n");
+   archivist.Rotate();
+
+   CHECK_FALSE(stdfs::exists(archive));
+   CHECK(stdfs::exists(other));
+   CHECK(std::multiset<std::string>{"new\n", "other\n"}
+      == Contents(Archives(temp.path, log)));
+}
+
+TEST_CASE("LogArchivist: rotates on its own thread")
+{
+   TempDir temp("ppfbase_log_archivist_thread");
+   const auto log = temp.path / "test.log";
+
+   auto policy = kNoLimits;
+
+   SUBCASE("By size")
+   {
+      policy.maxFileBytes = 1024;
+   }
+
+   SUBCASE("By interval")
+   {
+      policy.rotationInterval = 1s;
+   }
+
+   static constexpr size_t kWriters = 4;
+   static constexpr size_t kLines = 500;
+
+   std::multiset<std::string> expected;
+   {
+      LogArchivist archivist(log, policy, SharingMode::SingleProcess);
+      {
+         std::vector<std::jthread> writers;
+         for (size_t w = 0; w < kWriters; ++w) {
+            writers.emplace_back([&archivist, w] {
+               for (size_t n = 0; n < kLines; ++n) {
+                  archivist.Append(
+                     std::to_string(w) + ":" + std::to_string(n) + "\n");
+               }
+            });
+         }
+      }
+
+      CHECK(WaitForArchive(temp.path, log));
+   }
+
+   for (size_t w = 0; w < kWriters; ++w) {
+      for (size_t n = 0; n < kLines; ++n) {
+         expected.insert(std::to_string(w) + ":" + std::to_string(n));
+      }
+   }
+
+   // Every line once and whole, in one file or another.
+   std::multiset<std::string> lines;
+   for (const auto& entry : stdfs::directory_iterator(temp.path)) {
+      std::ifstream is(entry.path(), std::ifstream::binary);
+      for (std::string line; std::getline(is, line);) {
+         lines.insert(line);
+      }
+   }
+   CHECK(expected == lines);
+}
+
+TEST_CASE("LogArchivist: follows rotations of other processes")
+{
+   TempDir temp("ppfbase_log_archivist_shared");
+   const auto log = temp.path / "test.log";
+
+   LogArchivist first(log, kNoLimits, SharingMode::MultiProcess);
+   LogArchivist second(log, kNoLimits, SharingMode::MultiProcess);
+
+   first.Append("a\n");
+   second.Append("b\n");
+   first.Rotate();
+
+   // Picks up the new file instead of archiving it again.
+   second.Rotate();
+   second.Append("c\n");
+   first.Append("d\n");
+
+   CHECK(std::multiset<std::string>{"a\nb\n"}
+      == Contents(Archives(temp.path, log)));
+   CHECK("c\nd\n" == ReadAll(log));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <ppfbase/logging/logging.h>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <regex>
+#include <string>
+
+namespace tdd::base::logging {
+
+namespace {
+   static_assert(
+      std::string_view(details::SourceFileName("C:\\src/logging\\a.cpp")) ==
+      "a.cpp");
+   static_assert(
+      std::string_view(details::SourceFileName("a.cpp")) == "a.cpp");
+
+   struct Nested
+   {
+      int value;
+   };
+
+   std::ostream& operator<<(std::ostream& os, const Nested& nested)
+   {
+      LogMsg inner("inner.cpp", 1, "Inner", Severity::Debug);
+      inner.stream() << "inner " << nested.value;
+      CHECK(inner.str().ends_with("inner.cpp<1>:Inner(): inner 7"));
+      return os << "nested " << nested.value;
+   }
+}
+
+TEST_CASE("LogMsg: writes the prefix")
+{
+   LogMsg msg("log_msg_test.cpp", 42, "Func", Severity::Verbose_2);
+   msg.stream() << "hello " << 7;
+
+   static const std::regex kFormat(
+      R"(\d{4}-\d\d-\d\d@\d\d:\d\d:\d\d\.\d{3}[+-]\d\d:\d\d)"
+      R"(\[\d{2,}:\d\d:\d\d\.\d{3}\] P\d{5,}T\d{5,}  V_2 \S+ )"
+      R"(log_msg_test\.cpp<42>:Func\(\): hello 7)");
+   CAPTURE(msg.str());
+   CHECK(std::regex_match(std::string(msg.str()), kFormat));
+}
+
+// Fatal and above break into the debugger.
+TEST_CASE("LogMsg: pads every severity to 4 columns")
+{
+   for (const auto [severity, label] : {
+         std::pair{Severity::Verbose_1, " V_1 "},
+         std::pair{Severity::Debug, " DBG "},
+         std::pair{Severity::Info, " INFO "},
+         std::pair{Severity::Warning, " WARN "},
+         std::pair{Severity::Error, "  ERR "}})
+   {
+      LogMsg msg("a.cpp", 1, "F", severity);
+      CAPTURE(msg.str());
+      CHECK(msg.str().find(label) != std::string_view::npos);
+   }
+}
+
+TEST_CASE("LogMsg: starts every message with fresh formatting")
+{
+   {
+      LogMsg msg("a.cpp", 1, "F", Severity::Debug);
+      msg.stream() << std::hex << std::setfill('x') << std::setw(5)
+         << std::boolalpha << std::setprecision(2) << 255;
+      CHECK(msg.str().ends_with("xxxff"));
+   }
+
+   LogMsg msg("a.cpp", 1, "F", Severity::Debug);
+   msg.stream() << 255 << " " << std::setw(4) << 1 << " " << true << " "
+      << 3.14159265;
+   CHECK(msg.str().ends_with("(): 255    1 1 3.14159"));
+}
+
+TEST_CASE("LogMsg: logs while formatting another message")
+{
+   LogMsg msg("outer.cpp", 2, "Outer", Severity::Debug);
+   msg.stream() << "outer " << Nested{7} << " done";
+   CHECK(msg.str().ends_with("outer.cpp<2>:Outer(): outer nested 7 done"));
+}
+
+TEST_CASE("LogMsg: grows for long messages")
+{
+   const std::string big(100 * 1024, 'x');
+   for (int round = 0; round < 2; ++round) {
+      LogMsg msg("a.cpp", 1, "F", Severity::Debug);
+      for (const auto c : big) {
+         msg.stream() << c;
+      }
+      msg.stream() << big;
+      CHECK(msg.str().ends_with("(): " + big + big));
+   }
+
+   LogMsg msg("a.cpp", 1, "F", Severity::Debug);
+   msg.stream() << "short";
+   CHECK(msg.str().ends_with("(): short"));
+}
+
+// A hooked read at Verbose_2, without a log to write to.
+TEST_CASE("LogMsg: benchmark" * doctest::skip())
+{
+   static constexpr int kMessages = 200'000;
+
+   const auto level = GetMinLogLevel();
+   SetMinLogLevel(Severity::Verbose_2);
+
+   const auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < kMessages; ++i) {
+      TDD_VLOG2() << i * 2352 << ":" << 2352;
+   }
+   const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+
+   SetMinLogLevel(level);
+   const auto perMessage = elapsed.count() / kMessages;
+   MESSAGE(perMessage << " ns per message");
+}
+
+}
\ No newline at end of file
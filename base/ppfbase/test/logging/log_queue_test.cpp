@@ -0,0 +1,172 @@
+#include <ppfbase/logging/log_queue.h>
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tdd::base::logging {
+
+TEST_CASE("LogQueue: pops messages in order")
+{
+   LogQueue queue(64);
+   CHECK(queue.Capacity() == 64);
+   CHECK(queue.Empty());
+
+   CHECK(queue.TryPush("one\n"));
+   CHECK(queue.TryPush(""));
+   CHECK(queue.TryPush("two\n"));
+   CHECK_FALSE(queue.Empty());
+   CHECK(queue.Used() == 3);
+
+   std::string out;
+   CHECK(queue.PopAll(out) == 3);
+   CHECK(out == "one\ntwo\n");
+   CHECK(queue.Empty());
+   CHECK(queue.Used() == 0);
+   CHECK(queue.PopAll(out) == 0);
+}
+
+TEST_CASE("LogQueue: long messages span slots and wrap around")
+{
+   LogQueue queue(64);
+
+   // 3 slots each. 64 isn't a multiple of 3, so some of them wrap.
+   for (char c = 'a'; c <= 'z'; ++c) {
+      const std::string msg(LogQueue::kSlotBytes * 2 + 10, c);
+      REQUIRE(queue.TryPush(msg));
+      CHECK(queue.Used() == 3);
+
+      std::string out;
+      REQUIRE(queue.PopAll(out) == 1);
+      CHECK(out == msg);
+   }
+}
+
+TEST_CASE("LogQueue: cuts messages that are too long")
+{
+   LogQueue queue(128);
+
+   std::string msg(LogQueue::kMaxMessageBytes + 100, 'x');
+   msg.back() = '\n';
+   REQUIRE(queue.TryPush(msg));
+   CHECK(queue.Used() == LogQueue::kMaxSlotsPerMessage);
+
+   std::string out;
+   REQUIRE(queue.PopAll(out) == 1);
+   REQUIRE(out.size() == LogQueue::kMaxMessageBytes);
+   CHECK(out.back() == '\n');
+   CHECK(out.substr(0, out.size() - 1) ==
+      std::string(out.size() - 1, 'x'));
+}
+
+TEST_CASE("LogQueue: turns messages away when full")
+{
+   LogQueue queue(64);
+   const std::string msg(LogQueue::kSlotBytes * 30, 'x');
+
+   CHECK(queue.TryPush(msg));
+   CHECK(queue.TryPush(msg));
+   CHECK_FALSE(queue.TryPush(msg));
+   CHECK(queue.TryPush(std::string(LogQueue::kSlotBytes * 4, 'y')));
+   CHECK_FALSE(queue.TryPush("z"));
+
+   std::string out;
+   CHECK(queue.PopAll(out) == 3);
+   CHECK(queue.TryPush(msg));
+}
+
+TEST_CASE("LogQueue: keeps the order of each producer")
+{
+   static constexpr size_t kProducers = 4;
+   static constexpr size_t kMessages = 20000;
+
+   LogQueue queue(256);
+   std::atomic<size_t> done = 0;
+   std::vector<std::jthread> producers;
+
+   for (size_t p = 0; p < kProducers; ++p) {
+      producers.emplace_back([&queue, &done, p] {
+         for (size_t i = 0; i < kMessages; ++i) {
+            // Some messages take several slots.
+            std::string msg = std::to_string(p) + " " + std::to_string(i);
+            msg.append(i % 7 == 0 ? LogQueue::kSlotBytes * 2 : 0, '.');
+            msg += '\n';
+
+            while (!queue.TryPush(msg)) {
+               std::this_thread::yield();
+            }
+         }
+         ++done;
+      });
+   }
+
+   std::string out;
+   while (done < kProducers || !queue.Empty()) {
+      if (queue.PopAll(out) == 0) {
+         std::this_thread::yield();
+      }
+   }
+
+   std::vector<size_t> next(kProducers, 0);
+   std::istringstream lines(out);
+   std::string line;
+   size_t count = 0;
+   while (std::getline(lines, line)) {
+      std::istringstream fields(line);
+      size_t p = 0;
+      size_t i = 0;
+      fields >> p >> i;
+      REQUIRE(p < kProducers);
+      REQUIRE(i == next[p]);
+      ++next[p];
+      ++count;
+   }
+   CHECK(count == kProducers * kMessages);
+}
+
+TEST_CASE("LogQueue: benchmark" * doctest::skip())
+{
+   static constexpr size_t kMessages = 1'000'000;
+   const std::string msg(120, 'x');
+
+   for (const size_t producers : {1, 2, 4}) {
+      LogQueue queue(4096);
+      std::atomic<bool> stop = false;
+      std::jthread consumer([&queue, &stop] {
+         std::string out;
+         while (!stop || !queue.Empty()) {
+            queue.PopAll(out);
+            out.clear();
+         }
+      });
+
+      const auto start = std::chrono::steady_clock::now();
+      {
+         std::vector<std::jthread> threads;
+         for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, &msg, producers] {
+               for (size_t i = 0; i < kMessages / producers; ++i) {
+                  while (!queue.TryPush(msg)) {
+                     std::this_thread::yield();
+                  }
+               }
+            });
+         }
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      stop = true;
+
+      const auto ns =
+         std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+      MESSAGE(
+         producers << " producers: " << ns.count() / kMessages
+         << " ns per message");
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <ppfbase/stdext/mutex.h>
+
+#include <doctest/doctest.h>
+
+#include <future>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+
+namespace tdd::stdext {
+
+// The handle would be closed twice.
+static_assert(!std::is_move_constructible_v<mp_mutex>);
+static_assert(!std::is_move_assignable_v<mp_mutex>);
+
+TEST_CASE("mp_mutex: instances of the same name exclude each other")
+{
+   static constexpr std::wstring_view kName = L"ppfbase_mp_mutex_test";
+
+   mp_mutex first(kName);
+   mp_mutex second(kName);
+   CHECK(kName == first.name());
+
+   // A named mutex is recursive for its owning thread on Windows. Another
+   // thread has to try.
+   const auto tryOther = [&second] {
+      return std::async(std::launch::async, [&second] {
+         const auto locked = second.try_lock();
+         if (locked) {
+            second.unlock();
+         }
+         return locked;
+      }).get();
+   };
+
+   {
+      std::lock_guard lock(first);
+      CHECK_FALSE(tryOther());
+   }
+
+   CHECK(tryOther());
+}
+
+}
\ No newline at end of file
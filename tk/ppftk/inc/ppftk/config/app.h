@@ -1,8 +1,10 @@
 #pragma once
 
 #include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/logging/archive_policy.h>
 #include <ppfbase/logging/severity.h>
 
+#include <cstdint>
 #include <filesystem>
 #include <set>
 #include <string>
@@ -10,6 +12,7 @@
 namespace tdd::tk::config::App {
 
    const base::logging::Severity LogLevel() noexcept;
+   const base::logging::ArchivePolicy& LogArchivePolicy() noexcept;
 
    const std::filesystem::path& Emulator() noexcept;
    void Emulator(const std::filesystem::path& emulator);
@@ -17,5 +20,8 @@ namespace tdd::tk::config::App {
 
    const std::set<std::string>& TargetExts() noexcept;
 
+   // Reads kept in the binary read trace. 0 if tracing is off.
+   uint32_t ReadTraceRecords() noexcept;
+
 
 }
\ No newline at end of file
@@ -12,6 +12,10 @@ namespace tdd::tk::config {
       Patch(const std::filesystem::path& target);
       TDD_DEFAULT_ALL_SPECIAL_MEMBERS(Patch);
 
+      // True if 'target' has a patch config or a PPF next to it. Only checks
+      // that the files exist, nothing is read.
+      [[nodiscard]] static bool Exists(const std::filesystem::path& target);
+
       [[nodiscard]] const std::filesystem::path& PatchFile() const noexcept;
       [[nodiscard]] bool CalculateEdc() const noexcept;
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <ppftk/rom_patch/patch_item.h>
+
+#include <ppfbase/stdext/cstring.h>
+
+#include <algorithm>
+#include <span>
+
+namespace tdd::tk::rompatch {
+
+   // Copies the patch data overlapping [addr, addr + target.size()) into
+   // 'target'. [patchBegin, patchEnd) must be sorted and non-overlapping.
+   //
+   // Every overlapping item is clipped to the window with min/max and copied
+   // with a single memcpy_s. The loop has no branches besides its own
+   // condition, so it stays tight for large reads that cover many items.
+   template <typename Iter>
+   void ApplyPatches(
+      const uint64_t addr,
+      std::span<uint8_t> target,
+      const Iter patchBegin,
+      const Iter patchEnd)
+   {
+      const auto targetEnd = addr + target.size();
+
+      const auto first = std::partition_point(
+         patchBegin,
+         patchEnd,
+         [addr](const PatchItem& item) {
+            return item.address + item.data.size() <= addr;
+         });
+
+      for (auto it = first; it != patchEnd && it->address < targetEnd; ++it) {
+         const auto copyStart = std::max<uint64_t>(it->address, addr);
+         const auto copyEnd =
+            std::min<uint64_t>(it->address + it->data.size(), targetEnd);
+         const size_t copySize = copyEnd - copyStart;
+
+         memcpy_s(
+            target.data() + (copyStart - addr),
+            copySize,
+            it->data.data() + (copyStart - it->address),
+            copySize);
+      }
+   }
+
+   template <typename Container>
+   void ApplyPatches(
+      const uint64_t addr,
+      std::span<uint8_t> target,
+      const Container& patches)
+   {
+      ApplyPatches(addr, target, patches.begin(), patches.end());
+   }
+
+   // Extends 'last' with 'next' if they are one run of patch data: 'next'
+   // starts where 'last' ends, both in the target and in memory. Consecutive
+   // PPF records are copied into the PatchArena back to back, so long
+   // patched regions collapse into a handful of items.
+   [[nodiscard]] inline bool MergePatchItem(
+      PatchItem& last,
+      const PatchItem& next) noexcept
+   {
+      if (last.address + last.data.size() != next.address
+       || last.data.data() + last.data.size() != next.data.data()) {
+         return false;
+      }
+
+      last.data =
+         DataView(last.data.data(), last.data.size() + next.data.size());
+      return true;
+   }
+}
\ No newline at end of file
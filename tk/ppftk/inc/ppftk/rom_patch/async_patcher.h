@@ -0,0 +1,98 @@
+#pragma once
+
+#include <ppftk/rom_patch/ipatcher.h>
+#include <ppftk/rom_patch/patch_descriptor.h>
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+   // Builds the real patcher on a background thread so that opening the
+   // target doesn't wait for it. Until it's ready, reads that don't touch any
+   // patched byte go through untouched. Only reads that do, or reads that
+   // arrive before the patched ranges are known, wait for the loader.
+   class [[nodiscard]] AsyncPatcher : public IPatcher
+   {
+   public:
+      // [start, end) in bytes.
+      struct [[nodiscard]] Range
+      {
+         uint64_t start;
+         uint64_t end;
+      };
+
+      // Sorted and non-overlapping.
+      using Ranges = std::vector<Range>;
+
+      // Lets the loader publish the patched ranges as soon as it knows them,
+      // ahead of the patcher itself. Must be called at most once.
+      using Announce = std::function<void(Ranges&&)>;
+
+      // Runs on the loader thread. Returns nullptr if there turns out to be
+      // nothing to patch.
+      using Loader =
+         std::function<std::unique_ptr<IPatcher>(const Announce& announce)>;
+
+      explicit AsyncPatcher(Loader loader);
+
+      // Waits for the loader to finish.
+      ~AsyncPatcher() override = default;
+
+      [[nodiscard]] std::optional<AdditionalReads> Patch(
+         const uint64_t addr,
+         std::span<uint8_t> buffer) override;
+
+      // Blocks until the loader has finished. Returns false if it didn't
+      // produce a patcher.
+      [[nodiscard]] bool Wait() const noexcept;
+
+      // Counted by the patcher once it's ready. Until then, bytes of the
+      // announced ranges, and 0 before they are announced.
+      [[nodiscard]] uint64_t PatchedBytes(
+         const uint64_t addr,
+         const uint64_t size) const noexcept override;
+
+      // Every byte in 'patches', widened to whole blocks of 'blockSize'.
+      // Adjacent and overlapping blocks are merged.
+      [[nodiscard]] static Ranges CoveredRanges(
+         const PatchDescriptor::FullPatch& patches,
+         const uint64_t blockSize);
+
+   private:
+      enum class [[nodiscard]] State : uint8_t
+      {
+         Loading,
+         Announced,
+         Ready
+      };
+
+      void Load(Loader loader);
+      void SetRanges(Ranges&& ranges);
+      void Publish(const State state) noexcept;
+      State WaitFor(const State state) const noexcept;
+
+      [[nodiscard]] bool Overlaps(
+         const uint64_t addr,
+         const uint64_t size) const noexcept;
+
+      // Written by the loader thread before m_state moves past the state that
+      // guards them, and never again afterwards.
+      Ranges m_ranges;
+      std::unique_ptr<IPatcher> m_patcher;
+
+      std::atomic<State> m_state;
+
+      // Last, so the loader only starts once everything above is
+      // initialised, and is joined before any of it is destroyed.
+      std::jthread m_loader;
+
+      TDD_DISABLE_COPY_MOVE(AsyncPatcher);
+   };
+
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <ppfbase/stdext/type_traits.h>
 
+#include <cstdint>
 #include <iosfwd>
 
 namespace tdd::tk::rompatch::cd {
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <ppftk/rom_patch/cd/spec.h>
+
+namespace tdd::tk::rompatch::cd::ecc {
+
+// ECMA-130 Annex A. Regenerates the P and Q parity of a Mode 1 sector. The
+// sync, header, user data, EDC and intermediate fields must be final.
+void CalculateMode1Ecc(spec::Sector* sector) noexcept;
+
+// CD-ROM XA: 4.5.1. Same as Mode 1, except the header is treated as 0 so the
+// parity stays valid when the sector is relocated.
+void CalculateXaForm1Ecc(spec::Sector* sector) noexcept;
+
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ppftk/rom_patch/cd/patcher.h>
+
+#include <ppfbase/stdext/poor_mans_expected.h>
+
+#include <filesystem>
+#include <system_error>
+
+namespace tdd::tk::rompatch::cd::PatchCache {
+
+// The files a cache was compiled from. A cache is only used while both are
+// unchanged.
+struct [[nodiscard]] Sources
+{
+   std::filesystem::path ppf;
+   std::filesystem::path image;
+};
+
+// Where the cache for 'image' lives: next to it, with an extra extension.
+[[nodiscard]] std::filesystem::path CachePath(
+   const std::filesystem::path& image);
+
+// Writes the sector patches of 'patcher', including any checksums it has
+// already computed, to 'cache'. The file is written in full before it
+// replaces an existing cache.
+[[nodiscard]] std::error_code Save(
+   const std::filesystem::path& cache,
+   const Sources& sources,
+   const Patcher& patcher);
+
+// Maps 'cache' and checks it against 'sources'. The patch data of the returned
+// Patcher points straight into the mapped file. The sector records are
+// validated and rebuilt into SectorPatches, and the known checksums are copied
+// into them, so that the lazily computed ones can be filled in next to them.
+// Nothing is parsed from the PPF or recomputed.
+[[nodiscard]] stdext::pm_expected<Patcher> Load(
+   const std::filesystem::path& cache,
+   const Sources& sources);
+
+}
\ No newline at end of file
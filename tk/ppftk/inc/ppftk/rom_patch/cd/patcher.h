@@ -1,11 +1,16 @@
 #pragma once
 
 #include <ppftk/rom_patch/ipatcher.h>
+#include <ppftk/rom_patch/patch_arena.h>
 
+#include <ppftk/rom_patch/cd/sector_bitmap.h>
 #include <ppftk/rom_patch/cd/sector_patch.h>
 
 #include <ppfbase/preprocessor_utils.h>
 
+#include <filesystem>
+#include <memory>
+
 namespace tdd::tk::rompatch {
 class PatchDescriptor;
 }
@@ -18,12 +23,30 @@ namespace tdd::tk::rompatch::cd {
    public:
       Patcher(PatchDescriptor&& fullPatch);
 
-      TDD_DEFAULT_ALL_SPECIAL_MEMBERS(Patcher);
+      // 'patches' must be sorted by sector and point into 'arena'.
+      Patcher(PatchArena&& arena, std::vector<SectorPatch>&& patches);
+
+      TDD_DEFAULT_CTOR_DTOR(Patcher);
+      TDD_DEFAULT_MOVE(Patcher);
 
       [[nodiscard]] std::optional<AdditionalReads> Patch(
          const uint64_t addr,
          std::span<uint8_t> buffer) override;
 
+      // Whole patched sectors, the checksums change with the data.
+      [[nodiscard]] uint64_t PatchedBytes(
+         const uint64_t addr,
+         const uint64_t size) const noexcept override;
+
+      // Computes the checksums of every patched sector up front from the
+      // unpatched 'image', spread across all cores. Afterwards Patch() never
+      // asks for additional reads. Sectors that cannot be read from 'image'
+      // are left to be computed on their first read. Returns false if there
+      // were any. 'image' is only ever opened on the calling thread.
+      [[nodiscard]] bool Bake(const std::filesystem::path& image);
+
+      [[nodiscard]] std::span<const SectorPatch> SectorPatches() const noexcept;
+
    private:
       [[nodiscard]] std::optional<AdditionalReads> DoPatch(
          const ByteAddress addr,
@@ -36,6 +59,11 @@ namespace tdd::tk::rompatch::cd {
       [[nodiscard]] bool RequireFullSector(
          const SectorView& sector) const noexcept;
 
+      // Owns the patch data the SectorPatch items point into.
+      PatchArena m_arena;
       std::vector<SectorPatch> m_patches;
+      SectorBitmap m_patchedSectors;
+
+      TDD_DISABLE_COPY(Patcher);
    };
 }
\ No newline at end of file
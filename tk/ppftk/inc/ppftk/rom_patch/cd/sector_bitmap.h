@@ -0,0 +1,37 @@
+#pragma once
+
+#include <ppftk/rom_patch/cd/address.h>
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace tdd::tk::rompatch::cd {
+   class SectorPatch;
+
+   // One bit per sector, set for the sectors that have a patch. About 40 KiB
+   // for a full CD. Lets a read that touches no patched sector be turned away
+   // without searching the patches.
+   class [[nodiscard]] SectorBitmap
+   {
+   public:
+      // 'patches' must be sorted by sector. Patches without data are skipped.
+      explicit SectorBitmap(std::span<const SectorPatch> patches);
+
+      TDD_DEFAULT_CTOR_DTOR(SectorBitmap);
+      TDD_DEFAULT_COPY_MOVE(SectorBitmap);
+
+      // True if any sector in [first, last] is patched.
+      [[nodiscard]] bool Any(
+         const SectorNumber first,
+         const SectorNumber last) const noexcept;
+
+      // Number of patched sectors.
+      [[nodiscard]] size_t Count() const noexcept;
+
+   private:
+      std::vector<uint64_t> m_words;
+   };
+}
\ No newline at end of file
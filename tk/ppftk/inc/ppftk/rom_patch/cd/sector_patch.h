@@ -6,11 +6,15 @@
 
 #include <ppfbase/preprocessor_utils.h>
 
-#include <optional>
+#include <atomic>
 #include <span>
 
 namespace tdd::tk::rompatch::cd {
 
+   // Patch() may be called from any number of threads at once. The checksums
+   // are computed on the first read of the sector and published once, see
+   // PublishChecksums(). Everything else is only safe while no other thread
+   // uses the patch.
    class [[nodiscard]] SectorPatch
    {
    public:
@@ -20,7 +24,10 @@ namespace tdd::tk::rompatch::cd {
 
       ~SectorPatch() = default;
 
-      TDD_DEFAULT_COPY_MOVE(SectorPatch);
+      SectorPatch(const SectorPatch& other);
+      SectorPatch(SectorPatch&& other) noexcept;
+      SectorPatch& operator=(const SectorPatch& other);
+      SectorPatch& operator=(SectorPatch&& other) noexcept;
 
       [[nodiscard]] bool operator<(const SectorPatch& other) const noexcept;
 
@@ -36,33 +43,70 @@ namespace tdd::tk::rompatch::cd {
       // Also calculate checksum data if required.
       void Patch(SectorView& sector) const;
 
-      [[nodiscard]] SectorNumber SectorNumber() const noexcept;
+      [[nodiscard]] cd::SectorNumber SectorNumber() const noexcept;
 
+      // True once the EDC, and the ECC for sectors that have one, are known.
       [[nodiscard]] bool HasUpdatedEdc() const noexcept;
 
       // For when we need to patch a sector that the buffer in ReadFile doesn't
       // cover completely. The hook needs to perform extra read to get either
       // the start or the end of the sector.
       void CalculateChecksum(SectorView& originalSector);
+
+      // Sector relative patch data. Items that are contiguous both in the
+      // sector and in memory are merged into one.
+      [[nodiscard]] std::span<const PatchItem> Patches() const noexcept;
+
+      // Where Checksums() starts in the sector. 0 until the checksums have
+      // been calculated, and kSectorSize for sectors without any.
+      [[nodiscard]] SectorOffset ChecksumsIndex() const noexcept;
+      [[nodiscard]] DataView Checksums() const noexcept;
+
+      // Takes checksums calculated earlier, e.g. by a PatchCache, instead of
+      // calculating them on the first read. Returns false if 'edcIdx' and
+      // 'checksums' don't describe a valid checksum block.
+      [[nodiscard]] bool RestoreChecksums(
+         const SectorOffset edcIdx,
+         const DataView checksums);
+
    private:
-      void PatchEdc(SectorView& sector) const noexcept;
-      void CalculateEdc(SectorView& sv) const noexcept;
+      enum class [[nodiscard]] ChecksumsState : uint8_t
+      {
+         Unknown,
+         // One thread is filling in m_checksums and m_edcIdx.
+         Publishing,
+         // m_checksums and m_edcIdx are final.
+         Known
+      };
 
-      void CalculateMode1Edc(spec::Sector* sector) const noexcept;
-      void CalculateMode2Edc(
+      void PatchChecksums(SectorView& sector) const noexcept;
+      void PublishChecksums(
+         const SectorView& sector,
+         const SectorOffset edcIdx) const;
+
+      // These compute the checksums into the sector and return where they
+      // start in it.
+      [[nodiscard]] static SectorOffset CalculateEdc(SectorView& sv);
+      [[nodiscard]] static SectorOffset CalculateMode1Edc(
+         spec::Sector* sector);
+      [[nodiscard]] static SectorOffset CalculateMode2Edc(
          spec::Sector* sector,
-         const cd::SectorNumber sectorNumber) const noexcept;
-      void CalculateXaForm1Edc(spec::Sector* sector) const noexcept;
-      void CalculateXaForm2Edc(spec::Sector* sector) const noexcept;
-      void ZeroXaForm2Edc(spec::Sector* sector) const noexcept;
+         const cd::SectorNumber sectorNumber);
+      [[nodiscard]] static SectorOffset CalculateXaForm1Edc(
+         spec::Sector* sector);
+      [[nodiscard]] static SectorOffset CalculateXaForm2Edc(
+         spec::Sector* sector);
+      [[nodiscard]] static SectorOffset ZeroXaForm2Edc(spec::Sector* sector);
 
       // filePtr / kSectorSize
       cd::SectorNumber m_sectorNumber;
       std::vector<PatchItem> m_patches;
-      mutable std::optional<spec::Edc> m_edc;
+      // Everything from the EDC to the end of the sector: the EDC, plus the
+      // intermediate field and the P and Q parity where the sector has them.
+      // Written once, before m_state becomes Known.
+      mutable DataBuffer m_checksums;
       mutable SectorOffset m_edcIdx;
-      // May not be needed if edc alone can fool the emulator.
-      // mutable DataBuffer m_ecc;
+      mutable std::atomic<ChecksumsState> m_state;
    };
 
 }
\ No newline at end of file
@@ -20,7 +20,7 @@ public:
    ~SectorView() = default;
    TDD_DEFAULT_COPY_MOVE(SectorView);
 
-   [[nodiscard]] SectorNumber SectorNumber() const noexcept;
+   [[nodiscard]] cd::SectorNumber SectorNumber() const noexcept;
    [[nodiscard]] ByteAddress SectorAddress() const noexcept;
 
    // Idx of the first valid data byte.
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace tdd::tk::rompatch::cd {
+
+   // How much of every sector has to match.
+   enum class [[nodiscard]] VerifyLevel : uint8_t
+   {
+      // Everything but the EDC and ECC. Form 2 EDCs are still compared
+      // unless the target leaves them 0.
+      Data,
+      // Everything but the ECC.
+      Edc,
+      // Every byte. The images don't need to end on a whole sector.
+      Ecc
+   };
+
+   // Decided by the target's sector.
+   enum class [[nodiscard]] SectorLayout : uint8_t
+   {
+      Mode0,
+      Mode1,
+      // Mode 2 without the XA subheader.
+      Mode2,
+      Mode2Form1,
+      Mode2Form2,
+      // Compared in full.
+      Unknown
+   };
+
+   [[nodiscard]] std::string_view ToString(const SectorLayout layout) noexcept;
+
+   struct [[nodiscard]] SectorMismatch
+   {
+      uint64_t sector;
+      SectorLayout layout;
+      // First byte in the sector that differs.
+      size_t offset;
+   };
+
+   struct [[nodiscard]] VerifyOptions
+   {
+      VerifyLevel level = VerifyLevel::Data;
+
+      // Sectors read per step. About 4 MiB.
+      size_t chunkSectors = 1792;
+
+      // 0 uses every core.
+      size_t workers = 0;
+   };
+
+   struct [[nodiscard]] VerifyReport
+   {
+      uint64_t sectors;
+      // Sorted by sector.
+      std::vector<SectorMismatch> mismatches;
+   };
+
+   // Compares 'target' with the pre-patched 'verification', which must be of
+   // the same size. Each worker takes a contiguous range of sectors and reads
+   // it through streams of its own, so reads of a live-patched 'target' go
+   // through the injector like an emulator's would. Every mismatching sector
+   // is reported, not just the first.
+   //
+   // nullopt if the images couldn't be read or have different sizes.
+   [[nodiscard]] std::optional<VerifyReport> Verify(
+      const std::filesystem::path& target,
+      const std::filesystem::path& verification,
+      const VerifyOptions& options = {});
+
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <ppftk/rom_patch/ipatcher.h>
+
+#include <functional>
+
+namespace tdd::tk::rompatch {
+
+   // Positional read of [addr, addr + buffer.size()) from the patched file.
+   // Must not move the file pointer the emulator reads with. False unless the
+   // whole buffer was read.
+   using ReadAt = std::function<bool(uint64_t addr, std::span<uint8_t> buffer)>;
+
+   // Fetches the blocks 'patcher' asked for and feeds them back to it.
+   // Adjacent blocks, typically the head and tail sector of a short read
+   // across a sector boundary, are fetched with a single read. False if a
+   // read failed.
+   [[nodiscard]] bool FeedAdditionalReads(
+      IPatcher& patcher,
+      const IPatcher::AdditionalReads& extraReads,
+      const ReadAt& readAt);
+
+   // Patches 'data', read from the file at 'addr', fetching whatever extra
+   // blocks 'patcher' asks for on the way. False if an extra read failed.
+   [[nodiscard]] bool PatchRead(
+      IPatcher& patcher,
+      const uint64_t addr,
+      std::span<uint8_t> data,
+      const ReadAt& readAt);
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
 #include <optional>
 #include <vector>
@@ -24,6 +25,12 @@ public:
    [[nodiscard]] virtual std::optional<AdditionalReads> Patch(
       const uint64_t addr,
       std::span<uint8_t> buffer) = 0;
+
+   // Bytes of [addr, addr + size) that Patch() may change. Patchers of fixed
+   // data blocks count whole blocks.
+   [[nodiscard]] virtual uint64_t PatchedBytes(
+      const uint64_t addr,
+      const uint64_t size) const noexcept = 0;
 };
 
 }
\ No newline at end of file
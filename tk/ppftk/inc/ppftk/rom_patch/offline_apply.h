@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ppftk/rom_patch/async_patcher.h>
+#include <ppftk/rom_patch/ipatcher.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace tdd::tk::rompatch {
+
+   struct [[nodiscard]] OfflineApplyOptions
+   {
+      // Bytes handed to a worker at a time. Rounded down to whole CD sectors
+      // so that no sector is split between two workers. About 4 MiB.
+      size_t chunkSize = 1792 * 2352;
+
+      // Patching threads. 0 uses every core.
+      size_t workers = 0;
+   };
+
+   // Writes 'source' with 'patcher' applied to 'output', which must not be
+   // 'source'. The calling thread reads chunks, a pool of workers patches
+   // them and a writer thread writes them back in order. Reading, patching
+   // and writing all overlap. 'patcher' is called from every worker at once.
+   //
+   // False if any IO failed. 'output' is incomplete then.
+   [[nodiscard]] bool ApplyOffline(
+      IPatcher& patcher,
+      const std::filesystem::path& source,
+      const std::filesystem::path& output,
+      const OfflineApplyOptions& options = {});
+
+   // Clones 'source' into 'output', see base::fs::CloneFile(), and rewrites
+   // only 'ranges' with 'patcher' applied. 'ranges' are sorted and cover
+   // whole sectors, see AsyncPatcher::CoveredRanges(). Where the clone is a
+   // reflink, only the patched sectors cost time or disk space.
+   //
+   // False on failure. 'output' is incomplete then.
+   [[nodiscard]] bool ApplyToClone(
+      IPatcher& patcher,
+      std::span<const AsyncPatcher::Range> ranges,
+      const std::filesystem::path& source,
+      const std::filesystem::path& output);
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <ppftk/rom_patch/patch_item.h>
+
+#include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/filesystem/mapped_file.h>
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+   // Bump allocator for patch data. Memory is handed out from large blocks
+   // that are only released with the arena, so PatchItem views into it stay
+   // valid for the arena's lifetime, including across moves.
+   class [[nodiscard]] PatchArena
+   {
+   public:
+      PatchArena() noexcept;
+      ~PatchArena() = default;
+
+      // The moved-from arena is empty, and allocates blocks of its own.
+      PatchArena(PatchArena&& other) noexcept;
+      PatchArena& operator=(PatchArena&& other) noexcept;
+
+      // Guarantees the next 'bytes' worth of allocations are served from a
+      // single block.
+      void Reserve(const size_t bytes);
+
+      [[nodiscard]] std::span<uint8_t> Allocate(const size_t bytes);
+      [[nodiscard]] DataView Copy(const DataView data);
+
+      // Keeps 'file' mapped for the arena's lifetime, so items can point
+      // straight into it instead of into a copy.
+      void Adopt(base::fs::MappedFile&& file);
+
+      [[nodiscard]] size_t BlockCount() const noexcept;
+
+   private:
+      std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+      uint8_t* m_next;
+      size_t m_available;
+      std::vector<base::fs::MappedFile> m_files;
+
+      TDD_DISABLE_COPY(PatchArena);
+   };
+
+}
\ No newline at end of file
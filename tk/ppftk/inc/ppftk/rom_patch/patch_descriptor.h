@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ppftk/rom_patch/patch_arena.h>
 #include <ppftk/rom_patch/patch_item.h>
 
 #include <ppfbase/preprocessor_utils.h>
@@ -11,28 +12,40 @@
 
 namespace tdd::tk::rompatch {
 
+   // Patch data is stored in a single PatchArena owned by the descriptor. The
+   // items of the full patch are views into it, so the arena has to be taken
+   // along with the items by anything that outlives the descriptor.
    class [[nodiscard]] PatchDescriptor
    {
    public:
-      using ValidationData = PatchItem;
+      struct [[nodiscard]] ValidationData
+      {
+         uint64_t address = 0;
+         DataBuffer data;
+      };
+
       using FullPatch = std::vector<PatchItem>;
 
-      TDD_DEFAULT_ALL_SPECIAL_MEMBERS(PatchDescriptor);
+      TDD_DEFAULT_CTOR_DTOR(PatchDescriptor);
+      TDD_DEFAULT_MOVE(PatchDescriptor);
 
       void Compact();
       [[nodiscard]] bool Compact(
          std::ifstream& targetImage,
          std::optional<size_t> gapSizeToFillOverride = std::nullopt);
 
-      [[nodiscard]] bool AddPatchData(
-         const size_t address,
-         const DataBuffer& data);
+      // Pre-sizes the storage for 'entries' items holding 'bytes' of patch
+      // data in total. With an accurate estimate adding the patch data does
+      // not allocate.
+      void Reserve(const size_t entries, const size_t bytes);
 
+      // 'data' is copied into the descriptor's arena. The items never
+      // overlap. Data overlapping what was added before is merged with it
+      // into one item, with 'data' on top. False if an item already starts
+      // at 'address'.
       [[nodiscard]] bool AddPatchData(
          const size_t address,
-         DataBuffer&& data);
-
-      void SetFullPatch(FullPatch&& patch) noexcept;
+         const DataView data);
 
       void AddValidationData(
          const size_t address,
@@ -54,12 +67,16 @@ namespace tdd::tk::rompatch {
       [[nodiscard]] const std::string& GetDescription() const noexcept;
 
       [[nodiscard]] FullPatch&& TakeFullPatch() && noexcept;
+      [[nodiscard]] PatchArena&& TakeArena() && noexcept;
 
    private:
+      PatchArena m_arena;
       FullPatch m_fullPatch;
       ValidationData m_validationData;
       std::string m_description;
       std::string m_fileId;
+
+      TDD_DISABLE_COPY(PatchDescriptor);
    };
 
 }
\ No newline at end of file
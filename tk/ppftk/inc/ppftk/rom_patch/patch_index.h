@@ -0,0 +1,60 @@
+#pragma once
+
+#include <ppftk/rom_patch/patch_descriptor.h>
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <span>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+   // Immutable lookup structure compiled from a sorted, non-overlapping
+   // FullPatch. Entries are kept as parallel arrays and all payloads live in
+   // one contiguous blob. The search keys are stored in Eytzinger (BFS) order
+   // so that a lookup touches a handful of cache lines regardless of how many
+   // entries the patch has.
+   class [[nodiscard]] PatchIndex
+   {
+   public:
+      PatchIndex() noexcept;
+      explicit PatchIndex(const PatchDescriptor::FullPatch& patches);
+
+      ~PatchIndex() = default;
+      TDD_DEFAULT_COPY_MOVE(PatchIndex);
+
+      [[nodiscard]] bool Empty() const noexcept;
+      [[nodiscard]] size_t Size() const noexcept;
+
+      // [Start(), End()) covers every patched byte.
+      [[nodiscard]] uint64_t Start() const noexcept;
+      [[nodiscard]] uint64_t End() const noexcept;
+
+      // Sorted position of the first entry ending after 'addr'. Size() if
+      // there is none.
+      [[nodiscard]] size_t Find(const uint64_t addr) const noexcept;
+
+      [[nodiscard]] uint64_t EntryStart(const size_t idx) const noexcept;
+      [[nodiscard]] uint64_t EntryEnd(const size_t idx) const noexcept;
+      [[nodiscard]] std::span<const uint8_t> EntryData(
+         const size_t idx) const noexcept;
+
+      // Copies the patch data overlapping [addr, addr + target.size()) into
+      // 'target'.
+      void Apply(const uint64_t addr, std::span<uint8_t> target) const noexcept;
+
+   private:
+      void BuildSearchTree(size_t& sortedIdx, const size_t node) noexcept;
+
+      std::vector<uint64_t> m_starts;
+      std::vector<uint64_t> m_ends;
+      std::vector<size_t> m_offsets;
+      DataBuffer m_payload;
+
+      // 1-based Eytzinger layout of m_ends. Slot 0 is unused.
+      std::vector<uint64_t> m_searchKeys;
+      // Sorted position of each m_searchKeys slot.
+      std::vector<size_t> m_searchRanks;
+   };
+
+}
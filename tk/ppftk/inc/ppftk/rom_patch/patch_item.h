@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <vector>
 
 namespace tdd::tk::rompatch {
 
    using DataBuffer = std::vector<uint8_t>;
 
+   // Non-owning view of patch data. The bytes are owned by whoever produced
+   // the item, usually the PatchArena of a PatchDescriptor.
+   using DataView = std::span<const uint8_t>;
+
    struct [[nodiscard]] PatchItem
    {
       uint64_t address;
-      DataBuffer data;
+      DataView data;
 
       [[nodiscard]] bool operator<(const PatchItem& other) const noexcept
       {
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <ppftk/rom_patch/async_patcher.h>
+#include <ppftk/rom_patch/ipatcher.h>
+
+#include <filesystem>
+#include <memory>
+
+namespace tdd::tk::rompatch {
+
+   // Cheap check for the open hooks: 'file' has one of the configured target
+   // extensions and a patch next to it. Nothing is read.
+   [[nodiscard]] bool IsPatchTarget(const std::filesystem::path& file);
+
+   // Builds the patcher configured for 'target', which needs to be canonical.
+   // CD images go through the patch cache. The patched ranges are announced
+   // before the slow part of the load. nullptr if 'target' isn't patched.
+   [[nodiscard]] std::unique_ptr<IPatcher> LoadPatcher(
+      const std::filesystem::path& target,
+      const AsyncPatcher::Announce& announce);
+
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace tdd::tk::rompatch {
+
+   // Which open handle reads which patched image. Every image gets one
+   // session, shared by all handles open on it, including duplicates.
+   //
+   // Lookups happen on every read of the process. Each thread keeps the
+   // immutable snapshot of the map it looked up last and checks it against
+   // the generation counter. It only locks to fetch the current snapshot, once
+   // after every change. Opens and closes change the map under a lock and
+   // publish a new snapshot with a new generation. A session outlives its
+   // last handle for as long as a read still holds on to it. Snapshots only
+   // refer to it weakly, so a thread that stopped reading doesn't keep it
+   // alive.
+   template <typename Handle, typename Session>
+   class [[nodiscard]] PatchSessions
+   {
+   public:
+      using SessionPtr = std::shared_ptr<Session>;
+      using Create = std::function<SessionPtr()>;
+
+      PatchSessions()
+         : m_writeLock()
+         , m_handles()
+         , m_snapshotLock()
+         , m_snapshot(std::make_shared<const Snapshot>())
+         , m_generation(m_snapshot->generation)
+         , m_size(0)
+      {}
+
+      ~PatchSessions() = default;
+      TDD_DISABLE_COPY_MOVE(PatchSessions);
+
+      // nullptr unless 'handle' is open on a patched image.
+      [[nodiscard]] SessionPtr Find(const Handle handle) const
+      {
+         if (0 == m_size.load(std::memory_order_acquire)) {
+            return nullptr;
+         }
+
+         // Generations are unique across instances, so a match also means
+         // the snapshot is one of ours.
+         thread_local std::shared_ptr<const Snapshot> cached;
+         const auto generation = m_generation.load(std::memory_order_acquire);
+         if (nullptr == cached || cached->generation != generation) {
+            std::lock_guard lock(m_snapshotLock);
+            cached = m_snapshot;
+         }
+
+         const auto entry = cached->sessions.find(handle);
+         return entry == cached->sessions.end() ? nullptr
+                                                : entry->second.lock();
+      }
+
+      // Registers 'handle' as open on 'image'. 'create' is only called if no
+      // other handle has 'image' open. Images are compared by path, so
+      // 'image' should be absolute and normalized. Whatever 'handle' was
+      // registered with before is replaced, its close went unnoticed.
+      SessionPtr Open(
+         const Handle handle,
+         const std::filesystem::path& image,
+         const Create& create)
+      {
+         std::lock_guard lock(m_writeLock);
+
+         SessionPtr session;
+         for (const auto& [openHandle, entry] : m_handles) {
+            if (openHandle != handle && entry.image == image) {
+               session = entry.session;
+               break;
+            }
+         }
+
+         if (nullptr == session) {
+            session = create();
+            if (nullptr == session) {
+               return nullptr;
+            }
+         }
+
+         m_handles.insert_or_assign(
+            handle,
+            Entry{.image = image, .session = session});
+         Publish();
+         return session;
+      }
+
+      // 'copy' now refers to the same file as 'source'. nullptr, and 'copy'
+      // isn't registered, if 'source' isn't.
+      SessionPtr Duplicate(const Handle source, const Handle copy)
+      {
+         std::lock_guard lock(m_writeLock);
+
+         const auto entry = m_handles.find(source);
+         if (entry == m_handles.end()) {
+            if (0 != m_handles.erase(copy)) {
+               Publish();
+            }
+            return nullptr;
+         }
+
+         auto duplicate = entry->second;
+         m_handles.insert_or_assign(copy, duplicate);
+         Publish();
+         return duplicate.session;
+      }
+
+      // False if 'handle' wasn't registered.
+      bool Close(const Handle handle)
+      {
+         if (0 == m_size.load(std::memory_order_acquire)) {
+            return false;
+         }
+
+         std::lock_guard lock(m_writeLock);
+         if (0 == m_handles.erase(handle)) {
+            return false;
+         }
+
+         Publish();
+         return true;
+      }
+
+      // Number of registered handles.
+      [[nodiscard]] size_t Size() const noexcept
+      {
+         return m_size.load(std::memory_order_relaxed);
+      }
+
+   private:
+      struct [[nodiscard]] Entry
+      {
+         std::filesystem::path image;
+         SessionPtr session;
+      };
+
+      struct [[nodiscard]] Snapshot
+      {
+         uint64_t generation = NextGeneration();
+         std::unordered_map<Handle, std::weak_ptr<Session>> sessions;
+      };
+
+      [[nodiscard]] static uint64_t NextGeneration() noexcept
+      {
+         static std::atomic<uint64_t> generations = 0;
+         return generations.fetch_add(1, std::memory_order_relaxed) + 1;
+      }
+
+      // Only called with m_writeLock held. The snapshot is stored before its
+      // generation, so a thread that sees the generation finds the snapshot,
+      // or a newer one.
+      void Publish()
+      {
+         auto snapshot = std::make_shared<Snapshot>();
+         for (const auto& [handle, entry] : m_handles) {
+            snapshot->sessions.emplace(handle, entry.session);
+         }
+
+         const auto generation = snapshot->generation;
+         {
+            std::lock_guard lock(m_snapshotLock);
+            m_snapshot = std::move(snapshot);
+         }
+         m_generation.store(generation, std::memory_order_release);
+         m_size.store(m_handles.size(), std::memory_order_release);
+      }
+
+      std::mutex m_writeLock;
+      // Owns the sessions. Only used with m_writeLock held.
+      std::unordered_map<Handle, Entry> m_handles;
+
+      // Only taken by the threads whose snapshot is out of date.
+      mutable std::mutex m_snapshotLock;
+      std::shared_ptr<const Snapshot> m_snapshot;
+      std::atomic<uint64_t> m_generation;
+      std::atomic<size_t> m_size;
+   };
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <ppfbase/preprocessor_utils.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+   // Asynchronous reads of a patched file that haven't completed yet. A read
+   // is registered under whatever the caller will complete it with, e.g. its
+   // OVERLAPPED, and taken back out once, when the completion is seen. The
+   // data is patched at that point.
+   //
+   // 'Context' carries whatever else the hook needs at completion time.
+   template <typename Context>
+   class [[nodiscard]] PendingReads
+   {
+   public:
+      struct [[nodiscard]] Read
+      {
+         uint64_t addr;
+         std::span<uint8_t> buffer;
+         Context context;
+      };
+
+      PendingReads() = default;
+      ~PendingReads() = default;
+      TDD_DISABLE_COPY_MOVE(PendingReads);
+
+      // Replaces a read still registered under 'key'. Callers may reuse the
+      // key for a new read without the completion of the old one ever
+      // passing through a hook.
+      void Add(const void* key, Read&& read)
+      {
+         std::lock_guard lock(m_lock);
+         if (m_reads.insert_or_assign(key, std::move(read)).second) {
+            m_size.fetch_add(1, std::memory_order_release);
+         }
+      }
+
+      // std::nullopt if nothing is registered under 'key'. Doesn't lock while
+      // there are no reads in flight, every completion of the process may
+      // come through here.
+      [[nodiscard]] std::optional<Read> Take(const void* key)
+      {
+         if (0 == m_size.load(std::memory_order_acquire)) {
+            return std::nullopt;
+         }
+
+         std::lock_guard lock(m_lock);
+         const auto read = m_reads.find(key);
+         if (read == m_reads.end()) {
+            return std::nullopt;
+         }
+
+         auto taken = std::move(read->second);
+         m_reads.erase(read);
+         m_size.fetch_sub(1, std::memory_order_relaxed);
+         return taken;
+      }
+
+      // Drops every read 'pred' returns true for, e.g. the reads of a file
+      // that is closed. Returns how many were dropped. Their contexts are
+      // destroyed after the lock is released.
+      template <typename Predicate>
+      size_t EraseIf(Predicate&& pred)
+      {
+         if (0 == m_size.load(std::memory_order_acquire)) {
+            return 0;
+         }
+
+         std::vector<Read> dropped;
+         {
+            std::lock_guard lock(m_lock);
+            for (auto read = m_reads.begin(); read != m_reads.end();) {
+               if (pred(std::as_const(read->second))) {
+                  dropped.push_back(std::move(read->second));
+                  read = m_reads.erase(read);
+               }
+               else {
+                  ++read;
+               }
+            }
+            m_size.fetch_sub(dropped.size(), std::memory_order_relaxed);
+         }
+
+         return dropped.size();
+      }
+
+      [[nodiscard]] size_t Size() const noexcept
+      {
+         return m_size.load(std::memory_order_relaxed);
+      }
+
+   private:
+      std::mutex m_lock;
+      std::unordered_map<const void*, Read> m_reads;
+      std::atomic<size_t> m_size = 0;
+   };
+
+}
\ No newline at end of file
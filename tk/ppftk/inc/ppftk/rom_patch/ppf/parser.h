@@ -4,9 +4,14 @@
 
 #include <filesystem>
 #include <optional>
+#include <span>
 
 namespace tdd::tk::rompatch::ppf {
 
+   // Maps the file when possible and falls back to reading it into memory.
    std::optional<PatchDescriptor> Parse(const std::filesystem::path& ppf);
 
+   // 'ppf' holds the whole patch file.
+   std::optional<PatchDescriptor> Parse(std::span<const uint8_t> ppf);
+
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <ppfbase/filesystem/mapped_file.h>
+#include <ppfbase/preprocessor_utils.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+   // A trace file is a ReadTraceHeader followed by 'capacity'
+   // ReadTraceRecords. Bump kVersion whenever the layout or the meaning of a
+   // field changes.
+   struct [[nodiscard]] ReadTraceHeader
+   {
+      static constexpr std::array<char, 8> kMagic =
+         {'P', 'P', 'F', 'T', 'R', 'A', 'C', 'E'};
+      static constexpr uint32_t kVersion = 1;
+
+      std::array<char, 8> magic;
+      uint32_t version;
+      uint32_t recordSize;
+      // A power of 2.
+      uint64_t capacity;
+      // Unix time of 'time' 0 in the records, in nanoseconds.
+      int64_t startTime;
+      uint32_t processId;
+      uint32_t reserved;
+      // Records claimed so far. Only ever incremented atomically.
+      uint64_t next;
+      std::array<uint8_t, 16> padding;
+   };
+
+   // One read of a patch target.
+   struct [[nodiscard]] ReadTraceRecord
+   {
+      // Number of the record, starting at 1. 0 while it is being written.
+      uint64_t sequence;
+      // Nanoseconds since the trace started, taken before the read.
+      uint64_t time;
+      // Where the read started in the target.
+      uint64_t offset;
+      uint32_t threadId;
+      uint32_t length;
+      // Bytes of the read in patched blocks, e.g. CD sectors.
+      uint32_t patchedBytes;
+      // Reads the patcher needed on top to complete the blocks at the edges.
+      uint32_t extraReads;
+      // Nanoseconds the read itself took, and patching it afterwards.
+      uint32_t readTime;
+      uint32_t patchTime;
+      std::array<uint8_t, 16> reserved;
+   };
+
+   static_assert(sizeof(ReadTraceHeader) == 64);
+   static_assert(sizeof(ReadTraceRecord) == 64);
+
+   // Binary trace of the reads of patch targets, cheap enough to leave on.
+   // Every read takes one record in a ring in a file mapped into memory.
+   // Nothing is formatted and nothing is written by the reading thread, the
+   // page cache takes the records to disk, even if the process crashes. Record
+   // N goes to slot N % capacity, so the file holds the most recent reads.
+   class [[nodiscard]] ReadTrace
+   {
+   public:
+      using Clock = std::chrono::steady_clock;
+
+      struct [[nodiscard]] Read
+      {
+         uint64_t offset;
+         uint64_t length;
+         uint64_t patchedBytes;
+         uint32_t extraReads;
+         // Before the read was issued, once it returned and once it was
+         // patched.
+         Clock::time_point start;
+         Clock::time_point read;
+         Clock::time_point patched;
+      };
+
+      // What a trace file holds. Records oldest first.
+      struct [[nodiscard]] Contents
+      {
+         ReadTraceHeader header;
+         std::vector<ReadTraceRecord> records;
+      };
+
+      // Replaces 'file' with an empty trace. 'records' is rounded up to a
+      // power of 2, at least 2.
+      [[nodiscard]] static std::unique_ptr<ReadTrace> Create(
+         const std::filesystem::path& file,
+         const uint32_t records);
+
+      // '<module>.<process>.<pid>.trace' next to the DLL log.
+      [[nodiscard]] static std::optional<std::filesystem::path>
+         DllTracePath();
+
+      // The file may be loaded while a process still writes to it. Records
+      // that are being written while they are copied are left out.
+      [[nodiscard]] static std::optional<Contents> Load(
+         const std::filesystem::path& file);
+
+      ~ReadTrace() = default;
+      TDD_DISABLE_COPY_MOVE(ReadTrace);
+
+      // Lock free. Any number of threads may add reads at once.
+      void Add(const Read& read) noexcept;
+
+      [[nodiscard]] uint64_t Capacity() const noexcept;
+
+   private:
+      ReadTrace(
+         base::fs::WritableMappedFile&& file,
+         const Clock::time_point start) noexcept;
+
+      base::fs::WritableMappedFile m_file;
+      ReadTraceHeader& m_header;
+      ReadTraceRecord* m_records;
+      uint64_t m_mask;
+      Clock::time_point m_start;
+   };
+
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <ppftk/rom_patch/ipatcher.h>
 #include <ppftk/rom_patch/patch_descriptor.h>
+#include <ppftk/rom_patch/patch_index.h>
 
 #include <ppfbase/preprocessor_utils.h>
 
@@ -10,7 +11,7 @@ namespace tdd::tk::rompatch {
    class [[nodiscard]] SimplePatcher : public IPatcher
    {
    public:
-      SimplePatcher(PatchDescriptor&& fullPatch) noexcept;
+      SimplePatcher(PatchDescriptor&& fullPatch);
 
       TDD_DEFAULT_ALL_SPECIAL_MEMBERS(SimplePatcher);
 
@@ -18,13 +19,16 @@ namespace tdd::tk::rompatch {
          const uint64_t addr,
          std::span<uint8_t> buffer) override;
 
+      [[nodiscard]] uint64_t PatchedBytes(
+         const uint64_t addr,
+         const uint64_t size) const noexcept override;
+
    private:
       [[nodiscard]] bool Overlaps(
          const uint64_t tgtStart,
          const uint64_t tgtEnd) const noexcept;
 
-      PatchDescriptor::FullPatch m_patches;
-      std::pair<uint64_t, uint64_t> m_addrRange;
+      PatchIndex m_index;
 
    };
 }
\ No newline at end of file
@@ -17,6 +17,11 @@ const base::logging::Severity LogLevel() noexcept
    return GetInstance().LogLevel();
 }
 
+const base::logging::ArchivePolicy& LogArchivePolicy() noexcept
+{
+   return GetInstance().LogArchivePolicy();
+}
+
 const std::filesystem::path& Emulator() noexcept
 {
    return GetInstance().Emulator();
@@ -37,4 +42,9 @@ const std::set<std::string>& TargetExts() noexcept
    return GetInstance().TargetExts();
 }
 
+uint32_t ReadTraceRecords() noexcept
+{
+   return GetInstance().ReadTraceRecords();
+}
+
 }
\ No newline at end of file
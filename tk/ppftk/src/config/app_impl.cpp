@@ -7,6 +7,7 @@
 
 #include <json/json.h>
 
+#include <chrono>
 #include <fstream>
 
 namespace tdd::tk::config::details {
@@ -16,7 +17,9 @@ namespace {
 
    namespace schema {
       static constexpr auto kConfigFileName = L"ppfinjector.json";
-      static const std::set<std::string> kDefaultExts{
+      // Constant initialized. The preload library reads the config from its
+      // constructor, possibly before the dynamic initializers of this file.
+      static constexpr const char* kDefaultExts[] = {
          ".bin"
       };
 
@@ -24,8 +27,79 @@ namespace {
       static constexpr auto kEmulator = "emulator";
       // int.
       static constexpr auto kLogLevel = "log_level";
+      // object. Every member is optional, 0 turns a limit off.
+      static constexpr auto kLogArchive = "log_archive";
+      // uint.
+      static constexpr auto kMaxFileMb = "max_file_mb";
+      // uint. Rotates at every multiple of it since midnight UTC.
+      static constexpr auto kRotateHours = "rotate_hours";
+      // uint.
+      static constexpr auto kMaxArchives = "max_archives";
+      // uint.
+      static constexpr auto kMaxArchiveDays = "max_archive_days";
+      // uint. All archives together, uncompressed.
+      static constexpr auto kMaxArchiveMb = "max_archive_mb";
+      // bool.
+      static constexpr auto kCompress = "compress";
       // array of strings
       static constexpr auto kTargetExts = "target_extensions";
+      // uint. 0 turns the read trace off.
+      static constexpr auto kReadTraceRecords = "read_trace_records";
+   }
+
+   static constexpr uint64_t kMb = 1024 * 1024;
+
+   [[nodiscard]] Json::Value ToJson(const base::logging::ArchivePolicy& policy)
+   {
+      Json::Value json;
+      json[schema::kMaxFileMb] = Json::UInt64(policy.maxFileBytes / kMb);
+      json[schema::kRotateHours] = Json::UInt64(
+         std::chrono::duration_cast<std::chrono::hours>(
+            policy.rotationInterval).count());
+      json[schema::kMaxArchives] = policy.maxArchives;
+      json[schema::kMaxArchiveDays] = Json::UInt64(
+         std::chrono::duration_cast<std::chrono::days>(
+            policy.maxArchiveAge).count());
+      json[schema::kMaxArchiveMb] = Json::UInt64(policy.maxArchiveBytes / kMb);
+      json[schema::kCompress] = policy.compress;
+      return json;
+   }
+
+   void FromJson(
+      const Json::Value& json,
+      base::logging::ArchivePolicy& policy)
+   {
+      if (!json.isObject()) {
+         TDD_LOG_ERROR() << "Invalid " << schema::kLogArchive << ": "
+            << json.toStyledString();
+         return;
+      }
+
+      if (json.isMember(schema::kMaxFileMb)) {
+         policy.maxFileBytes = json[schema::kMaxFileMb].asUInt64() * kMb;
+      }
+
+      if (json.isMember(schema::kRotateHours)) {
+         policy.rotationInterval = std::chrono::hours(
+            json[schema::kRotateHours].asUInt());
+      }
+
+      if (json.isMember(schema::kMaxArchives)) {
+         policy.maxArchives = json[schema::kMaxArchives].asUInt();
+      }
+
+      if (json.isMember(schema::kMaxArchiveDays)) {
+         policy.maxArchiveAge = std::chrono::days(
+            json[schema::kMaxArchiveDays].asUInt());
+      }
+
+      if (json.isMember(schema::kMaxArchiveMb)) {
+         policy.maxArchiveBytes = json[schema::kMaxArchiveMb].asUInt64() * kMb;
+      }
+
+      if (json.isMember(schema::kCompress)) {
+         policy.compress = json[schema::kCompress].asBool();
+      }
    }
 
    [[nodiscard]] fs::path ConfigPath()
@@ -62,7 +136,14 @@ namespace {
       }
 
       json[schema::kLogLevel] = static_cast<int>(config.LogLevel());
+      if (config.LogArchivePolicy() != base::logging::kDefaultArchivePolicy) {
+         json[schema::kLogArchive] = ToJson(config.LogArchivePolicy());
+      }
       json[schema::kTargetExts] = exts;
+      if (0 != config.ReadTraceRecords()) {
+         json[schema::kReadTraceRecords] = config.ReadTraceRecords();
+      }
+
       return json;
    }
 
@@ -104,8 +185,12 @@ namespace {
 
 AppImpl::AppImpl()
    : m_emulator()
-   , m_targetExts(schema::kDefaultExts)
+   , m_targetExts(
+      std::begin(schema::kDefaultExts),
+      std::end(schema::kDefaultExts))
    , m_logLevel(base::logging::Severity::Info)
+   , m_logArchive(base::logging::kDefaultArchivePolicy)
+   , m_readTraceRecords(0)
 {
    try {
       Load();
@@ -120,6 +205,11 @@ const base::logging::Severity AppImpl::LogLevel() const noexcept
    return m_logLevel;
 }
 
+const base::logging::ArchivePolicy& AppImpl::LogArchivePolicy() const noexcept
+{
+   return m_logArchive;
+}
+
 const std::filesystem::path& AppImpl::Emulator() const noexcept
 {
    return m_emulator;
@@ -143,6 +233,11 @@ const std::set<std::string>& AppImpl::TargetExts() const noexcept
    return m_targetExts;
 }
 
+uint32_t AppImpl::ReadTraceRecords() const noexcept
+{
+   return m_readTraceRecords;
+}
+
 void AppImpl::Load()
 {
    const auto config = ParseConfig();
@@ -166,6 +261,10 @@ void AppImpl::Load()
          config[schema::kLogLevel].asInt());
    }
 
+   if (config.isMember(schema::kLogArchive)) {
+      FromJson(config[schema::kLogArchive], m_logArchive);
+   }
+
    if (config.isMember(schema::kTargetExts)) {
       const auto extsArray = config[schema::kTargetExts];
       for (const auto& item : extsArray) {
@@ -175,6 +274,10 @@ void AppImpl::Load()
          }
       }
    }
+
+   if (config.isMember(schema::kReadTraceRecords)) {
+      m_readTraceRecords = config[schema::kReadTraceRecords].asUInt();
+   }
 }
 
 
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <ppfbase/preprocessor_utils.h>
+#include <ppfbase/logging/archive_policy.h>
 #include <ppfbase/logging/severity.h>
 
+#include <cstdint>
 #include <filesystem>
 #include <set>
 #include <string>
@@ -17,6 +19,7 @@ namespace tdd::tk::config::details {
       TDD_DEFAULT_COPY_MOVE(AppImpl);
 
       const base::logging::Severity LogLevel() const noexcept;
+      const base::logging::ArchivePolicy& LogArchivePolicy() const noexcept;
 
       const std::filesystem::path& Emulator() const noexcept;
       void Emulator(const std::filesystem::path& emulator);
@@ -24,12 +27,16 @@ namespace tdd::tk::config::details {
 
       const std::set<std::string>& TargetExts() const noexcept;
 
+      uint32_t ReadTraceRecords() const noexcept;
+
    private:
       void Load();
 
       std::filesystem::path m_emulator;
       std::set<std::string> m_targetExts;
       base::logging::Severity m_logLevel;
+      base::logging::ArchivePolicy m_logArchive;
+      uint32_t m_readTraceRecords;
    };
 
 }
\ No newline at end of file
@@ -4,13 +4,12 @@
 
 #include <ppfbase/logging/logging.h>
 #include <ppfbase/stdext/poor_mans_expected.h>
+#include <ppfbase/stdext/win32_error_codes.h>
 
 #include <json/json.h>
 
 #include <fstream>
 
-#include <Windows.h>
-
 namespace tdd::tk::config {
 
 namespace {
@@ -21,6 +20,8 @@ namespace {
       constexpr auto kCalculateEdc = "calculate_edc";
    }
 
+   constexpr auto kConfigExt = L".piconf";
+
    stdext::pm_expected<Json::Value> ParseConfig(
       const std::filesystem::path& config)
    {
@@ -75,8 +76,6 @@ namespace {
 
    std::tuple<fs::path, bool> BuildConfig(const fs::path& target)
    {
-      static constexpr auto kConfigExt = L".piconf";
-
       auto configPath = target;
       configPath.replace_extension(kConfigExt);
       const auto config = ParseConfig(configPath);
@@ -102,6 +101,17 @@ Patch::Patch(const std::filesystem::path& target)
    std::tie(m_patch, m_calculateEdc) = BuildConfig(target);
 }
 
+bool Patch::Exists(const std::filesystem::path& target)
+{
+   std::error_code ec;
+   auto sidecar = target;
+   if (fs::exists(sidecar.replace_extension(kConfigExt), ec)) {
+      return true;
+   }
+
+   return fs::exists(sidecar.replace_extension(rompatch::exts::kPpf), ec);
+}
+
 const std::filesystem::path& Patch::PatchFile() const noexcept
 {
    return m_patch;
@@ -0,0 +1,151 @@
+#include <ppftk/rom_patch/async_patcher.h>
+
+#include <ppfbase/logging/logging.h>
+
+#include <algorithm>
+
+namespace tdd::tk::rompatch {
+
+AsyncPatcher::AsyncPatcher(Loader loader)
+   : m_ranges()
+   , m_patcher()
+   , m_state(State::Loading)
+   , m_loader(&AsyncPatcher::Load, this, std::move(loader))
+{}
+
+std::optional<IPatcher::AdditionalReads> AsyncPatcher::Patch(
+   const uint64_t addr,
+   std::span<uint8_t> buffer)
+{
+   auto state = m_state.load(std::memory_order_acquire);
+   if (state != State::Ready) {
+      state = WaitFor(State::Announced);
+   }
+
+   if (state == State::Announced) {
+      if (!Overlaps(addr, buffer.size())) {
+         return std::nullopt;
+      }
+
+      TDD_LOG_DEBUG() << "Read at [" << addr << "] waits for the patch";
+      // Ready is the last state. There is nothing else it could return.
+      (void)WaitFor(State::Ready);
+   }
+
+   if (nullptr == m_patcher) {
+      return std::nullopt;
+   }
+
+   return m_patcher->Patch(addr, buffer);
+}
+
+bool AsyncPatcher::Wait() const noexcept
+{
+   return WaitFor(State::Ready) == State::Ready && nullptr != m_patcher;
+}
+
+uint64_t AsyncPatcher::PatchedBytes(
+   const uint64_t addr,
+   const uint64_t size) const noexcept
+{
+   const auto state = m_state.load(std::memory_order_acquire);
+   if (state == State::Ready) {
+      return nullptr != m_patcher ? m_patcher->PatchedBytes(addr, size) : 0;
+   }
+
+   if (state == State::Loading) {
+      return 0;
+   }
+
+   const auto end = addr + size;
+   auto range = std::upper_bound(
+      m_ranges.begin(),
+      m_ranges.end(),
+      addr,
+      [](const uint64_t value, const Range& r) { return value < r.end; });
+
+   uint64_t bytes = 0;
+   for (; range != m_ranges.end() && range->start < end; ++range) {
+      bytes += std::min(range->end, end) - std::max(range->start, addr);
+   }
+
+   return bytes;
+}
+
+AsyncPatcher::Ranges AsyncPatcher::CoveredRanges(
+   const PatchDescriptor::FullPatch& patches,
+   const uint64_t blockSize)
+{
+   Ranges ranges;
+   for (const auto& p : patches) {
+      if (p.data.empty()) {
+         continue;
+      }
+
+      const auto start = p.address / blockSize * blockSize;
+      const auto end = p.address + p.data.size();
+      const Range block{
+         .start = start,
+         .end = (end + blockSize - 1) / blockSize * blockSize};
+
+      if (!ranges.empty() && ranges.back().end >= block.start) {
+         ranges.back().end = std::max(ranges.back().end, block.end);
+         continue;
+      }
+
+      ranges.push_back(block);
+   }
+   return ranges;
+}
+
+void AsyncPatcher::Load(Loader loader)
+{
+   auto patcher = loader([this](Ranges&& ranges) {
+      SetRanges(std::move(ranges));
+   });
+
+   m_patcher = std::move(patcher);
+   Publish(State::Ready);
+}
+
+void AsyncPatcher::SetRanges(Ranges&& ranges)
+{
+   TDD_DCHECK(
+      m_state.load(std::memory_order_relaxed) == State::Loading,
+      "Patched ranges announced twice");
+
+   m_ranges = std::move(ranges);
+   Publish(State::Announced);
+}
+
+void AsyncPatcher::Publish(const State state) noexcept
+{
+   m_state.store(state, std::memory_order_release);
+   m_state.notify_all();
+}
+
+AsyncPatcher::State AsyncPatcher::WaitFor(const State state) const noexcept
+{
+   auto current = m_state.load(std::memory_order_acquire);
+   while (current < state) {
+      m_state.wait(current, std::memory_order_acquire);
+      current = m_state.load(std::memory_order_acquire);
+   }
+   return current;
+}
+
+bool AsyncPatcher::Overlaps(
+   const uint64_t addr,
+   const uint64_t size) const noexcept
+{
+   // First range ending after 'addr'.
+   const auto range = std::upper_bound(
+      m_ranges.begin(),
+      m_ranges.end(),
+      addr,
+      [](const uint64_t value, const Range& r) { return value < r.end; });
+
+   return range != m_ranges.end() && range->start < addr + size;
+}
+
+}
\ No newline at end of file
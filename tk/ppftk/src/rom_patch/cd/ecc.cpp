@@ -0,0 +1,148 @@
+#include <ppftk/rom_patch/cd/ecc.h>
+
+#include <ppfbase/stdext/cstring.h>
+
+#include <array>
+#include <cstdint>
+
+namespace tdd::tk::rompatch::cd::ecc {
+
+namespace {
+   // The RSPC covers everything from the header up to the P parity, viewed
+   // as 16-bit words. The two bytes of a word belong to separate codewords,
+   // so byte offsets are used throughout and the MSB and LSB codewords are
+   // simply neighbours.
+   static constexpr size_t kEccBlockStart = sizeof(spec::Sector::sync);
+
+   // P: 43 columns of 24 words. Step 'n' of every P codeword is row 'n' of
+   // the block, i.e. 86 consecutive bytes.
+   static constexpr size_t kPRowSize = 86;
+   static constexpr size_t kPRows = 24;
+
+   // Q: 26 diagonals of 43 words over the block and the P parity. Every step
+   // moves one row and one column, i.e. 88 bytes, and wraps around.
+   static constexpr size_t kQRowSize = 52;
+   static constexpr size_t kQLength = 43;
+   static constexpr size_t kQStep = kPRowSize + 2;
+   static constexpr size_t kQBlockSize = kQRowSize * kQLength;
+
+   static_assert(kPRowSize * 2 == spec::kEccPSize);
+   static_assert(kQRowSize * 2 == spec::kEccQSize);
+   static_assert(kQBlockSize == kPRowSize * kPRows + spec::kEccPSize);
+
+   // GF(2^8) with the field polynomial x^8 + x^4 + x^3 + x^2 + 1.
+   [[nodiscard]] constexpr uint8_t MultiplyByAlpha(const uint8_t value)
+   {
+      // Branchless so that it vectorises.
+      return static_cast<uint8_t>((value << 1) ^ ((value >> 7) * 0x1D));
+   }
+
+   using GfTable = std::array<uint8_t, 256>;
+
+   // Inverse of 'v -> v * (alpha + 1)'. Solves the last step of the parity
+   // equations.
+   consteval GfTable CompileDivideByAlphaPlusOne()
+   {
+      GfTable table{0};
+      for (uint32_t i = 0; i < table.size(); ++i) {
+         const auto v = static_cast<uint8_t>(i);
+         table[v ^ MultiplyByAlpha(v)] = v;
+      }
+      return table;
+   }
+
+   static constexpr auto kDivideByAlphaPlusOne = CompileDivideByAlphaPlusOne();
+
+   // Byte offsets within the ECC block of step 'n' of every Q codeword.
+   using QLayout = std::array<std::array<uint16_t, kQRowSize>, kQLength>;
+
+   consteval QLayout CompileQLayout()
+   {
+      QLayout layout{};
+      for (size_t step = 0; step < kQLength; ++step) {
+         for (size_t codeword = 0; codeword < kQRowSize; ++codeword) {
+            const auto start = (codeword / 2) * kPRowSize + (codeword % 2);
+            layout[step][codeword] = static_cast<uint16_t>(
+               (start + step * kQStep) % kQBlockSize);
+         }
+      }
+      return layout;
+   }
+
+   static constexpr auto kQLayout = CompileQLayout();
+
+   // Accumulates the two syndromes of 'RowSize' codewords in parallel. The
+   // loops have no cross-lane dependencies, so they vectorise.
+   template <size_t RowSize>
+   class [[nodiscard]] ParityAccumulator
+   {
+   public:
+      using Row = std::array<uint8_t, RowSize>;
+
+      // 'row' is a copy rather than a pointer into the sector so that the
+      // compiler can tell it does not alias the accumulators.
+      void Add(const Row& row) noexcept
+      {
+         for (size_t i = 0; i < RowSize; ++i) {
+            m_a[i] = MultiplyByAlpha(m_a[i] ^ row[i]);
+            m_b[i] ^= row[i];
+         }
+      }
+
+      // The two parity bytes of codeword 'i' go to parity[i] and
+      // parity[RowSize + i].
+      void Finish(uint8_t* parity) const noexcept
+      {
+         for (size_t i = 0; i < RowSize; ++i) {
+            const auto a =
+               kDivideByAlphaPlusOne[MultiplyByAlpha(m_a[i]) ^ m_b[i]];
+            parity[i] = a;
+            parity[RowSize + i] = a ^ m_b[i];
+         }
+      }
+
+   private:
+      Row m_a{};
+      Row m_b{};
+   };
+
+   void CalculateEcc(spec::Sector* sector) noexcept
+   {
+      auto block = reinterpret_cast<uint8_t*>(sector) + kEccBlockStart;
+
+      using P = ParityAccumulator<kPRowSize>;
+      P p;
+      P::Row row;
+      for (size_t i = 0; i < kPRows; ++i) {
+         memcpy_s(row.data(), row.size(), block + i * kPRowSize, row.size());
+         p.Add(row);
+      }
+      p.Finish(block + kPRows * kPRowSize);
+
+      using Q = ParityAccumulator<kQRowSize>;
+      Q q;
+      Q::Row step;
+      for (const auto& offsets : kQLayout) {
+         for (size_t i = 0; i < kQRowSize; ++i) {
+            step[i] = block[offsets[i]];
+         }
+         q.Add(step);
+      }
+      q.Finish(block + kQBlockSize);
+   }
+}
+
+void CalculateMode1Ecc(spec::Sector* sector) noexcept
+{
+   CalculateEcc(sector);
+}
+
+void CalculateXaForm1Ecc(spec::Sector* sector) noexcept
+{
+   const auto header = sector->header.full;
+   sector->header.full = 0;
+   CalculateEcc(sector);
+   sector->header.full = header;
+}
+
+}
\ No newline at end of file
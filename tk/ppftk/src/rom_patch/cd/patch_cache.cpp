@@ -0,0 +1,380 @@
+#include <ppftk/rom_patch/cd/patch_cache.h>
+
+#include <ppftk/rom_patch/cd/spec.h>
+
+#include <ppfbase/algorithm/crc32.h>
+#include <ppfbase/filesystem/mapped_file.h>
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/process/this_process.h>
+#include <ppfbase/stdext/system_error.h>
+#include <ppfbase/stdext/win32_error_codes.h>
+
+#include <array>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace tdd::tk::rompatch::cd::PatchCache {
+
+namespace {
+   namespace fs = std::filesystem;
+   namespace crc = base::algorithm::crc32;
+
+   // Layout, all little endian and 8 byte aligned:
+   //
+   //    Header
+   //    SectorRecord[sectorCount]
+   //    ItemRecord[itemCount]
+   //    payload[payloadSize]
+   //
+   // Every offset is relative to the start of the payload, so the file can be
+   // mapped anywhere and used in place.
+   //
+   // Bump kVersion whenever the layout or the meaning of a field changes.
+   inline constexpr std::array<char, 8> kMagic =
+      {'P', 'P', 'F', 'C', 'A', 'C', 'H', 'E'};
+   inline constexpr uint32_t kVersion = 1;
+
+   inline constexpr auto kCacheExt = L".ppfcache";
+
+   // The whole image is too big to checksum on every launch. Its first 17
+   // sectors hold the system area and the primary volume descriptor, which
+   // identify the disc well enough together with the size and the time.
+   inline constexpr size_t kImageCrcBytes = 17 * spec::kSectorSize;
+
+   struct [[nodiscard]] Fingerprint
+   {
+      uint64_t size;
+      int64_t lastWrite;
+      uint32_t crc;
+      uint32_t reserved;
+
+      [[nodiscard]] bool operator==(const Fingerprint&) const = default;
+   };
+
+   struct [[nodiscard]] Header
+   {
+      std::array<char, 8> magic;
+      uint32_t version;
+      uint32_t headerSize;
+      Fingerprint ppf;
+      Fingerprint image;
+      uint64_t sectorCount;
+      uint64_t itemCount;
+      uint64_t payloadSize;
+   };
+
+   struct [[nodiscard]] SectorRecord
+   {
+      uint64_t sector;
+      uint32_t firstItem;
+      uint32_t itemCount;
+      uint64_t checksumsOffset;
+      // SectorPatch::ChecksumsIndex(). 0 if the checksums weren't known.
+      uint32_t checksumsIdx;
+      uint32_t checksumsSize;
+   };
+
+   struct [[nodiscard]] ItemRecord
+   {
+      // Absolute address in the image.
+      uint64_t address;
+      uint64_t dataOffset;
+      uint64_t size;
+   };
+
+   static_assert(sizeof(Fingerprint) == 24);
+   static_assert(sizeof(Header) == 88);
+   static_assert(sizeof(SectorRecord) == 32);
+   static_assert(sizeof(ItemRecord) == 24);
+
+   [[nodiscard]] stdext::pm_expected<Fingerprint> TakeFingerprint(
+      const fs::path& file,
+      const size_t crcBytes)
+   {
+      std::error_code ec;
+      const auto size = fs::file_size(file, ec);
+      if (ec) {
+         return ec;
+      }
+
+      const auto lastWrite = fs::last_write_time(file, ec);
+      if (ec) {
+         return ec;
+      }
+
+      DataBuffer head(static_cast<size_t>(std::min<uint64_t>(size, crcBytes)));
+      std::ifstream stream(file, std::ifstream::binary);
+      stream.read(reinterpret_cast<char*>(head.data()), head.size());
+      if (!stream.good()) {
+         return stdext::make_win32_ec(ERROR_READ_FAULT);
+      }
+
+      static constexpr crc::FoldingTable kCrcTable =
+         crc::CompileFoldingTable(crc::polynomials::kDefault);
+
+      return Fingerprint{
+         .size = size,
+         .lastWrite = lastWrite.time_since_epoch().count(),
+         .crc = crc::ComputeCrc(head, kCrcTable, crc::InitialValue::MinusOne),
+         .reserved = 0};
+   }
+
+   [[nodiscard]] stdext::pm_expected<std::pair<Fingerprint, Fingerprint>>
+      TakeFingerprints(const Sources& sources)
+   {
+      // PPF files are small enough to checksum in full.
+      auto ppf = TakeFingerprint(sources.ppf, SIZE_MAX);
+      if (!ppf.has_value()) {
+         return ppf.error();
+      }
+
+      auto image = TakeFingerprint(sources.image, kImageCrcBytes);
+      if (!image.has_value()) {
+         return image.error();
+      }
+
+      return std::pair(ppf.value(), image.value());
+   }
+
+   // Unique to this call. Processes building the same cache at once each
+   // write their own file, and the last rename wins.
+   [[nodiscard]] fs::path StagingPath(const fs::path& cache)
+   {
+      std::wostringstream suffix;
+      suffix << L"." << base::process::ThisProcess::Id() << L"."
+         << std::hex << std::random_device()() << L".tmp";
+
+      auto staging = cache;
+      staging += suffix.str();
+      return staging;
+   }
+
+   template <typename T>
+   void Write(std::ofstream& stream, const std::span<const T> data)
+   {
+      stream.write(
+         reinterpret_cast<const char*>(data.data()),
+         data.size_bytes());
+   }
+
+   template <typename T>
+   [[nodiscard]] std::span<const T> Records(
+      std::span<const uint8_t>& data,
+      const size_t count)
+   {
+      const auto records = data.first(count * sizeof(T));
+      data = data.subspan(records.size());
+      return std::span(reinterpret_cast<const T*>(records.data()), count);
+   }
+
+   [[nodiscard]] std::optional<SectorPatch> RestoreSectorPatch(
+      const SectorRecord& record,
+      const std::span<const ItemRecord> items,
+      const DataView payload)
+   {
+      if (record.firstItem > items.size()
+       || record.itemCount > items.size() - record.firstItem
+       || record.checksumsOffset > payload.size()
+       || record.checksumsSize > payload.size() - record.checksumsOffset) {
+         return std::nullopt;
+      }
+
+      SectorPatch patch;
+      const auto sectorItems =
+         items.subspan(record.firstItem, record.itemCount);
+      for (const auto& item : sectorItems) {
+         const auto sectorEnd =
+            (item.address / spec::kSectorSize + 1) * spec::kSectorSize;
+         if (item.address / spec::kSectorSize != record.sector
+          || item.size > sectorEnd - item.address
+          || item.dataOffset > payload.size()
+          || item.size > payload.size() - item.dataOffset) {
+            return std::nullopt;
+         }
+
+         std::ignore = patch.AddPatch(PatchItem{
+            .address = item.address,
+            .data = payload.subspan(item.dataOffset, item.size)});
+      }
+
+      if (patch.SectorNumber().get() != record.sector) {
+         return std::nullopt;
+      }
+
+      const SectorOffset checksumsIdx(record.checksumsIdx);
+      const auto checksums =
+         payload.subspan(record.checksumsOffset, record.checksumsSize);
+      if (!patch.RestoreChecksums(checksumsIdx, checksums)) {
+         return std::nullopt;
+      }
+
+      return patch;
+   }
+}
+
+fs::path CachePath(const fs::path& image)
+{
+   auto cache = image;
+   cache += kCacheExt;
+   return cache;
+}
+
+std::error_code Save(
+   const fs::path& cache,
+   const Sources& sources,
+   const Patcher& patcher)
+{
+   const auto fingerprints = TakeFingerprints(sources);
+   if (!fingerprints.has_value()) {
+      return fingerprints.error();
+   }
+
+   const auto sectorPatches = patcher.SectorPatches();
+
+   std::vector<SectorRecord> sectors;
+   std::vector<ItemRecord> items;
+   DataBuffer payload;
+   sectors.reserve(sectorPatches.size());
+
+   for (const auto& patch : sectorPatches) {
+      const auto sectorAddr = ToByteAddress(patch.SectorNumber()).get();
+      const auto patchItems = patch.Patches();
+      const auto checksums = patch.Checksums();
+
+      sectors.push_back(SectorRecord{
+         .sector = patch.SectorNumber().get(),
+         .firstItem = static_cast<uint32_t>(items.size()),
+         .itemCount = static_cast<uint32_t>(patchItems.size()),
+         .checksumsOffset = payload.size(),
+         .checksumsIdx = static_cast<uint32_t>(patch.ChecksumsIndex().get()),
+         .checksumsSize = static_cast<uint32_t>(checksums.size())});
+      payload.insert(payload.end(), checksums.begin(), checksums.end());
+
+      for (const auto& item : patchItems) {
+         items.push_back(ItemRecord{
+            .address = sectorAddr + item.address,
+            .dataOffset = payload.size(),
+            .size = item.data.size()});
+         payload.insert(payload.end(), item.data.begin(), item.data.end());
+      }
+   }
+
+   const Header header{
+      .magic = kMagic,
+      .version = kVersion,
+      .headerSize = sizeof(Header),
+      .ppf = fingerprints.value().first,
+      .image = fingerprints.value().second,
+      .sectorCount = sectors.size(),
+      .itemCount = items.size(),
+      .payloadSize = payload.size()};
+
+   // A reader never sees a partially written cache. It either finds the old
+   // file or the new one.
+   const auto staging = StagingPath(cache);
+   {
+      std::ofstream stream(
+         staging,
+         std::ofstream::binary | std::ofstream::trunc);
+      Write(stream, std::span(&header, 1));
+      Write(stream, std::span<const SectorRecord>(sectors));
+      Write(stream, std::span<const ItemRecord>(items));
+      Write(stream, std::span<const uint8_t>(payload));
+      if (!stream.good()) {
+         TDD_LOG_WARN() << "Unable to write [" << staging.wstring() << "]";
+         stream.close();
+         std::error_code ignored;
+         fs::remove(staging, ignored);
+         return stdext::make_win32_ec(ERROR_WRITE_FAULT);
+      }
+   }
+
+   std::error_code ec;
+   fs::rename(staging, cache, ec);
+   if (ec) {
+      TDD_LOG_WARN() << "Unable to replace [" << cache.wstring()
+         << "]: " << ec.message();
+      std::error_code ignored;
+      fs::remove(staging, ignored);
+      return ec;
+   }
+
+   TDD_LOG_INFO() << "Cached " << sectors.size() << " sectors in ["
+      << cache.wstring() << "]";
+   return {};
+}
+
+stdext::pm_expected<Patcher> Load(const fs::path& cache, const Sources& sources)
+{
+   auto file = base::fs::MappedFile::Open(cache);
+   if (!file.has_value()) {
+      return file.error();
+   }
+
+   auto data = file.value().Data();
+   if (data.size() < sizeof(Header)) {
+      return stdext::make_win32_ec(ERROR_INVALID_DATA);
+   }
+
+   const auto& header = *reinterpret_cast<const Header*>(data.data());
+   if (header.magic != kMagic
+    || header.version != kVersion
+    || header.headerSize != sizeof(Header)) {
+      TDD_LOG_INFO() << "[" << cache.wstring() << "] is not a version "
+         << kVersion << " cache";
+      return stdext::make_win32_ec(ERROR_INVALID_DATA);
+   }
+
+   const auto fingerprints = TakeFingerprints(sources);
+   if (!fingerprints.has_value()) {
+      return fingerprints.error();
+   }
+
+   if (header.ppf != fingerprints.value().first
+    || header.image != fingerprints.value().second) {
+      TDD_LOG_INFO() << "[" << cache.wstring() << "] is out of date";
+      return stdext::make_win32_ec(ERROR_INVALID_DATA);
+   }
+
+   // Each count is checked on its own first so the sum can't overflow.
+   data = data.subspan(sizeof(Header));
+   const auto available = data.size();
+   if (header.sectorCount > available / sizeof(SectorRecord)
+    || header.itemCount > available / sizeof(ItemRecord)
+    || header.payloadSize > available
+    || header.sectorCount * sizeof(SectorRecord)
+       + header.itemCount * sizeof(ItemRecord)
+       + header.payloadSize != available) {
+      TDD_LOG_WARN() << "[" << cache.wstring() << "] is truncated";
+      return stdext::make_win32_ec(ERROR_INVALID_DATA);
+   }
+
+   const auto sectors =
+      Records<SectorRecord>(data, static_cast<size_t>(header.sectorCount));
+   const auto items =
+      Records<ItemRecord>(data, static_cast<size_t>(header.itemCount));
+   const auto payload = data;
+
+   std::vector<SectorPatch> patches;
+   patches.reserve(sectors.size());
+   for (const auto& record : sectors) {
+      auto patch = RestoreSectorPatch(record, items, payload);
+      if (!patch.has_value()
+       || (!patches.empty() && !(patches.back() < patch.value()))) {
+         TDD_LOG_WARN() << "[" << cache.wstring() << "] is corrupted";
+         return stdext::make_win32_ec(ERROR_INVALID_DATA);
+      }
+
+      patches.push_back(std::move(patch).value());
+   }
+
+   PatchArena arena;
+   arena.Adopt(std::move(file).value());
+
+   TDD_LOG_INFO() << "Loaded " << patches.size() << " sectors from ["
+      << cache.wstring() << "]";
+   return Patcher(std::move(arena), std::move(patches));
+}
+
+}
\ No newline at end of file
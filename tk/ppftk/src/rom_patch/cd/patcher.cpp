@@ -4,23 +4,125 @@
 #include <ppftk/rom_patch/cd/sector_range.h>
 #include <ppftk/rom_patch/cd/spec.h>
 
+#include <ppfbase/filesystem/mapped_file.h>
 #include <ppfbase/logging/logging.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
 namespace tdd::tk::rompatch::cd {
 
 namespace {
    std::vector<SectorPatch> Convert(PatchDescriptor::FullPatch&& patches)
    {
       std::vector<SectorPatch> sectorPatches(1);
-      for (auto&& p : patches) {
-         const auto res = sectorPatches.back().AddPatch(std::move(p));
-         if (SectorPatch::AddPatchResult::Added == res) {
+      for (auto p : patches) {
+         // Items crossing a sector boundary are split so that every
+         // SectorPatch only holds data for its own sector.
+         while (!p.data.empty()) {
+            const auto room = spec::kSectorSize - p.address % spec::kSectorSize;
+            const PatchItem head{
+               .address = p.address,
+               .data = p.data.first(std::min(room, p.data.size()))};
+
+            p.address += head.data.size();
+            p.data = p.data.subspan(head.data.size());
+
+            const auto res = sectorPatches.back().AddPatch(head);
+            if (SectorPatch::AddPatchResult::Added == res) {
+               continue;
+            }
+
+            sectorPatches.emplace_back(head);
+         }
+      }
+      return sectorPatches;
+   }
+
+   // Calculates the checksums of the sectors in 'patches' that don't have
+   // them yet. 'read' fills a sector buffer from the unpatched image. Returns
+   // the number of sectors that couldn't be read.
+   template <typename ReadSector>
+   [[nodiscard]] size_t BakeSectors(
+      std::span<SectorPatch> patches,
+      ReadSector&& read)
+   {
+      std::array<uint8_t, spec::kSectorSize> sector;
+      size_t unreadable = 0;
+
+      for (auto& patch : patches) {
+         if (patch.HasUpdatedEdc()) {
+            continue;
+         }
+
+         const auto addr = ToByteAddress(patch.SectorNumber());
+         if (!read(addr, std::span(sector))) {
+            ++unreadable;
             continue;
          }
 
-         sectorPatches.emplace_back(std::move(p));
+         SectorView sv(addr, sector);
+         patch.CalculateChecksum(sv);
       }
-      return sectorPatches;
+
+      return unreadable;
+   }
+
+   [[nodiscard]] auto StreamReader(const std::filesystem::path& image)
+   {
+      return [target = std::ifstream(image, std::ifstream::binary)](
+         const ByteAddress addr,
+         std::span<uint8_t> sector) mutable {
+         target.seekg(addr.get());
+         target.read(reinterpret_cast<char*>(sector.data()), sector.size());
+         if (!target.good()) {
+            target.clear();
+            return false;
+         }
+         return true;
+      };
+   }
+
+   [[nodiscard]] size_t BakeMapped(
+      std::span<SectorPatch> patches,
+      const std::span<const uint8_t> image)
+   {
+      std::atomic<size_t> unreadable = 0;
+
+      const auto bake = [image, &unreadable](std::span<SectorPatch> chunk) {
+         unreadable += BakeSectors(
+            chunk,
+            [image](const ByteAddress addr, std::span<uint8_t> sector) {
+               if (addr.get() >= image.size()
+                || image.size() - addr.get() < sector.size()) {
+                  return false;
+               }
+
+               const auto src = image.subspan(addr.get(), sector.size());
+               std::copy(src.begin(), src.end(), sector.begin());
+               return true;
+            });
+      };
+
+      // Each worker takes a contiguous run of sectors, so its page faults
+      // walk the image sequentially. The calling thread takes the last run.
+      const size_t workers = std::max(1u, std::thread::hardware_concurrency());
+      const auto chunkSize = (patches.size() + workers - 1) / workers;
+
+      std::span<SectorPatch> remaining(patches);
+      {
+         std::vector<std::jthread> threads;
+         while (remaining.size() > chunkSize) {
+            threads.emplace_back(bake, remaining.first(chunkSize));
+            remaining = remaining.subspan(chunkSize);
+         }
+         bake(remaining);
+      }
+
+      return unreadable;
    }
 
    // Look for a patch with std::lower_bound. Finding the first one with a
@@ -42,10 +144,24 @@ namespace {
    }
 }
 
+// TakeArena() and TakeFullPatch() each only move their own member out of
+// 'fullPatch'.
 Patcher::Patcher(PatchDescriptor&& fullPatch)
-   : m_patches(Convert(std::move(fullPatch).TakeFullPatch()))
+   : m_arena(std::move(fullPatch).TakeArena())
+   , m_patches(Convert(std::move(fullPatch).TakeFullPatch()))
+   , m_patchedSectors(m_patches)
 {}
 
+Patcher::Patcher(PatchArena&& arena, std::vector<SectorPatch>&& patches)
+   : m_arena(std::move(arena))
+   , m_patches(std::move(patches))
+   , m_patchedSectors(m_patches)
+{
+   TDD_DCHECK(
+      std::is_sorted(m_patches.begin(), m_patches.end()),
+      "Sector patches are not sorted");
+}
+
 std::optional<IPatcher::AdditionalReads> Patcher::Patch(
    const uint64_t addr,
    std::span<uint8_t> buffer)
@@ -57,6 +173,21 @@ std::optional<IPatcher::AdditionalReads> Patcher::DoPatch(
    const ByteAddress addr,
    std::span<uint8_t> buffer)
 {
+   if (buffer.empty()) {
+      return std::nullopt;
+   }
+
+   // Most reads don't touch a patched sector. Turn them away before
+   // anything else.
+   const auto lastAddr = addr + ByteAddressDiff(buffer.size() - 1);
+   if (!m_patchedSectors.Any(ToSectorNumber(addr), ToSectorNumber(lastAddr))) {
+      return std::nullopt;
+   }
+
+   SectorRange range(addr, buffer);
+   const auto firstSector = range.begin();
+   const auto lastSector = range.end() - SectorDiff(1);
+
    {
       const auto additionalReads = RequireAdditionalReads(addr, buffer);
       if (!additionalReads.addrs.empty()) {
@@ -66,10 +197,6 @@ std::optional<IPatcher::AdditionalReads> Patcher::DoPatch(
 
    // Apply patches.
 
-   SectorRange range(addr, buffer);
-   const auto firstSector = range.begin();
-   const auto lastSector = range.end() - SectorDiff(1);
-
    auto firstPatch = std::lower_bound(
       m_patches.begin(),
       m_patches.end(),
@@ -82,6 +209,10 @@ std::optional<IPatcher::AdditionalReads> Patcher::DoPatch(
       *lastSector,
       UpperBound);
 
+   if (firstPatch == lastPatch) {
+      return std::nullopt;
+   }
+
    auto target = range.begin();
    for (auto patch = firstPatch; patch < lastPatch; ++patch) {
       target += patch->SectorNumber() - target->SectorNumber();
@@ -91,6 +222,64 @@ std::optional<IPatcher::AdditionalReads> Patcher::DoPatch(
    return std::nullopt;
 }
 
+uint64_t Patcher::PatchedBytes(
+   const uint64_t addr,
+   const uint64_t size) const noexcept
+{
+   if (0 == size) {
+      return 0;
+   }
+
+   const auto end = addr + size;
+   const auto first = ToSectorNumber(ByteAddress(addr));
+   const auto last = ToSectorNumber(ByteAddress(end - 1));
+
+   auto patch = std::lower_bound(
+      m_patches.begin(),
+      m_patches.end(),
+      first,
+      [](const SectorPatch& p, const SectorNumber sector) {
+         return p.SectorNumber() < sector;
+      });
+
+   uint64_t bytes = 0;
+   for (; patch != m_patches.end() && patch->SectorNumber() <= last; ++patch) {
+      if (patch->Patches().empty()) {
+         continue;
+      }
+
+      const auto sectorStart = ToByteAddress(patch->SectorNumber()).get();
+      const auto sectorEnd = sectorStart + spec::kSectorSize;
+      bytes += std::min(sectorEnd, end) - std::max(sectorStart, addr);
+   }
+
+   return bytes;
+}
+
+bool Patcher::Bake(const std::filesystem::path& image)
+{
+   // The image is opened once, on the calling thread. The workers only read
+   // from the mapped view.
+   const auto mapped = base::fs::MappedFile::Open(image);
+   const auto unreadable = mapped.has_value()
+      ? BakeMapped(m_patches, mapped.value().Data())
+      : BakeSectors(m_patches, StreamReader(image));
+
+   if (unreadable > 0) {
+      TDD_LOG_WARN() << "Unable to bake " << unreadable << " of "
+         << m_patches.size() << " sectors from [" << image.wstring() << "]";
+      return false;
+   }
+
+   TDD_LOG_INFO() << "Baked " << m_patches.size() << " sectors";
+   return true;
+}
+
+std::span<const SectorPatch> Patcher::SectorPatches() const noexcept
+{
+   return m_patches;
+}
+
 IPatcher::AdditionalReads Patcher::RequireAdditionalReads(
    const ByteAddress targetAddr,
    std::span<uint8_t> buffer) const
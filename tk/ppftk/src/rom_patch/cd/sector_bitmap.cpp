@@ -0,0 +1,98 @@
+#include <ppftk/rom_patch/cd/sector_bitmap.h>
+
+#include <ppftk/rom_patch/cd/sector_patch.h>
+
+#include <ppfbase/logging/logging.h>
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace tdd::tk::rompatch::cd {
+
+namespace {
+   static constexpr uint64_t kWordBits = 64;
+
+   // Bits at and above 'bit' in a word.
+   [[nodiscard]] constexpr uint64_t MaskFrom(const uint64_t bit) noexcept
+   {
+      return ~uint64_t(0) << bit;
+   }
+
+   // Bits at and below 'bit' in a word.
+   [[nodiscard]] constexpr uint64_t MaskTo(const uint64_t bit) noexcept
+   {
+      return ~uint64_t(0) >> (kWordBits - 1 - bit);
+   }
+}
+
+SectorBitmap::SectorBitmap(std::span<const SectorPatch> patches)
+   : m_words()
+{
+   TDD_DCHECK(
+      std::is_sorted(patches.begin(), patches.end()),
+      "Sector patches are not sorted");
+
+   if (patches.empty()) {
+      return;
+   }
+
+   const auto last = patches.back().SectorNumber().get();
+   m_words.resize(last / kWordBits + 1);
+
+   for (const auto& patch : patches) {
+      if (patch.Patches().empty()) {
+         continue;
+      }
+
+      const auto sector = patch.SectorNumber().get();
+      m_words[sector / kWordBits] |= uint64_t(1) << (sector % kWordBits);
+   }
+}
+
+bool SectorBitmap::Any(
+   const SectorNumber first,
+   const SectorNumber last) const noexcept
+{
+   TDD_DCHECK(first <= last, "Inverted sector range");
+
+   const auto firstWord = first.get() / kWordBits;
+   if (firstWord >= m_words.size()) {
+      return false;
+   }
+
+   auto lastWord = last.get() / kWordBits;
+   auto lastMask = MaskTo(last.get() % kWordBits);
+   if (lastWord >= m_words.size()) {
+      lastWord = m_words.size() - 1;
+      lastMask = ~uint64_t(0);
+   }
+
+   const auto firstMask = MaskFrom(first.get() % kWordBits);
+   if (firstWord == lastWord) {
+      return 0 != (m_words[firstWord] & firstMask & lastMask);
+   }
+
+   if (0 != (m_words[firstWord] & firstMask)
+    || 0 != (m_words[lastWord] & lastMask)) {
+      return true;
+   }
+
+   return std::any_of(
+      m_words.begin() + firstWord + 1,
+      m_words.begin() + lastWord,
+      [](const uint64_t word) { return 0 != word; });
+}
+
+size_t SectorBitmap::Count() const noexcept
+{
+   return std::accumulate(
+      m_words.begin(),
+      m_words.end(),
+      size_t(0),
+      [](const size_t count, const uint64_t word) {
+         return count + std::popcount(word);
+      });
+}
+
+}
\ No newline at end of file
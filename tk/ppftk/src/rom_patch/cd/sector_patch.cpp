@@ -1,19 +1,23 @@
 #include <ppftk/rom_patch/cd/sector_patch.h>
 
-#include "../apply_patches.h"
-
+#include <ppftk/rom_patch/apply_patches.h>
+#include <ppftk/rom_patch/cd/ecc.h>
 #include <ppftk/rom_patch/cd/spec.h>
 
 #include <ppfbase/algorithm/crc32.h>
 #include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/cstring.h>
 
 namespace tdd::tk::rompatch::cd {
 
 namespace {
    namespace crc = base::algorithm::crc32;
 
-   static constexpr crc::LookupTable kCrcTable =
-      crc::CompileLookupTable(crc::polynomials::kCdRom);
+   // EDC blocks are ~2 KiB. Folding handles them in a few hundred cycles
+   // where PCLMULQDQ is available. The slicing-by-8 fallback keeps its 8 KiB
+   // of tables small enough to leave room in L1 for the sector.
+   static constexpr crc::FoldingTable kCrcTable =
+      crc::CompileFoldingTable(crc::polynomials::kCdRom);
 
    static constexpr SectorOffset kRequireEdcUpdate(0);
    static constexpr SectorOffset kNoEdcIdx(spec::kSectorSize);
@@ -34,8 +38,9 @@ namespace {
 SectorPatch::SectorPatch()
    : m_sectorNumber(0)
    , m_patches()
-   , m_edc()
+   , m_checksums()
    , m_edcIdx(kRequireEdcUpdate)
+   , m_state(ChecksumsState::Unknown)
 {}
 
 SectorPatch::SectorPatch(PatchItem&& patch)
@@ -50,6 +55,48 @@ SectorPatch::SectorPatch(const PatchItem& patch)
    std::ignore = AddPatch(patch);
 }
 
+SectorPatch::SectorPatch(const SectorPatch& other)
+   : m_sectorNumber(other.m_sectorNumber)
+   , m_patches(other.m_patches)
+   , m_checksums(other.m_checksums)
+   , m_edcIdx(other.m_edcIdx)
+   , m_state(other.m_state.load(std::memory_order_acquire))
+{}
+
+SectorPatch::SectorPatch(SectorPatch&& other) noexcept
+   : m_sectorNumber(other.m_sectorNumber)
+   , m_patches(std::move(other.m_patches))
+   , m_checksums(std::move(other.m_checksums))
+   , m_edcIdx(other.m_edcIdx)
+   , m_state(other.m_state.load(std::memory_order_acquire))
+{}
+
+SectorPatch& SectorPatch::operator=(const SectorPatch& other)
+{
+   if (this != &other) {
+      m_sectorNumber = other.m_sectorNumber;
+      m_patches = other.m_patches;
+      m_checksums = other.m_checksums;
+      m_edcIdx = other.m_edcIdx;
+      m_state.store(
+         other.m_state.load(std::memory_order_acquire),
+         std::memory_order_release);
+   }
+   return *this;
+}
+
+SectorPatch& SectorPatch::operator=(SectorPatch&& other) noexcept
+{
+   m_sectorNumber = other.m_sectorNumber;
+   m_patches = std::move(other.m_patches);
+   m_checksums = std::move(other.m_checksums);
+   m_edcIdx = other.m_edcIdx;
+   m_state.store(
+      other.m_state.load(std::memory_order_acquire),
+      std::memory_order_release);
+   return *this;
+}
+
 bool SectorPatch::operator<(const SectorPatch& other) const noexcept
 {
    return SectorNumber() < other.SectorNumber();
@@ -75,7 +122,9 @@ SectorPatch::AddPatchResult SectorPatch::AddPatch(PatchItem&& patch)
       m_patches.empty() || patch.address > m_patches.back().address,
       "Patch not added in sorted order");
 
-   m_patches.push_back(std::move(patch));
+   if (m_patches.empty() || !MergePatchItem(m_patches.back(), patch)) {
+      m_patches.push_back(std::move(patch));
+   }
    return AddPatchResult::Added;
 }
 
@@ -89,10 +138,10 @@ void SectorPatch::Patch(SectorView& sector) const
    ApplyPatches(sector.DataOffset().get(), sector.Data(), m_patches);
 
    if (HasUpdatedEdc()) {
-      PatchEdc(sector);
+      PatchChecksums(sector);
    }
    else {
-      CalculateEdc(sector);
+      PublishChecksums(sector, CalculateEdc(sector));
    }
 }
 
@@ -103,7 +152,7 @@ SectorNumber SectorPatch::SectorNumber() const noexcept
 
 bool SectorPatch::HasUpdatedEdc() const noexcept
 {
-   return m_edcIdx == kNoEdcIdx || m_edc.has_value();
+   return ChecksumsState::Known == m_state.load(std::memory_order_acquire);
 }
 
 void SectorPatch::CalculateChecksum(SectorView& originalSector)
@@ -112,33 +161,100 @@ void SectorPatch::CalculateChecksum(SectorView& originalSector)
    Patch(originalSector);
 }
 
-void SectorPatch::PatchEdc(SectorView& sector) const noexcept
+std::span<const PatchItem> SectorPatch::Patches() const noexcept
+{
+   return m_patches;
+}
+
+SectorOffset SectorPatch::ChecksumsIndex() const noexcept
+{
+   return HasUpdatedEdc() ? m_edcIdx : kRequireEdcUpdate;
+}
+
+DataView SectorPatch::Checksums() const noexcept
+{
+   return HasUpdatedEdc() ? DataView(m_checksums) : DataView();
+}
+
+bool SectorPatch::RestoreChecksums(
+   const SectorOffset edcIdx,
+   const DataView checksums)
+{
+   if (edcIdx == kRequireEdcUpdate || edcIdx == kNoEdcIdx) {
+      if (!checksums.empty()) {
+         return false;
+      }
+   }
+   else if (edcIdx.get() + checksums.size() != spec::kSectorSize) {
+      return false;
+   }
+
+   m_checksums.assign(checksums.begin(), checksums.end());
+   m_edcIdx = edcIdx;
+   m_state.store(
+      edcIdx == kRequireEdcUpdate
+         ? ChecksumsState::Unknown
+         : ChecksumsState::Known,
+      std::memory_order_release);
+   return true;
+}
+
+void SectorPatch::PatchChecksums(SectorView& sector) const noexcept
 {
    // This sector doesn't need EDC.
    if (m_edcIdx == kNoEdcIdx) {
       return;
    }
 
-   TDD_DCHECK(m_edc.has_value(), "No EDC to patch with");
+   TDD_DCHECK(!m_checksums.empty(), "No checksums to patch with");
 
-   for (auto idx = std::max(sector.DataOffset(), m_edcIdx);
-        idx.get() < sector.DataOffset().get() + sector.Size();
-        ++idx.get()) {
-      sector[idx] = m_edc->parts[idx.get() - m_edcIdx.get()];
+   const auto begin = std::max(sector.DataOffset(), m_edcIdx);
+   const auto end = sector.DataOffset().get() + sector.Size();
+   if (begin.get() >= end) {
+      return;
    }
+
+   const size_t copySize = end - begin.get();
+   memcpy_s(
+      &sector[begin],
+      copySize,
+      m_checksums.data() + (begin.get() - m_edcIdx.get()),
+      copySize);
 }
 
-void SectorPatch::CalculateEdc(SectorView& sv) const noexcept
+void SectorPatch::PublishChecksums(
+   const SectorView& sector,
+   const SectorOffset edcIdx) const
 {
-   TDD_DCHECK(sv.IsComplete(), "Sector needs to be complete");
+   // Threads racing on the first read of the sector all compute the same
+   // checksums into their own buffers. The first one to get here keeps a
+   // copy, the others move on without waiting for it.
+   auto expected = ChecksumsState::Unknown;
+   if (!m_state.compare_exchange_strong(
+          expected,
+          ChecksumsState::Publishing,
+          std::memory_order_acquire)) {
+      return;
+   }
 
-   m_edcIdx = kNoEdcIdx;
+   if (edcIdx != kNoEdcIdx) {
+      const auto raw = sector.Data();
+      m_checksums.assign(raw.begin() + edcIdx.get(), raw.end());
+   }
+
+   m_edcIdx = edcIdx;
+   m_state.store(ChecksumsState::Known, std::memory_order_release);
+}
+
+SectorOffset SectorPatch::CalculateEdc(SectorView& sv)
+{
+   TDD_DCHECK(sv.IsComplete(), "Sector needs to be complete");
 
    auto sector = sv.AsSector();
    switch (sector->header.parts.mode) {
    case spec::kMode0:
       // ECMA-130 14: Mode 0 is full of 0's
-      return;
+      return kNoEdcIdx;
    case spec::kMode1:
       return CalculateMode1Edc(sector);
    case spec::kMode2:
@@ -146,11 +262,11 @@ void SectorPatch::CalculateEdc(SectorView& sv) const noexcept
    default:
       TDD_LOG_WARN() << "Invalid [" << sv.SectorNumber() << "]: mode ["
                      << sector->header.parts.mode << "]";
-      return;
+      return kNoEdcIdx;
    }
 }
 
-void SectorPatch::CalculateMode1Edc(spec::Sector* sector) const noexcept
+SectorOffset SectorPatch::CalculateMode1Edc(spec::Sector* sector)
 {
    // ECMA-130: 14.3
    static constexpr size_t kStartIdx = 0;
@@ -159,20 +275,22 @@ void SectorPatch::CalculateMode1Edc(spec::Sector* sector) const noexcept
    std::span<uint8_t> block(reinterpret_cast<uint8_t*>(sector), 2064);
    sector->mode1.edc.full =
       crc::ComputeCrc(block, kCrcTable, crc::InitialValue::Zero);
-   m_edc = sector->mode1.edc;
-   m_edcIdx = kMode1EdcIdx;
+
+   // ECMA-130: 14.5. The parity covers the EDC, so it goes last.
+   ecc::CalculateMode1Ecc(sector);
+   return kMode1EdcIdx;
 }
 
-void SectorPatch::CalculateMode2Edc(
+SectorOffset SectorPatch::CalculateMode2Edc(
    spec::Sector* sector,
-   const cd::SectorNumber sectorNumber) const noexcept
+   const cd::SectorNumber sectorNumber)
 {
-   if (sector->xa.subheader[0].full != sector->xa.subheader[0].full) {
+   if (sector->xa.subheader[0].full != sector->xa.subheader[1].full) {
       // The assumption is that we are dealing with PSX games. PSX CDs are all
       // in XA format. If the sector is a valid Mode 2 non-XA sector, it doesn't
       // have EDC anyway.
       TDD_LOG_WARN() << "[" << sectorNumber << "] is not XA";
-      return;
+      return kNoEdcIdx;
    }
 
    if (sector->xa.subheader[0].parts.submode.form == spec::kXaForm1) {
@@ -184,10 +302,10 @@ void SectorPatch::CalculateMode2Edc(
       sector->xa.subheader[0].parts.submode.form == spec::kXaForm2,
       "Unexpected form value");
 
-   ZeroXaForm2Edc(sector);
+   return ZeroXaForm2Edc(sector);
 }
 
-void SectorPatch::CalculateXaForm1Edc(spec::Sector* sector) const noexcept
+SectorOffset SectorPatch::CalculateXaForm1Edc(spec::Sector* sector)
 {
    // CD-ROM XA: 4.5.2. EDC covers XA subheader and user data.
    static constexpr size_t kBlockSize =
@@ -199,11 +317,13 @@ void SectorPatch::CalculateXaForm1Edc(spec::Sector* sector) const noexcept
 
    sector->xa.form1.edc.full =
       crc::ComputeCrc(block, kCrcTable, crc::InitialValue::Zero);
-   m_edc = sector->xa.form1.edc;
-   m_edcIdx = kXa1EdcIdx;
+
+   // CD-ROM XA: 4.5.1. The parity covers the EDC, so it goes last.
+   ecc::CalculateXaForm1Ecc(sector);
+   return kXa1EdcIdx;
 }
 
-void SectorPatch::CalculateXaForm2Edc(spec::Sector* sector) const noexcept
+SectorOffset SectorPatch::CalculateXaForm2Edc(spec::Sector* sector)
 {
    // Form 2 EDC covers the same range as Form 1, i.e. XA subheader and user
    // data.
@@ -213,17 +333,15 @@ void SectorPatch::CalculateXaForm2Edc(spec::Sector* sector) const noexcept
 
    sector->xa.form2.edc.full =
       crc::ComputeCrc(block, kCrcTable, crc::InitialValue::Zero);
-   m_edc = sector->xa.form2.edc;
-   m_edcIdx = kXa2EdcIdx;
+   return kXa2EdcIdx;
 }
 
-void SectorPatch::ZeroXaForm2Edc(spec::Sector* sector) const noexcept
+SectorOffset SectorPatch::ZeroXaForm2Edc(spec::Sector* sector)
 {
    // CD-ROM XA: 4.6.2. The 'Reserved' field can either hold a CRC-32 value, or
    // be cleared to 0. Clear to 0 is faster, course.
    sector->xa.form2.edc.full = 0;
-   m_edc = sector->xa.form2.edc;
-   m_edcIdx = kXa2EdcIdx;
+   return kXa2EdcIdx;
 }
 
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include <ppfbase/logging/logging.h>
 
+#include <cstring>
+
 namespace tdd::tk::rompatch::cd {
 
 namespace {
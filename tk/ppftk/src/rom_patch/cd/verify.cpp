@@ -0,0 +1,288 @@
+#include <ppftk/rom_patch/cd/verify.h>
+
+#include <ppftk/rom_patch/cd/spec.h>
+
+#include <ppfbase/algorithm/mismatch.h>
+#include <ppfbase/logging/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <span>
+#include <thread>
+
+namespace tdd::tk::rompatch::cd {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   using base::algorithm::FindFirstMismatch;
+
+   // Page aligned, so the SIMD loads never straddle a page they don't need.
+   static constexpr std::align_val_t kAlignment{4096};
+
+   struct [[nodiscard]] AlignedDelete
+   {
+      void operator()(uint8_t* buffer) const noexcept
+      {
+         ::operator delete[](buffer, kAlignment);
+      }
+   };
+
+   using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedDelete>;
+
+   [[nodiscard]] AlignedBuffer MakeBuffer(const size_t size)
+   {
+      return AlignedBuffer(
+         static_cast<uint8_t*>(::operator new[](size, kAlignment)));
+   }
+
+   [[nodiscard]] SectorLayout Classify(const spec::Sector& sector) noexcept
+   {
+      switch (sector.header.parts.mode) {
+      case spec::kMode0:
+         return SectorLayout::Mode0;
+      case spec::kMode1:
+         return SectorLayout::Mode1;
+      case spec::kMode2:
+         if (sector.xa.subheader[0].full != sector.xa.subheader[1].full) {
+            return SectorLayout::Mode2;
+         }
+         return sector.xa.subheader[0].parts.submode.form == spec::kXaForm1
+            ? SectorLayout::Mode2Form1
+            : SectorLayout::Mode2Form2;
+      default:
+         return SectorLayout::Unknown;
+      }
+   }
+
+   // Bytes at the start of the sector that have to match.
+   [[nodiscard]] size_t ComparedSize(
+      const SectorLayout layout,
+      const VerifyLevel level) noexcept
+   {
+      if (VerifyLevel::Ecc == level) {
+         return spec::kSectorSize;
+      }
+
+      const auto edc = VerifyLevel::Edc == level ? 0 : spec::kEdcSize;
+      switch (layout) {
+      case SectorLayout::Mode1:
+      case SectorLayout::Mode2Form1:
+         return spec::kSectorSize - spec::kEccSize - edc;
+      case SectorLayout::Mode2Form2:
+         return spec::kSectorSize - spec::kEdcSize;
+      default:
+         return spec::kSectorSize;
+      }
+   }
+
+   // Offset of the first byte that counts as a mismatch. nullopt if the
+   // sectors match. 'target' is shorter than a sector only at the end of an
+   // image verified in full.
+   [[nodiscard]] std::optional<SectorMismatch> CompareSector(
+      const uint64_t sectorNumber,
+      std::span<const uint8_t> target,
+      std::span<const uint8_t> verification,
+      const VerifyLevel level) noexcept
+   {
+      if (target.size() < spec::kSectorSize) {
+         const auto pos = FindFirstMismatch(target, verification);
+         if (pos == target.size()) {
+            return std::nullopt;
+         }
+         return SectorMismatch{sectorNumber, SectorLayout::Unknown, pos};
+      }
+
+      const auto& sector = *reinterpret_cast<const spec::Sector*>(
+         target.data());
+      const auto layout = Classify(sector);
+
+      const auto size = ComparedSize(layout, level);
+      const auto pos = FindFirstMismatch(
+         target.first(size),
+         verification.first(size));
+      if (pos < size) {
+         return SectorMismatch{sectorNumber, layout, pos};
+      }
+
+      // A Form 2 EDC of 0 means the sector has none.
+      if (SectorLayout::Mode2Form2 == layout && VerifyLevel::Ecc != level) {
+         const auto& expected = *reinterpret_cast<const spec::Sector*>(
+            verification.data());
+         const auto edc = sector.xa.form2.edc.full;
+         if (0 != edc && edc != expected.xa.form2.edc.full) {
+            const auto edcIdx = spec::kSectorSize - spec::kEdcSize;
+            return SectorMismatch{
+               sectorNumber,
+               layout,
+               edcIdx + FindFirstMismatch(
+                  target.subspan(edcIdx),
+                  verification.subspan(edcIdx))};
+         }
+      }
+
+      return std::nullopt;
+   }
+
+   // Verifies [begin, end) bytes of the images. 'begin' is on a sector
+   // boundary.
+   [[nodiscard]] bool VerifyShard(
+      const fs::path& target,
+      const fs::path& verification,
+      const uint64_t begin,
+      const uint64_t end,
+      const VerifyOptions& options,
+      const std::atomic<bool>& failed,
+      std::vector<SectorMismatch>& mismatches)
+   {
+      std::ifstream ts(target, std::ifstream::binary);
+      std::ifstream vs(verification, std::ifstream::binary);
+      ts.seekg(begin);
+      vs.seekg(begin);
+
+      const auto chunkSize = options.chunkSectors * spec::kSectorSize;
+      const auto tBuffer = MakeBuffer(chunkSize);
+      const auto vBuffer = MakeBuffer(chunkSize);
+
+      for (auto addr = begin; addr < end; addr += chunkSize) {
+         if (failed.load(std::memory_order_relaxed)) {
+            return false;
+         }
+
+         const auto size = static_cast<size_t>(
+            std::min<uint64_t>(chunkSize, end - addr));
+         ts.read(reinterpret_cast<char*>(tBuffer.get()), size);
+         vs.read(reinterpret_cast<char*>(vBuffer.get()), size);
+         if (!ts.good() || !vs.good()) {
+            TDD_LOG_ERROR() << "Unable to read [" << addr << ", "
+               << addr + size << ")";
+            return false;
+         }
+
+         const std::span<const uint8_t> tChunk(tBuffer.get(), size);
+         const std::span<const uint8_t> vChunk(vBuffer.get(), size);
+
+         // Identical chunks are the norm. Otherwise the sectors before the
+         // first difference are known to match.
+         const auto first = FindFirstMismatch(tChunk, vChunk);
+         for (auto offset = first / spec::kSectorSize * spec::kSectorSize;
+              offset < size;
+              offset += spec::kSectorSize) {
+            const auto sectorSize = std::min(spec::kSectorSize, size - offset);
+            const auto mismatch = CompareSector(
+               (addr + offset) / spec::kSectorSize,
+               tChunk.subspan(offset, sectorSize),
+               vChunk.subspan(offset, sectorSize),
+               options.level);
+            if (mismatch.has_value()) {
+               mismatches.push_back(mismatch.value());
+            }
+         }
+      }
+      return true;
+   }
+}
+
+std::string_view ToString(const SectorLayout layout) noexcept
+{
+   switch (layout) {
+   case SectorLayout::Mode0:
+      return "Mode 0";
+   case SectorLayout::Mode1:
+      return "Mode 1";
+   case SectorLayout::Mode2:
+      return "Mode 2";
+   case SectorLayout::Mode2Form1:
+      return "Mode 2 Form 1";
+   case SectorLayout::Mode2Form2:
+      return "Mode 2 Form 2";
+   default:
+      return "Unknown mode";
+   }
+}
+
+std::optional<VerifyReport> Verify(
+   const fs::path& target,
+   const fs::path& verification,
+   const VerifyOptions& options)
+{
+   std::error_code tEc;
+   std::error_code vEc;
+   const auto size = fs::file_size(target, tEc);
+   const auto vSize = fs::file_size(verification, vEc);
+   if (tEc || vEc) {
+      TDD_LOG_ERROR() << "Unable to size [" << target.wstring() << "] or ["
+         << verification.wstring() << "]";
+      return std::nullopt;
+   }
+
+   if (size != vSize) {
+      TDD_LOG_ERROR() << "Target and verification have different sizes";
+      return std::nullopt;
+   }
+
+   if (VerifyLevel::Ecc != options.level && 0 != size % spec::kSectorSize) {
+      TDD_LOG_ERROR() << "Incomplete sector in [" << target.wstring() << "]";
+      return std::nullopt;
+   }
+
+   const auto sectors = (size + spec::kSectorSize - 1) / spec::kSectorSize;
+   const auto chunkSectors = std::max<size_t>(1, options.chunkSectors);
+   const auto chunks = (sectors + chunkSectors - 1) / chunkSectors;
+
+   // Whole chunks per worker, and no idle workers.
+   const auto cores = 0 == options.workers
+      ? std::max<size_t>(1, std::thread::hardware_concurrency())
+      : options.workers;
+   const auto workers = std::max<size_t>(1, std::min<uint64_t>(cores, chunks));
+   const auto shardSectors =
+      (chunks + workers - 1) / workers * chunkSectors;
+
+   VerifyOptions shardOptions = options;
+   shardOptions.chunkSectors = chunkSectors;
+
+   std::atomic<bool> failed = false;
+   std::vector<std::vector<SectorMismatch>> results(workers);
+   {
+      std::vector<std::jthread> threads;
+      for (size_t i = 0; i < workers; ++i) {
+         const auto begin = std::min<uint64_t>(
+            size,
+            i * shardSectors * spec::kSectorSize);
+         const auto end = std::min<uint64_t>(
+            size,
+            (i + 1) * shardSectors * spec::kSectorSize);
+
+         threads.emplace_back([&, i, begin, end] {
+            if (!VerifyShard(
+                  target,
+                  verification,
+                  begin,
+                  end,
+                  shardOptions,
+                  failed,
+                  results[i])) {
+               failed = true;
+            }
+         });
+      }
+   }
+
+   if (failed) {
+      return std::nullopt;
+   }
+
+   VerifyReport report{.sectors = sectors, .mismatches = {}};
+   for (auto& result : results) {
+      report.mismatches.insert(
+         report.mismatches.end(),
+         result.begin(),
+         result.end());
+   }
+   return report;
+}
+
+}
\ No newline at end of file
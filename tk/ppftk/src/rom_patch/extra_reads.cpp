@@ -0,0 +1,71 @@
+#include <ppftk/rom_patch/extra_reads.h>
+
+#include <ppfbase/logging/logging.h>
+
+#include <algorithm>
+
+namespace tdd::tk::rompatch {
+
+bool FeedAdditionalReads(
+   IPatcher& patcher,
+   const IPatcher::AdditionalReads& extraReads,
+   const ReadAt& readAt)
+{
+   const auto& addrs = extraReads.addrs;
+   const auto blockSize = extraReads.blockSize;
+
+   TDD_DCHECK(
+      std::is_sorted(addrs.begin(), addrs.end()),
+      "Additional reads are not sorted");
+
+   std::vector<uint8_t> blocks(addrs.size() * blockSize, 0);
+   for (size_t first = 0; first < addrs.size();) {
+      size_t last = first + 1;
+      while (last < addrs.size()
+          && addrs[last] == addrs[last - 1] + blockSize) {
+         ++last;
+      }
+
+      const auto run = std::span(blocks).subspan(
+         first * blockSize,
+         (last - first) * blockSize);
+      if (!readAt(addrs[first], run)) {
+         TDD_LOG_WARN() << "Unable to read [" << addrs[first] << ", "
+            << addrs[first] + run.size() << ")";
+         return false;
+      }
+
+      for (auto idx = first; idx < last; ++idx) {
+         const auto check = patcher.Patch(
+            addrs[idx],
+            run.subspan((idx - first) * blockSize, blockSize));
+         TDD_CHECK(!check.has_value(), "Unexpected extra read requests");
+      }
+
+      first = last;
+   }
+
+   return true;
+}
+
+bool PatchRead(
+   IPatcher& patcher,
+   const uint64_t addr,
+   std::span<uint8_t> data,
+   const ReadAt& readAt)
+{
+   const auto extraReads = patcher.Patch(addr, data);
+   if (!extraReads.has_value()) {
+      return true;
+   }
+
+   if (!FeedAdditionalReads(patcher, extraReads.value(), readAt)) {
+      return false;
+   }
+
+   const auto check = patcher.Patch(addr, data);
+   TDD_CHECK(!check.has_value(), "Unexpected extra read requests");
+   return true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include <ppftk/rom_patch/offline_apply.h>
+
+#include <ppftk/rom_patch/extra_reads.h>
+#include <ppftk/rom_patch/cd/spec.h>
+
+#include <ppfbase/filesystem/clone_file.h>
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/preprocessor_utils.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   struct [[nodiscard]] Chunk
+   {
+      size_t sequence;
+      uint64_t addr;
+      std::vector<uint8_t> data;
+   };
+
+   // Hands chunks from the reader to the workers and from the workers to the
+   // writer, in reading order. At most 'capacity' chunks are in flight, their
+   // buffers are recycled once written.
+   class [[nodiscard]] Pipeline
+   {
+   public:
+      explicit Pipeline(const size_t capacity)
+         : m_capacity(capacity)
+         , m_lock()
+         , m_changed()
+         , m_free()
+         , m_work()
+         , m_done()
+         , m_inFlight(0)
+         , m_nextWrite(0)
+         , m_finished(false)
+         , m_aborted(false)
+      {}
+
+      TDD_DISABLE_COPY_MOVE(Pipeline);
+
+      // Reader. Waits for room in the pipeline. nullopt once aborted.
+      [[nodiscard]] std::optional<std::vector<uint8_t>> Acquire()
+      {
+         std::unique_lock lock(m_lock);
+         m_changed.wait(lock, [this] {
+            return m_aborted || m_inFlight < m_capacity;
+         });
+
+         if (m_aborted) {
+            return std::nullopt;
+         }
+
+         if (m_free.empty()) {
+            return std::vector<uint8_t>();
+         }
+
+         auto buffer = std::move(m_free.back());
+         m_free.pop_back();
+         return buffer;
+      }
+
+      void Submit(Chunk&& chunk)
+      {
+         {
+            std::lock_guard lock(m_lock);
+            ++m_inFlight;
+            m_work.push_back(std::move(chunk));
+         }
+         m_changed.notify_all();
+      }
+
+      // Reader. Nothing more to submit.
+      void Finish()
+      {
+         {
+            std::lock_guard lock(m_lock);
+            m_finished = true;
+         }
+         m_changed.notify_all();
+      }
+
+      // Workers. nullopt once all chunks are taken or the pipeline aborted.
+      [[nodiscard]] std::optional<Chunk> NextWork()
+      {
+         std::unique_lock lock(m_lock);
+         m_changed.wait(lock, [this] {
+            return m_aborted || m_finished || !m_work.empty();
+         });
+
+         if (m_aborted || m_work.empty()) {
+            return std::nullopt;
+         }
+
+         auto chunk = std::move(m_work.front());
+         m_work.pop_front();
+         return chunk;
+      }
+
+      void Done(Chunk&& chunk)
+      {
+         {
+            std::lock_guard lock(m_lock);
+            const auto sequence = chunk.sequence;
+            m_done.emplace(sequence, std::move(chunk));
+         }
+         m_changed.notify_all();
+      }
+
+      // Writer. The next chunk in reading order. nullopt once all chunks are
+      // written or the pipeline aborted.
+      [[nodiscard]] std::optional<Chunk> NextInOrder()
+      {
+         std::unique_lock lock(m_lock);
+         m_changed.wait(lock, [this] {
+            return m_aborted
+               || (m_finished && 0 == m_inFlight)
+               || (!m_done.empty() && m_done.begin()->first == m_nextWrite);
+         });
+
+         if (m_aborted || m_done.empty()) {
+            return std::nullopt;
+         }
+
+         auto chunk = std::move(m_done.begin()->second);
+         m_done.erase(m_done.begin());
+         ++m_nextWrite;
+         return chunk;
+      }
+
+      // Writer. 'buffer' is written out and can be filled again.
+      void Recycle(std::vector<uint8_t>&& buffer)
+      {
+         {
+            std::lock_guard lock(m_lock);
+            --m_inFlight;
+            m_free.push_back(std::move(buffer));
+         }
+         m_changed.notify_all();
+      }
+
+      void Abort()
+      {
+         {
+            std::lock_guard lock(m_lock);
+            m_aborted = true;
+         }
+         m_changed.notify_all();
+      }
+
+      [[nodiscard]] bool Aborted()
+      {
+         std::lock_guard lock(m_lock);
+         return m_aborted;
+      }
+
+   private:
+      const size_t m_capacity;
+
+      std::mutex m_lock;
+      std::condition_variable m_changed;
+      std::vector<std::vector<uint8_t>> m_free;
+      std::deque<Chunk> m_work;
+      std::map<size_t, Chunk> m_done;
+      size_t m_inFlight;
+      size_t m_nextWrite;
+      bool m_finished;
+      bool m_aborted;
+   };
+
+   // Only a sector cut short by the end of the image is ever split, and it
+   // can't be read in full either. Chunks and ranges are otherwise whole
+   // sectors.
+   [[nodiscard]] ReadAt SourceReader(const fs::path& source)
+   {
+      return [source](const uint64_t addr, std::span<uint8_t> buffer) {
+         std::ifstream is(source, std::ifstream::binary);
+         is.seekg(addr);
+         is.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+         return is.good();
+      };
+   }
+
+   void PatchChunks(Pipeline& pipeline, IPatcher& patcher, const ReadAt& read)
+   {
+      while (auto chunk = pipeline.NextWork()) {
+         if (!PatchRead(patcher, chunk->addr, chunk->data, read)) {
+            TDD_LOG_ERROR() << "Unable to patch [" << chunk->addr << ", "
+               << chunk->addr + chunk->data.size() << ")";
+            pipeline.Abort();
+            return;
+         }
+         pipeline.Done(std::move(chunk).value());
+      }
+   }
+
+   [[nodiscard]] bool IsSameFile(
+      const fs::path& source,
+      const fs::path& output)
+   {
+      std::error_code ec;
+      if (fs::equivalent(source, output, ec)) {
+         TDD_LOG_ERROR() << "Output is the source image";
+         return true;
+      }
+      return false;
+   }
+
+   void WriteChunks(Pipeline& pipeline, std::ofstream& os)
+   {
+      while (auto chunk = pipeline.NextInOrder()) {
+         os.write(
+            reinterpret_cast<const char*>(chunk->data.data()),
+            chunk->data.size());
+         if (!os.good()) {
+            TDD_LOG_ERROR() << "Unable to write [" << chunk->addr << ", "
+               << chunk->addr + chunk->data.size() << ")";
+            pipeline.Abort();
+            return;
+         }
+         pipeline.Recycle(std::move(chunk->data));
+      }
+   }
+}
+
+bool ApplyOffline(
+   IPatcher& patcher,
+   const fs::path& source,
+   const fs::path& output,
+   const OfflineApplyOptions& options)
+{
+   if (IsSameFile(source, output)) {
+      return false;
+   }
+
+   std::ifstream is(source, std::ifstream::binary);
+   if (!is.is_open()) {
+      TDD_LOG_ERROR() << "Unable to open [" << source.wstring() << "]";
+      return false;
+   }
+
+   std::ofstream os(output, std::ofstream::binary | std::ofstream::trunc);
+   if (!os.is_open()) {
+      TDD_LOG_ERROR() << "Unable to create [" << output.wstring() << "]";
+      return false;
+   }
+
+   const auto chunkSize = std::max(
+      options.chunkSize - options.chunkSize % cd::spec::kSectorSize,
+      cd::spec::kSectorSize);
+   const auto workers = 0 == options.workers
+      ? std::max<size_t>(1, std::thread::hardware_concurrency())
+      : options.workers;
+
+   // One chunk per worker, plus one being written and one waiting for the
+   // writer.
+   Pipeline pipeline(workers + 2);
+   {
+      const auto read = SourceReader(source);
+
+      std::vector<std::jthread> threads;
+      threads.emplace_back(WriteChunks, std::ref(pipeline), std::ref(os));
+      for (size_t i = 0; i < workers; ++i) {
+         threads.emplace_back(
+            PatchChunks,
+            std::ref(pipeline),
+            std::ref(patcher),
+            std::cref(read));
+      }
+
+      uint64_t addr = 0;
+      for (size_t sequence = 0; is.good(); ++sequence) {
+         auto buffer = pipeline.Acquire();
+         if (!buffer.has_value()) {
+            break;
+         }
+
+         buffer->resize(chunkSize);
+         is.read(reinterpret_cast<char*>(buffer->data()), chunkSize);
+         const auto got = static_cast<size_t>(is.gcount());
+         if (0 == got) {
+            break;
+         }
+
+         buffer->resize(got);
+         pipeline.Submit(Chunk{
+            .sequence = sequence,
+            .addr = addr,
+            .data = std::move(buffer).value()});
+         addr += got;
+      }
+
+      if (is.bad()) {
+         TDD_LOG_ERROR() << "Unable to read [" << source.wstring() << "] at "
+            << addr;
+         pipeline.Abort();
+      }
+
+      pipeline.Finish();
+   }
+
+   os.close();
+   if (pipeline.Aborted() || os.fail()) {
+      return false;
+   }
+
+   TDD_LOG_INFO() << "Patched [" << source.wstring() << "] into ["
+      << output.wstring() << "]";
+   return true;
+}
+
+bool ApplyToClone(
+   IPatcher& patcher,
+   std::span<const AsyncPatcher::Range> ranges,
+   const fs::path& source,
+   const fs::path& output)
+{
+   if (IsSameFile(source, output)) {
+      return false;
+   }
+
+   const auto cloned = base::fs::CloneFile(source, output);
+   if (!cloned.has_value()) {
+      return false;
+   }
+
+   TDD_LOG_INFO()
+      << (base::fs::CloneMethod::Reflink == cloned.value()
+         ? "Cloned [" : "Copied [")
+      << source.wstring() << "] to [" << output.wstring() << "]";
+
+   std::ifstream is(source, std::ifstream::binary);
+   std::fstream os(output, std::fstream::binary | std::fstream::in
+      | std::fstream::out);
+   if (!is.is_open() || !os.is_open()) {
+      TDD_LOG_ERROR() << "Unable to reopen [" << source.wstring() << "] or ["
+         << output.wstring() << "]";
+      return false;
+   }
+
+   std::error_code ec;
+   const auto size = fs::file_size(source, ec);
+   if (ec) {
+      TDD_LOG_ERROR() << "Unable to size [" << source.wstring() << "]: " << ec;
+      return false;
+   }
+
+   const auto read = SourceReader(source);
+   std::vector<uint8_t> buffer;
+   uint64_t patched = 0;
+
+   for (const auto& range : ranges) {
+      // Patches past the end of the image have nothing to patch.
+      if (range.start >= size) {
+         break;
+      }
+
+      buffer.resize(std::min(range.end, size) - range.start);
+      is.seekg(range.start);
+      is.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+      if (!is.good()) {
+         TDD_LOG_ERROR() << "Unable to read [" << range.start << ", "
+            << range.start + buffer.size() << ")";
+         return false;
+      }
+
+      if (!PatchRead(patcher, range.start, buffer, read)) {
+         TDD_LOG_ERROR() << "Unable to patch [" << range.start << ", "
+            << range.start + buffer.size() << ")";
+         return false;
+      }
+
+      os.seekp(range.start);
+      os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+      if (!os.good()) {
+         TDD_LOG_ERROR() << "Unable to write [" << range.start << ", "
+            << range.start + buffer.size() << ")";
+         return false;
+      }
+      patched += buffer.size();
+   }
+
+   os.close();
+   if (os.fail()) {
+      return false;
+   }
+
+   TDD_LOG_INFO() << "Rewrote " << patched << " bytes of ["
+      << output.wstring() << "]";
+   return true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <ppftk/rom_patch/patch_arena.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   // Blocks are sized for PPF payloads, which are at most 255 bytes per entry.
+   // Callers that know the total up front should use Reserve().
+   static constexpr size_t kDefaultBlockSize = 64 * 1024;
+}
+
+PatchArena::PatchArena() noexcept
+   : m_blocks()
+   , m_next(nullptr)
+   , m_available(0)
+   , m_files()
+{}
+
+PatchArena::PatchArena(PatchArena&& other) noexcept
+   : m_blocks(std::move(other.m_blocks))
+   , m_next(std::exchange(other.m_next, nullptr))
+   , m_available(std::exchange(other.m_available, 0))
+   , m_files(std::move(other.m_files))
+{
+   other.m_blocks.clear();
+   other.m_files.clear();
+}
+
+PatchArena& PatchArena::operator=(PatchArena&& other) noexcept
+{
+   if (this != &other) {
+      m_blocks = std::move(other.m_blocks);
+      m_next = std::exchange(other.m_next, nullptr);
+      m_available = std::exchange(other.m_available, 0);
+      m_files = std::move(other.m_files);
+
+      other.m_blocks.clear();
+      other.m_files.clear();
+   }
+   return *this;
+}
+
+void PatchArena::Reserve(const size_t bytes)
+{
+   if (bytes <= m_available) {
+      return;
+   }
+
+   // The unused tail of the current block is abandoned. Reserve() is meant to
+   // be called before the bulk of the allocations.
+   m_blocks.push_back(std::make_unique_for_overwrite<uint8_t[]>(bytes));
+   m_next = m_blocks.back().get();
+   m_available = bytes;
+}
+
+std::span<uint8_t> PatchArena::Allocate(const size_t bytes)
+{
+   if (bytes == 0) {
+      return {};
+   }
+
+   if (bytes > m_available) {
+      Reserve(std::max(bytes, kDefaultBlockSize));
+   }
+
+   std::span<uint8_t> allocated(m_next, bytes);
+   m_next += bytes;
+   m_available -= bytes;
+   return allocated;
+}
+
+DataView PatchArena::Copy(const DataView data)
+{
+   const auto copy = Allocate(data.size());
+   std::copy(data.begin(), data.end(), copy.begin());
+   return copy;
+}
+
+void PatchArena::Adopt(base::fs::MappedFile&& file)
+{
+   m_files.push_back(std::move(file));
+}
+
+size_t PatchArena::BlockCount() const noexcept
+{
+   return m_blocks.size();
+}
+
+}
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <ppfbase/stdext/iostream.h>
 
 #include <algorithm>
+#include <iterator>
+#include <utility>
 
 namespace tdd::tk::rompatch {
 
@@ -13,7 +15,7 @@ namespace {
    [[nodiscard]] bool ValidateTarget(
       std::ifstream& target,
       const size_t fileSize,
-      const PatchItem& validationData)
+      const PatchDescriptor::ValidationData& validationData)
    {
       if (validationData.data.empty()) {
          return true;
@@ -44,6 +46,131 @@ namespace {
 
       return true;
    }
+
+   using PatchIter = PatchDescriptor::FullPatch::const_iterator;
+
+   [[nodiscard]] uint64_t EndAddress(const PatchItem& item) noexcept
+   {
+      return item.address + item.data.size();
+   }
+
+   // True if the data of the non-empty items in [first, last) are laid out
+   // back to back in memory without gaps in between.
+   [[nodiscard]] bool IsStoredContiguously(
+      const PatchIter first,
+      const PatchIter last) noexcept
+   {
+      const uint8_t* expected = nullptr;
+      uint64_t expectedAddress = 0;
+
+      for (auto it = first; it != last; ++it) {
+         if (it->data.empty()) {
+            continue;
+         }
+
+         const bool contiguous = expected == nullptr ||
+            (expected == it->data.data() && expectedAddress == it->address);
+         if (!contiguous) {
+            return false;
+         }
+
+         expected = it->data.data() + it->data.size();
+         expectedAddress = EndAddress(*it);
+      }
+      return true;
+   }
+
+   // Merges [first, last) into a single item. When the data is already stored
+   // back to back in the arena, the merged item is just a wider view. Otherwise
+   // the run is copied into a new arena allocation and 'fillGap' is asked to
+   // provide the bytes between the items.
+   template <typename FillGap>
+   [[nodiscard]] std::optional<PatchItem> MergeRun(
+      const PatchIter first,
+      const PatchIter last,
+      const uint64_t runEnd,
+      PatchArena& arena,
+      FillGap&& fillGap)
+   {
+      const size_t runSize = runEnd - first->address;
+
+      if (IsStoredContiguously(first, last)) {
+         return PatchItem{
+            .address = first->address,
+            .data = DataView(first->data.data(), runSize)};
+      }
+
+      const auto merged = arena.Allocate(runSize);
+      auto filled = first->address;
+
+      for (auto it = first; it != last; ++it) {
+         if (it->data.empty()) {
+            continue;
+         }
+
+         if (it->address > filled) {
+            const auto gap = merged.subspan(
+               filled - first->address,
+               it->address - filled);
+
+            if (!fillGap(filled, gap)) {
+               return std::nullopt;
+            }
+         }
+
+         std::copy(
+            it->data.begin(),
+            it->data.end(),
+            merged.begin() + (it->address - first->address));
+         filled = EndAddress(*it);
+      }
+
+      return PatchItem{.address = first->address, .data = merged};
+   }
+
+   // Merges runs of items that are no more than 'maxGap' bytes apart.
+   template <typename FillGap>
+   [[nodiscard]] std::optional<PatchDescriptor::FullPatch> CompactRuns(
+      const PatchDescriptor::FullPatch& patch,
+      const size_t maxGap,
+      PatchArena& arena,
+      FillGap&& fillGap)
+   {
+      PatchDescriptor::FullPatch compacted;
+
+      auto first = patch.begin();
+      while (first != patch.end()) {
+         if (first->data.empty()) {
+            ++first;
+            continue;
+         }
+
+         auto runEnd = EndAddress(*first);
+         auto last = std::next(first);
+
+         for (; last != patch.end(); ++last) {
+            if (last->data.empty()) {
+               continue;
+            }
+
+            // Overlapping items wrap around and are never merged.
+            if (last->address - runEnd > maxGap) {
+               break;
+            }
+            runEnd = EndAddress(*last);
+         }
+
+         auto merged = MergeRun(first, last, runEnd, arena, fillGap);
+         if (!merged.has_value()) {
+            return std::nullopt;
+         }
+
+         compacted.push_back(merged.value());
+         first = last;
+      }
+
+      return compacted;
+   }
 }
 
 void PatchDescriptor::Compact()
@@ -55,37 +182,23 @@ void PatchDescriptor::Compact()
       return;
    }
 
-   FullPatch compacted;
-   PatchItem merged{};
-
    TDD_DCHECK(
       std::is_sorted(patch.begin(), patch.end()),
       "Patches are not sorted");
 
-   for (const auto& entry : patch) {
-      if (entry.data.empty()) {
-         continue;
-      }
-
-      if (merged.address + merged.data.size() == entry.address) {
-         merged.data.insert(
-            merged.data.end(),
-            entry.data.begin(),
-            entry.data.end());
-         continue;
-      }
-
-      if (!merged.data.empty()) {
-         compacted.push_back(merged);
-      }
-      merged = entry;
-   }
+   static constexpr size_t kNoGap = 0;
+   auto compacted = CompactRuns(
+      patch,
+      kNoGap,
+      m_arena,
+      [](const uint64_t, std::span<uint8_t>) {
+         TDD_DCHECK(false, "No gap expected");
+         return false;
+      });
 
-   if (!merged.data.empty()) {
-      compacted.push_back(merged);
+   if (compacted.has_value()) {
+      m_fullPatch = std::move(compacted).value();
    }
-
-   m_fullPatch = std::move(compacted);
 }
 
 bool PatchDescriptor::Compact(
@@ -105,89 +218,60 @@ bool PatchDescriptor::Compact(
       return false;
    }
 
+   // If the gap is less than equal to the entry header size, we can save
+   // space by pulling in the data from the target image.
    const auto gapSizeToFill = gapSizeToFillOverride.value_or(
       details::ppf::schema::kPatchEntryHeaderSize);
 
-   PatchDescriptor::FullPatch compacted;
-   PatchItem merged{};
-
-   for (const auto& entry : patch) {
-      if (entry.data.empty()) {
-         continue;
-      }
-
-      const auto currentEndAddress = merged.address + merged.data.size();
-      const auto gap = entry.address - currentEndAddress;
-
-      // If the gap is less than equal to the entry header size, we can save
-      // space by pulling in the data from the target image.
-      if (gap <= gapSizeToFill) {
-         if (gap > 0) {
-            if (currentEndAddress + gap + entry.data.size() > fileSize) {
-               TDD_LOG_ERROR() << "Patch does not apply to the target image";
-               return false;
-            }
-
-            targetImage.seekg(currentEndAddress, std::ios::beg);
-            if (!targetImage.good()) {
-               TDD_LOG_ERROR() << "Unable to seek to filler location";
-               return false;
-            }
-
-            DataBuffer filler(gap);
-            stdext::Read(targetImage, filler);
-            if (!targetImage.good()) {
-               TDD_LOG_ERROR() << "Unable to read target image for filler data";
-               return false;
-            }
-
-            merged.data.insert(
-               merged.data.end(),
-               filler.begin(),
-               filler.end());
+   auto compacted = CompactRuns(
+      patch,
+      gapSizeToFill,
+      m_arena,
+      [&targetImage, fileSize](
+         const uint64_t address,
+         std::span<uint8_t> filler) {
+         if (address + filler.size() > fileSize) {
+            TDD_LOG_ERROR() << "Patch does not apply to the target image";
+            return false;
          }
 
-         merged.data.insert(
-            merged.data.end(),
-            entry.data.begin(),
-            entry.data.end());
-         continue;
-      }
+         targetImage.seekg(address, std::ios::beg);
+         if (!targetImage.good()) {
+            TDD_LOG_ERROR() << "Unable to seek to filler location";
+            return false;
+         }
 
-      if (!merged.data.empty()) {
-         compacted.push_back(merged);
-      }
-      merged = entry;
-   }
+         stdext::Read(targetImage, filler);
+         if (!targetImage.good()) {
+            TDD_LOG_ERROR() << "Unable to read target image for filler data";
+            return false;
+         }
+         return true;
+      });
 
-   if (!merged.data.empty()) {
-      compacted.push_back(merged);
+   if (!compacted.has_value()) {
+      return false;
    }
 
-   m_fullPatch = std::move(compacted);
+   m_fullPatch = std::move(compacted).value();
 
    return true;
 }
 
-bool PatchDescriptor::AddPatchData(
-   const size_t address,
-   const DataBuffer& data)
+void PatchDescriptor::Reserve(const size_t entries, const size_t bytes)
 {
-   return AddPatchData(address, DataBuffer(data));
+   m_fullPatch.reserve(entries);
+   m_arena.Reserve(bytes);
 }
 
 bool PatchDescriptor::AddPatchData(
    const size_t address,
-   DataBuffer&& data)
+   const DataView data)
 {
-   PatchItem newPatch{
-      .address = address,
-      .data = std::move(data)};
-
    const auto it = std::lower_bound(
       m_fullPatch.begin(),
       m_fullPatch.end(),
-      newPatch);
+      PatchItem{.address = address, .data = {}});
 
    if (it != m_fullPatch.end() && it->address == address) {
       TDD_LOG_ERROR() << "Patch data for address [" << address
@@ -195,13 +279,51 @@ bool PatchDescriptor::AddPatchData(
       return false;
    }
 
-   m_fullPatch.insert(it, std::move(newPatch));
-   return true;
-}
+   // Only the previous item can reach into the new one, the items don't
+   // overlap each other.
+   const auto end = address + data.size();
+   auto first = it;
+   if (first != m_fullPatch.begin()
+    && EndAddress(*std::prev(first)) > address) {
+      --first;
+   }
 
-void PatchDescriptor::SetFullPatch(FullPatch&& patch) noexcept
-{
-   m_fullPatch = std::move(patch);
+   auto last = it;
+   while (last != m_fullPatch.end() && last->address < end) {
+      ++last;
+   }
+
+   if (first == last) {
+      m_fullPatch.insert(
+         it,
+         PatchItem{.address = address, .data = m_arena.Copy(data)});
+      return true;
+   }
+
+   // Lookups rely on the items not overlapping, so overlapping data becomes
+   // one item. The new data goes on top, the way a PPF applies its records
+   // one after the other.
+   const auto mergedStart = std::min<uint64_t>(first->address, address);
+   const auto mergedEnd = std::max<uint64_t>(EndAddress(*std::prev(last)), end);
+   DataBuffer merged(mergedEnd - mergedStart);
+   for (auto item = first; item != last; ++item) {
+      std::copy(
+         item->data.begin(),
+         item->data.end(),
+         merged.begin() + (item->address - mergedStart));
+   }
+   std::copy(
+      data.begin(),
+      data.end(),
+      merged.begin() + (address - mergedStart));
+
+   TDD_LOG_DEBUG() << "Patch data for [" << address << ", " << end
+      << ") overlaps. Merged into [" << mergedStart << ", " << mergedEnd
+      << ")";
+
+   *first = PatchItem{.address = mergedStart, .data = m_arena.Copy(merged)};
+   m_fullPatch.erase(std::next(first), last);
+   return true;
 }
 
 void PatchDescriptor::AddValidationData(
@@ -266,4 +388,9 @@ PatchDescriptor::FullPatch&& PatchDescriptor::TakeFullPatch() && noexcept
    return std::move(m_fullPatch);
 }
 
+PatchArena&& PatchDescriptor::TakeArena() && noexcept
+{
+   return std::move(m_arena);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include <ppftk/rom_patch/patch_index.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/cstring.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace tdd::tk::rompatch {
+
+PatchIndex::PatchIndex() noexcept
+   : m_starts()
+   , m_ends()
+   , m_offsets()
+   , m_payload()
+   , m_searchKeys()
+   , m_searchRanks()
+{}
+
+PatchIndex::PatchIndex(const PatchDescriptor::FullPatch& patches)
+   : PatchIndex()
+{
+   size_t payloadSize = 0;
+   for (const auto& entry : patches) {
+      payloadSize += entry.data.size();
+   }
+
+   m_starts.reserve(patches.size());
+   m_ends.reserve(patches.size());
+   m_offsets.reserve(patches.size());
+   m_payload.reserve(payloadSize);
+
+   for (const auto& entry : patches) {
+      if (entry.data.empty()) {
+         continue;
+      }
+
+      TDD_DCHECK(
+         m_ends.empty() || m_ends.back() <= entry.address,
+         "Patches are not sorted or overlap");
+
+      const auto entryEnd = entry.address + entry.data.size();
+
+      // Payloads are appended in order, so an entry that continues the
+      // previous one can simply extend it.
+      if (!m_ends.empty() && m_ends.back() == entry.address) {
+         m_ends.back() = entryEnd;
+      }
+      else {
+         m_starts.push_back(entry.address);
+         m_ends.push_back(entryEnd);
+         m_offsets.push_back(m_payload.size());
+      }
+
+      m_payload.insert(m_payload.end(), entry.data.begin(), entry.data.end());
+   }
+
+   m_searchKeys.resize(m_ends.size() + 1);
+   m_searchRanks.resize(m_ends.size() + 1);
+
+   size_t sortedIdx = 0;
+   BuildSearchTree(sortedIdx, 1);
+}
+
+bool PatchIndex::Empty() const noexcept
+{
+   return m_starts.empty();
+}
+
+size_t PatchIndex::Size() const noexcept
+{
+   return m_starts.size();
+}
+
+uint64_t PatchIndex::Start() const noexcept
+{
+   return Empty() ? 0 : m_starts.front();
+}
+
+uint64_t PatchIndex::End() const noexcept
+{
+   return Empty() ? 0 : m_ends.back();
+}
+
+size_t PatchIndex::Find(const uint64_t addr) const noexcept
+{
+   // Branchless descent. Every step goes right when the node ends at or before
+   // 'addr'.
+   size_t node = 1;
+   while (node < m_searchKeys.size()) {
+      node = 2 * node + static_cast<size_t>(m_searchKeys[node] <= addr);
+   }
+
+   // The answer is the last node where the descent went left. Drop the
+   // trailing right turns and that left turn to get back to it.
+   node >>= std::countr_one(node) + 1;
+
+   return node == 0 ? Size() : m_searchRanks[node];
+}
+
+uint64_t PatchIndex::EntryStart(const size_t idx) const noexcept
+{
+   return m_starts[idx];
+}
+
+uint64_t PatchIndex::EntryEnd(const size_t idx) const noexcept
+{
+   return m_ends[idx];
+}
+
+std::span<const uint8_t> PatchIndex::EntryData(const size_t idx) const noexcept
+{
+   return std::span(
+      m_payload.data() + m_offsets[idx],
+      m_ends[idx] - m_starts[idx]);
+}
+
+void PatchIndex::Apply(
+   const uint64_t addr,
+   std::span<uint8_t> target) const noexcept
+{
+   const auto targetEnd = addr + target.size();
+
+   for (auto idx = Find(addr); idx < Size() && m_starts[idx] < targetEnd;
+        ++idx) {
+      const auto copyStart = std::max(m_starts[idx], addr);
+      const auto copyEnd = std::min(m_ends[idx], targetEnd);
+      const size_t copySize = copyEnd - copyStart;
+
+      memcpy_s(
+         target.data() + (copyStart - addr),
+         copySize,
+         m_payload.data() + m_offsets[idx] + (copyStart - m_starts[idx]),
+         copySize);
+   }
+}
+
+void PatchIndex::BuildSearchTree(
+   size_t& sortedIdx,
+   const size_t node) noexcept
+{
+   // In-order traversal of the implicit tree visits the slots in sorted
+   // order.
+   if (node >= m_searchKeys.size()) {
+      return;
+   }
+
+   BuildSearchTree(sortedIdx, 2 * node);
+   m_searchKeys[node] = m_ends[sortedIdx];
+   m_searchRanks[node] = sortedIdx;
+   ++sortedIdx;
+   BuildSearchTree(sortedIdx, 2 * node + 1);
+}
+
+}
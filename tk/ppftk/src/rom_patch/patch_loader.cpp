@@ -0,0 +1,109 @@
+#include <ppftk/rom_patch/patch_loader.h>
+
+#include <ppftk/config/app.h>
+#include <ppftk/config/patch.h>
+#include <ppftk/rom_patch/patchers.h>
+#include <ppftk/rom_patch/cd/patch_cache.h>
+#include <ppftk/rom_patch/cd/spec.h>
+#include <ppftk/rom_patch/ppf/parser.h>
+
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/string.h>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   // The sectors a cached patcher patches, merged where they touch.
+   [[nodiscard]] AsyncPatcher::Ranges CoveredSectors(
+      const cd::Patcher& patcher)
+   {
+      AsyncPatcher::Ranges ranges;
+      for (const auto& patch : patcher.SectorPatches()) {
+         const auto start = cd::ToByteAddress(patch.SectorNumber()).get();
+         const auto end = start + cd::spec::kSectorSize;
+         if (!ranges.empty() && ranges.back().end == start) {
+            ranges.back().end = end;
+            continue;
+         }
+
+         ranges.push_back({.start = start, .end = end});
+      }
+      return ranges;
+   }
+
+   [[nodiscard]] std::unique_ptr<cd::Patcher> BuildCdPatcher(
+      const fs::path& target,
+      const fs::path& patchFile,
+      const AsyncPatcher::Announce& announce)
+   {
+      const cd::PatchCache::Sources sources{.ppf = patchFile, .image = target};
+      const auto cache = cd::PatchCache::CachePath(target);
+
+      auto cached = cd::PatchCache::Load(cache, sources);
+      if (cached.has_value()) {
+         announce(CoveredSectors(cached.value()));
+         return std::make_unique<cd::Patcher>(std::move(cached).value());
+      }
+
+      auto patch = ppf::Parse(patchFile);
+      if (!patch.has_value()) {
+         TDD_LOG_WARN() << "Unable to parse patch";
+         return nullptr;
+      }
+
+      // The checksums of a patched sector change too, so reads need to wait
+      // for the whole sector.
+      announce(AsyncPatcher::CoveredRanges(
+         patch.value().GetFullPatch(),
+         cd::spec::kSectorSize));
+
+      auto cdPatch = std::make_unique<cd::Patcher>(std::move(patch).value());
+
+      // Sectors that fail to bake fall back to extra reads. They are not worth
+      // caching.
+      if (cdPatch->Bake(target)) {
+         std::ignore = cd::PatchCache::Save(cache, sources, *cdPatch);
+      }
+
+      return cdPatch;
+   }
+}
+
+bool IsPatchTarget(const fs::path& file)
+{
+   const auto targetExt = stdext::WideToUtf8(file.extension().wstring());
+   return config::App::TargetExts().count(targetExt) != 0
+      && config::Patch::Exists(file);
+}
+
+std::unique_ptr<IPatcher> LoadPatcher(
+   const fs::path& target,
+   const AsyncPatcher::Announce& announce)
+{
+   config::Patch patchConfig(target);
+
+   if (patchConfig.PatchFile().empty()) {
+      return nullptr;
+   }
+
+   TDD_LOG_INFO() << "Target: " << target.wstring();
+   TDD_LOG_INFO() << "Patch: " << patchConfig.PatchFile().wstring();
+
+   if (patchConfig.CalculateEdc()) {
+      TDD_LOG_INFO() << "EDC calculation required.";
+      return BuildCdPatcher(target, patchConfig.PatchFile(), announce);
+   }
+
+   auto patch = ppf::Parse(patchConfig.PatchFile());
+   if (!patch.has_value()) {
+      TDD_LOG_WARN() << "Unable to parse patch";
+      return nullptr;
+   }
+
+   announce(AsyncPatcher::CoveredRanges(patch.value().GetFullPatch(), 1));
+   return std::make_unique<SimplePatcher>(std::move(patch).value());
+}
+
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "schema.h"
 #include "v3.h"
 
+#include <ppfbase/filesystem/mapped_file.h>
 #include <ppfbase/logging/logging.h>
 
 #include <fstream>
@@ -14,12 +15,12 @@ namespace tdd::tk::rompatch::ppf {
 namespace {
    namespace schema = details::ppf::schema;
 
-   std::optional<PatchDescriptor> DoParse(const std::filesystem::path& ppf)
+   std::optional<PatchDescriptor> DoParse(std::span<const uint8_t> ppf)
    {
       static constexpr auto kMagicSize = 5;
       static constexpr auto kVersionSize = 1;
 
-      static const std::set<std::string> kMagic = {
+      static const std::set<std::string, std::less<>> kMagic = {
          "PPF10",
          "PPF20",
          "PPF30"
@@ -30,12 +31,14 @@ namespace {
             { schema::Encoding::PPF3, &details::ppf::V3::Parse }
          };
 
-      TDD_LOG_INFO() << "Parsing [" << ppf.wstring() << "]";
-
-      std::ifstream ppfStream(ppf, std::ifstream::binary);
+      if (ppf.size() < kMagicSize + kVersionSize) {
+         TDD_LOG_INFO() << "Not a PPF file";
+         return std::nullopt;
+      }
 
-      std::string magic(kMagicSize, '0');
-      ppfStream.read(magic.data(), magic.size());
+      const std::string_view magic(
+         reinterpret_cast<const char*>(ppf.data()),
+         kMagicSize);
 
       if (kMagic.count(magic) == 0) {
          TDD_LOG_INFO() << "Not a PPF file";
@@ -44,19 +47,55 @@ namespace {
       
       TDD_LOG_INFO() << "PPF-Magic: " << magic;
 
-      schema::Encoding encoding = schema::Encoding::PPF1;
-      ppfStream.read(reinterpret_cast<char*>(&encoding), sizeof(encoding));
+      const auto encoding = static_cast<schema::Encoding>(ppf[kMagicSize]);
 
       TDD_LOG_INFO() << "PPF encoding: " << static_cast<int>(encoding);
 
       const auto parser = kParsers.find(encoding);
       if (kParsers.end() != parser) {
-         return parser->second(ppfStream);
+         return parser->second(ppf);
       }
 
       TDD_LOG_INFO() << "Unsupport encoding";
       return std::nullopt;
    }
+
+   // Fallback for files that cannot be mapped.
+   std::optional<DataBuffer> ReadAll(const std::filesystem::path& ppf)
+   {
+      std::ifstream ppfStream(ppf, std::ifstream::binary | std::ifstream::ate);
+      if (!ppfStream.good()) {
+         TDD_LOG_ERROR() << "Unable to open [" << ppf.wstring() << "]";
+         return std::nullopt;
+      }
+
+      DataBuffer data(static_cast<size_t>(ppfStream.tellg()));
+      ppfStream.seekg(0);
+      ppfStream.read(reinterpret_cast<char*>(data.data()), data.size());
+      if (!ppfStream.good()) {
+         TDD_LOG_ERROR() << "Unable to read [" << ppf.wstring() << "]";
+         return std::nullopt;
+      }
+
+      return data;
+   }
+
+   std::optional<PatchDescriptor> DoParse(const std::filesystem::path& ppf)
+   {
+      TDD_LOG_INFO() << "Parsing [" << ppf.wstring() << "]";
+
+      const auto mapped = base::fs::MappedFile::Open(ppf);
+      if (mapped.has_value()) {
+         return DoParse(mapped.value().Data());
+      }
+
+      const auto data = ReadAll(ppf);
+      if (!data.has_value()) {
+         return std::nullopt;
+      }
+
+      return DoParse(data.value());
+   }
 }
 
 std::optional<PatchDescriptor> Parse(const std::filesystem::path& ppf)
@@ -75,4 +114,16 @@ std::optional<PatchDescriptor> Parse(const std::filesystem::path& ppf)
 
 }
 
+std::optional<PatchDescriptor> Parse(std::span<const uint8_t> ppf)
+{
+   try {
+      return DoParse(ppf);
+   }
+   catch (const std::exception& e) {
+      TDD_LOG_ERROR() << "Unable to parse patch: " << e.what();
+   }
+
+   return std::nullopt;
+}
+
 }
\ No newline at end of file
@@ -3,13 +3,13 @@
 #include "schema.h"
 
 #include <ppfbase/logging/logging.h>
+#include <ppfbase/stdext/cstring.h>
 #include <ppfbase/stdext/iostream.h>
 #include <ppfbase/stdext/system_error.h>
+#include <ppfbase/stdext/win32_error_codes.h>
 
 #include <fstream>
 
-#include <Windows.h>
-
 namespace tdd::tk::rompatch::ppf {
 
 namespace {
@@ -71,7 +71,7 @@ std::error_code WritePpf3Patch(
    const PatchDescriptor& patch)
 {
    std::ofstream ppf3;
-   ppf3.exceptions(0);
+   ppf3.exceptions(std::ios::goodbit);
    ppf3.open(ppf3Path, std::ofstream::binary | std::ofstream::trunc);
    if (!ppf3.good()) {
       TDD_LOG_ERROR() << "Unable to create file: [" << ppf3Path.wstring()
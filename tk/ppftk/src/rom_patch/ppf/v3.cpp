@@ -5,144 +5,171 @@
 #include <ppftk/rom_patch/ppf/ppf3.h>
 
 #include <ppfbase/logging/logging.h>
-#include <ppfbase/stdext/iostream.h>
+#include <ppfbase/stdext/cstring.h>
 #include <ppfbase/stdext/poor_mans_expected.h>
 #include <ppfbase/stdext/string.h>
+#include <ppfbase/stdext/win32_error_codes.h>
 
-#include <array>
-#include <istream>
-
-#include <Windows.h>
+#include <string_view>
 
 namespace tdd::tk::rompatch::details::ppf::V3 {
 
 namespace {
-   stdext::pm_expected<std::string> GetFileId(std::istream& ppf)
+   using PpfView = std::span<const uint8_t>;
+
+   [[nodiscard]] std::string_view AsString(const PpfView data) noexcept
    {
-      namespace fileid = schema::fileid;
+      return std::string_view(
+         reinterpret_cast<const char*>(data.data()),
+         data.size());
+   }
+
+   struct [[nodiscard]] FileId
+   {
+      std::string_view id;
+      // Bytes taken by the FILE_ID.DIZ block, magic strings and length
+      // included.
+      size_t blockSize = 0;
+   };
 
-      ppf.seekg(0, std::istream::end);
-      const size_t fileSize = ppf.tellg();
+   stdext::pm_expected<FileId> GetFileId(const PpfView ppf)
+   {
+      namespace fileid = schema::fileid;
 
       // Try to find the end tag first to see if we have any file id data.
-      ppf.seekg(fileid::kEndPos, std::istream::end);
-
-      std::string endMagic(fileid::kEndLength, '\0');
-      stdext::Read(ppf, endMagic);
+      static constexpr size_t kEndTagSize = fileid::kEndLength + fileid::kLengthSize;
+      if (ppf.size() < kEndTagSize) {
+         return stdext::make_win32_ec(ERROR_NOT_FOUND);
+      }
 
-      if (endMagic != fileid::kEnd) {
+      const auto endTag = ppf.last(kEndTagSize);
+      if (AsString(endTag.first(fileid::kEndLength)) != fileid::kEnd) {
          return stdext::make_win32_ec(ERROR_NOT_FOUND);
       }
 
       int16_t idDataLength = 0;
-      stdext::Read(ppf, idDataLength);
-      
+      memcpy_s(
+         &idDataLength,
+         sizeof(idDataLength),
+         endTag.data() + fileid::kEndLength,
+         fileid::kLengthSize);
+
       const auto idLength = idDataLength + fileid::kTotalPadding;
 
       if (idDataLength < 0
        || idDataLength > fileid::kDataMaxLength
-       || idLength > fileSize) {
+       || idLength > ppf.size()) {
          TDD_LOG_WARN() << "Invalid FileId length: " << idDataLength;
          return stdext::make_win32_ec(ERROR_INVALID_PARAMETER);
       }
 
-      int idBeginOffset = -static_cast<int>(idLength);
-
-      ppf.seekg(idBeginOffset, std::istream::end);
+      const auto idBlock = ppf.last(idLength);
 
-      std::string beginMagic(fileid::kBeginLength, '\0');
-      stdext::Read(ppf, beginMagic);
-
-      if (beginMagic != fileid::kBegin) {
+      if (AsString(idBlock.first(fileid::kBeginLength)) != fileid::kBegin) {
          TDD_LOG_WARN() << "[" << fileid::kBegin << "] not found";
          return stdext::make_win32_ec(ERROR_INVALID_PARAMETER);
       }
 
-      std::string fileId(idDataLength, '\0');
-      stdext::Read(ppf, fileId);
-      return fileId;
+      return FileId{
+         .id = AsString(idBlock.subspan(fileid::kBeginLength, idDataLength)),
+         .blockSize = idLength};
    }
 
-   [[nodiscard]] size_t DataLength(
-      std::istream& ppf,
-      const size_t fileIdLength)
+   [[nodiscard]] const schema::PatchEntry& EntryAt(
+      const PpfView entries,
+      const size_t offset) noexcept
    {
-      ppf.seekg(0, std::istream::end);
-      return static_cast<size_t>(ppf.tellg()) - fileIdLength;
+      return *reinterpret_cast<const schema::PatchEntry*>(
+         entries.data() + offset);
    }
 
-   bool ParsePatchData(
-      std::istream& ppf,
-      const bool hasUndo,
-      size_t unreadLength,
-      PatchDescriptor& patch)
+   struct [[nodiscard]] EntryStats
    {
-      static constexpr size_t kBlockSize = 64 * 1024;
-      const auto payloadMultiplier = 1 + (hasUndo ? 1 : 0);
-      
-      DataBuffer patchBlock;
-      do {
-         const auto staleSize = patchBlock.size();
-         const auto bytesToRead = std::min(kBlockSize, unreadLength);
-         const auto newSize = staleSize + bytesToRead;
-         patchBlock.resize(newSize);
-
-         ppf.read(
-            reinterpret_cast<char*>(patchBlock.data() + staleSize),
-            bytesToRead);
-
-         unreadLength -= bytesToRead;
-
-         auto it = patchBlock.cbegin();
-         while(true) {
-            const auto unreadBlock = static_cast<size_t>(
-               std::distance(it, patchBlock.cend()));
-            if (unreadBlock < schema::kPatchEntryHeaderSize) {
-               // End of current block. Get ready to read the next block
-               break;
-            }
-            const auto entry = reinterpret_cast<const schema::PatchEntry*>(&(*it));
-
-            const auto entrySize =
-               schema::kPatchEntryHeaderSize + entry->length * payloadMultiplier;
+      size_t count = 0;
+      size_t payloadSize = 0;
+   };
+
+   // Walks the entry headers without touching the payloads. Fails if the last
+   // entry is truncated.
+   [[nodiscard]] std::optional<EntryStats> CountEntries(
+      const PpfView entries,
+      const size_t payloadMultiplier) noexcept
+   {
+      EntryStats stats;
 
-            if (unreadBlock < entrySize) {
-               break;
-            }
+      size_t offset = 0;
+      while (entries.size() - offset >= schema::kPatchEntryHeaderSize) {
+         const auto length = EntryAt(entries, offset).length;
+         const auto entrySize =
+            schema::kPatchEntryHeaderSize + length * payloadMultiplier;
 
-            std::advance(it, entrySize);
+         if (entries.size() - offset < entrySize) {
+            break;
+         }
 
-            const auto added = patch.AddPatchData(
-               entry->address,
-               DataBuffer(entry->data, entry->data + entry->length));
+         ++stats.count;
+         stats.payloadSize += length;
+         offset += entrySize;
+      }
 
-            if (!added) {
-               TDD_LOG_WARN() << "Duplicate patch data for address: "
-                  << entry->address;
-               return false;
-            }
-         }
+      if (offset != entries.size()) {
+         TDD_LOG_WARN() << "Parsing failed. Malformed patch entry remains.";
+         return std::nullopt;
+      }
 
-         patchBlock.erase(patchBlock.begin(), it);
+      return stats;
+   }
 
-      } while(unreadLength> 0);
+   bool ParsePatchData(
+      const PpfView entries,
+      const bool hasUndo,
+      PatchDescriptor& patch)
+   {
+      const size_t payloadMultiplier = 1 + (hasUndo ? 1 : 0);
 
-      const bool success = patchBlock.empty();
+      const auto stats = CountEntries(entries, payloadMultiplier);
+      if (!stats.has_value()) {
+         return false;
+      }
 
-      if (!success) {
-         TDD_LOG_WARN() << "Parsing failed. Malformed patch entry remains.";
+      // The entries are parsed in place and every payload is copied exactly
+      // once, into storage reserved up front.
+      patch.Reserve(stats->count, stats->payloadSize);
+
+      size_t offset = 0;
+      while (offset < entries.size()) {
+         const auto& entry = EntryAt(entries, offset);
+         offset += schema::kPatchEntryHeaderSize
+            + entry.length * payloadMultiplier;
+
+         const auto added = patch.AddPatchData(
+            entry.address,
+            DataView(
+               reinterpret_cast<const uint8_t*>(entry.data),
+               entry.length));
+
+         if (!added) {
+            TDD_LOG_WARN() << "Duplicate patch data for address: "
+               << entry.address;
+            return false;
+         }
       }
-      return success;
+
+      return true;
    }
 }
 
-std::optional<PatchDescriptor> Parse(std::istream& ppf)
+std::optional<PatchDescriptor> Parse(const PpfView ppf)
 {
    auto fileIdExpected = GetFileId(ppf);
 
    PatchDescriptor patch;
+   size_t fileIdBlockSize = 0;
+
    if (fileIdExpected.has_value()) {
-      patch.AddFileId(std::move(fileIdExpected).value());
+      const auto& fileId = fileIdExpected.value();
+      patch.AddFileId(fileId.id);
+      fileIdBlockSize = fileId.blockSize;
    }
    else {
       const auto ec = fileIdExpected.handle_error(
@@ -158,26 +185,26 @@ std::optional<PatchDescriptor> Parse(std::istream& ppf)
       }
    }
 
-   const auto dataLength = DataLength(ppf, patch.GetFileId().length());
+   const auto dataLength = ppf.size() - fileIdBlockSize;
 
    if (dataLength < sizeof(schema::Header)) {
       TDD_LOG_WARN() << "File too small: " << dataLength;
       return std::nullopt;
    }
 
-   ppf.seekg(0);
    schema::Header hdr{0};
-   stdext::Read(ppf, hdr);
+   memcpy_s(&hdr, sizeof(hdr), ppf.data(), sizeof(hdr));
 
    std::string description(hdr.description, sizeof(hdr.description));
    stdext::StripTrailingNulls(description);
    patch.AddDescription(std::move(description));
 
-   size_t remainingData = dataLength - sizeof(hdr);
+   auto remainingData = ppf.subspan(sizeof(hdr), dataLength - sizeof(hdr));
 
    if (hdr.validateImage) {
-      if (remainingData < schema::kValidataionDataLength) {
-         TDD_LOG_WARN() << "Not enough validation data: " << remainingData;
+      if (remainingData.size() < schema::kValidataionDataLength) {
+         TDD_LOG_WARN() << "Not enough validation data: "
+            << remainingData.size();
          return std::nullopt;
       }
 
@@ -186,13 +213,14 @@ std::optional<PatchDescriptor> Parse(std::istream& ppf)
             ? schema::kPrimoDvdValidationAddress
             : schema::kAnyImageValidationAddress;
 
-      DataBuffer data(schema::kValidataionDataLength);
-      stdext::Read(ppf, data);
-      patch.AddValidationData(validationAddress, std::move(data));
-      remainingData -= schema::kValidataionDataLength;
+      const auto data = remainingData.first(schema::kValidataionDataLength);
+      patch.AddValidationData(
+         validationAddress,
+         DataBuffer(data.begin(), data.end()));
+      remainingData = remainingData.subspan(schema::kValidataionDataLength);
    }
 
-   if (!ParsePatchData(ppf, hdr.hasUndoData, remainingData, patch)) {
+   if (!ParsePatchData(remainingData, hdr.hasUndoData, patch)) {
       return std::nullopt;
    }
 
@@ -2,9 +2,11 @@
 
 #include <ppftk/rom_patch/patch_descriptor.h>
 
-#include <iosfwd>
+#include <cstdint>
 #include <optional>
+#include <span>
 
 namespace tdd::tk::rompatch::details::ppf::V3 {
-   std::optional<PatchDescriptor> Parse(std::istream& ppf);
+   // 'ppf' is the whole patch file, header included.
+   std::optional<PatchDescriptor> Parse(std::span<const uint8_t> ppf);
 }
\ No newline at end of file
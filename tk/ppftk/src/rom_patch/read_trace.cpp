@@ -0,0 +1,213 @@
+#include <ppftk/rom_patch/read_trace.h>
+
+#include <ppfbase/filesystem/path_service.h>
+#include <ppfbase/logging/logging.h>
+#include <ppfbase/process/this_module.h>
+#include <ppfbase/process/this_process.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <sstream>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   inline constexpr auto kTraceExt = L".trace";
+
+   [[nodiscard]] uint64_t Nanoseconds(
+      const ReadTrace::Clock::duration duration) noexcept
+   {
+      const auto ns =
+         std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+      return static_cast<uint64_t>(std::max<int64_t>(ns.count(), 0));
+   }
+
+   // Anything longer than 4 seconds is as good as forever for a read.
+   [[nodiscard]] uint32_t Saturate(const uint64_t value) noexcept
+   {
+      return static_cast<uint32_t>(
+         std::min<uint64_t>(value, std::numeric_limits<uint32_t>::max()));
+   }
+
+   [[nodiscard]] uint32_t ThreadId() noexcept
+   {
+      thread_local const auto t_threadId =
+         base::process::ThisProcess::CurrentThreadId();
+      return t_threadId;
+   }
+
+   // Of a field in the read-only view of a trace that may still be written
+   // to. std::atomic_ref wants a mutable object, but a load of an aligned
+   // 64-bit value doesn't write on any 64-bit target.
+   [[nodiscard]] uint64_t LoadAtomic(
+      const uint64_t& field,
+      const std::memory_order order) noexcept
+   {
+      return std::atomic_ref(const_cast<uint64_t&>(field)).load(order);
+   }
+
+   [[nodiscard]] bool IsValid(
+      const ReadTraceHeader& header,
+      const uint64_t fileSize) noexcept
+   {
+      return header.magic == ReadTraceHeader::kMagic
+          && header.version == ReadTraceHeader::kVersion
+          && header.recordSize == sizeof(ReadTraceRecord)
+          && std::has_single_bit(header.capacity)
+          && header.capacity
+             == (fileSize - sizeof(header)) / sizeof(ReadTraceRecord);
+   }
+}
+
+std::unique_ptr<ReadTrace> ReadTrace::Create(
+   const fs::path& file,
+   const uint32_t records)
+{
+   const auto capacity = std::bit_ceil(std::max<uint64_t>(records, 2));
+   auto mapped = base::fs::WritableMappedFile::Create(
+      file,
+      sizeof(ReadTraceHeader) + capacity * sizeof(ReadTraceRecord));
+   if (!mapped.has_value()) {
+      return nullptr;
+   }
+
+   const auto start = Clock::now();
+   const auto startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+
+   // The file starts out zeroed, so are the records.
+   auto& header =
+      *reinterpret_cast<ReadTraceHeader*>(mapped.value().Data().data());
+   header.magic = ReadTraceHeader::kMagic;
+   header.version = ReadTraceHeader::kVersion;
+   header.recordSize = sizeof(ReadTraceRecord);
+   header.capacity = capacity;
+   header.startTime = startTime.count();
+   header.processId = base::process::ThisProcess::Id();
+
+   TDD_LOG_INFO() << "Tracing the last " << capacity << " reads in ["
+                  << file.wstring() << "]";
+   return std::unique_ptr<ReadTrace>(
+      new ReadTrace(std::move(mapped.value()), start));
+}
+
+std::optional<fs::path> ReadTrace::DllTracePath()
+{
+   const auto logDir = base::fs::PathService::DllLogDirectory();
+   if (!logDir.has_value()) {
+      return std::nullopt;
+   }
+
+   std::wostringstream name;
+   name << base::process::ThisModule::Name().stem().wstring() << "."
+      << base::process::ThisProcess::Name().stem().wstring() << "."
+      << base::process::ThisProcess::Id() << kTraceExt;
+   return logDir.value() / name.str();
+}
+
+std::optional<ReadTrace::Contents> ReadTrace::Load(const fs::path& file)
+{
+   const auto mapped = base::fs::MappedFile::Open(file);
+   if (!mapped.has_value()) {
+      TDD_LOG_ERROR() << "Unable to open [" << file.wstring() << "]: "
+                      << mapped.error().message();
+      return std::nullopt;
+   }
+
+   const auto data = mapped.value().Data();
+   if (data.size() < sizeof(ReadTraceHeader)) {
+      TDD_LOG_ERROR() << "[" << file.wstring() << "] is not a read trace";
+      return std::nullopt;
+   }
+
+   Contents contents{};
+   const auto& header = *reinterpret_cast<const ReadTraceHeader*>(data.data());
+   std::memcpy(&contents.header, &header, sizeof(ReadTraceHeader));
+   contents.header.next = LoadAtomic(header.next, std::memory_order_acquire);
+   if (!IsValid(contents.header, data.size())) {
+      TDD_LOG_ERROR() << "[" << file.wstring() << "] is not a read trace";
+      return std::nullopt;
+   }
+
+   // A slot holds a record of the current lap unless it is still being
+   // written, or it was never written at all. The process may still be
+   // writing, so a slot only counts if its sequence is the same before and
+   // after it is copied.
+   const std::span slots(
+      reinterpret_cast<const ReadTraceRecord*>(
+         data.data() + sizeof(ReadTraceHeader)),
+      contents.header.capacity);
+   const auto next = contents.header.next;
+   const auto mask = contents.header.capacity - 1;
+   for (size_t slot = 0; slot < slots.size(); ++slot) {
+      const auto sequence =
+         LoadAtomic(slots[slot].sequence, std::memory_order_acquire);
+      if (0 == sequence
+       || sequence > next
+       || ((sequence - 1) & mask) != slot) {
+         continue;
+      }
+
+      ReadTraceRecord record;
+      std::memcpy(&record, &slots[slot], sizeof(ReadTraceRecord));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence
+       != LoadAtomic(slots[slot].sequence, std::memory_order_relaxed)) {
+         continue;
+      }
+
+      record.sequence = sequence;
+      contents.records.push_back(record);
+   }
+
+   std::ranges::sort(contents.records, {}, &ReadTraceRecord::sequence);
+   return contents;
+}
+
+ReadTrace::ReadTrace(
+   base::fs::WritableMappedFile&& file,
+   const Clock::time_point start) noexcept
+   : m_file(std::move(file))
+   , m_header(*reinterpret_cast<ReadTraceHeader*>(m_file.Data().data()))
+   , m_records(reinterpret_cast<ReadTraceRecord*>(
+      m_file.Data().data() + sizeof(ReadTraceHeader)))
+   , m_mask(m_header.capacity - 1)
+   , m_start(start)
+{}
+
+void ReadTrace::Add(const Read& read) noexcept
+{
+   const auto index = std::atomic_ref(m_header.next)
+      .fetch_add(1, std::memory_order_relaxed);
+   auto& record = m_records[index & m_mask];
+
+   // A reader seeing the new fields sees the cleared sequence too. A writer
+   // one lap ahead would need the whole ring to wrap during this call.
+   std::atomic_ref sequence(record.sequence);
+   sequence.store(0, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+
+   record.time = Nanoseconds(read.start - m_start);
+   record.offset = read.offset;
+   record.threadId = ThreadId();
+   record.length = Saturate(read.length);
+   record.patchedBytes = Saturate(read.patchedBytes);
+   record.extraReads = read.extraReads;
+   record.readTime = Saturate(Nanoseconds(read.read - read.start));
+   record.patchTime = Saturate(Nanoseconds(read.patched - read.read));
+
+   sequence.store(index + 1, std::memory_order_release);
+}
+
+uint64_t ReadTrace::Capacity() const noexcept
+{
+   return m_mask + 1;
+}
+
+}
\ No newline at end of file
@@ -1,22 +1,12 @@
 #include <ppftk/rom_patch/simple_patcher.h>
 
-#include "apply_patches.h"
-
 #include <algorithm>
 
 namespace tdd::tk::rompatch {
 
-SimplePatcher::SimplePatcher(PatchDescriptor&& fullPatch) noexcept
-   : m_patches(std::move(fullPatch).TakeFullPatch())
-   , m_addrRange(0, 0)
-{
-   if (m_patches.empty()) {
-      return;
-   }
-
-   m_addrRange.first = m_patches.front().address;
-   m_addrRange.second = m_patches.back().address + m_patches.back().data.size();
-}
+SimplePatcher::SimplePatcher(PatchDescriptor&& fullPatch)
+   : m_index(std::move(fullPatch).TakeFullPatch())
+{}
 
 std::optional<IPatcher::AdditionalReads> SimplePatcher::Patch(
    const uint64_t addr,
@@ -27,28 +17,26 @@ std::optional<IPatcher::AdditionalReads> SimplePatcher::Patch(
       return std::nullopt;
    }
 
-   // std::lower_bound finds the first item that fails the predicate. The
-   // predicate used to do the search must match the predicate used to sort
-   // the container. We want the entry such that 'p.address <= addr'. For this
-   // we need search backwards with 'operator>'.
-   const auto rit = std::lower_bound(
-      m_patches.rbegin(),
-      m_patches.rend(),
-      addr,
-      [](const auto& p, const auto addr) {
-         return p.address > addr;
-      }
-   );
+   m_index.Apply(addr, buffer);
 
-   // https://en.cppreference.com/w/cpp/iterator/reverse_iterator/base
-   auto it = rit.base();
-   if (it != m_patches.begin()) {
-      --it;
-   }
+   return std::nullopt;
+}
 
-   ApplyPatches(addr, buffer, it, m_patches.end());
+uint64_t SimplePatcher::PatchedBytes(
+   const uint64_t addr,
+   const uint64_t size) const noexcept
+{
+   const auto end = addr + size;
+
+   uint64_t bytes = 0;
+   for (auto idx = m_index.Find(addr);
+        idx < m_index.Size() && m_index.EntryStart(idx) < end;
+        ++idx) {
+      bytes += std::min(m_index.EntryEnd(idx), end)
+         - std::max(m_index.EntryStart(idx), addr);
+   }
 
-   return std::nullopt;
+   return bytes;
 }
 
 bool SimplePatcher::Overlaps(
@@ -56,11 +44,11 @@ bool SimplePatcher::Overlaps(
    const uint64_t tgtEnd) const noexcept
 {
    // [tgtStart, tgtEnd)
-   if (tgtEnd <= m_addrRange.first) {
+   if (tgtEnd <= m_index.Start()) {
       return false;
    }
 
-   if (m_addrRange.second <= tgtStart) {
+   if (m_index.End() <= tgtStart) {
       return false;
    }
 
@@ -0,0 +1,248 @@
+#include <ppftk/rom_patch/apply_patches.h>
+
+#include <ppftk/rom_patch/patch_descriptor.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   // ApplyPatches() before it was clipped with min/max. Kept to check the
+   // kernel against and to benchmark it.
+   template <typename Iter>
+   void ApplyItemByItem(
+      const uint64_t addr,
+      std::span<uint8_t> target,
+      const Iter patchBegin,
+      const Iter patchEnd)
+   {
+      const auto targetEnd = addr + target.size();
+
+      for (auto it = patchBegin; it != patchEnd && it->address < targetEnd;
+           ++it) {
+         const auto patchEndAddr = it->address + it->data.size();
+         if (patchEndAddr <= addr) {
+            continue;
+         }
+
+         if (it->address <= addr) {
+            const size_t skip = addr - it->address;
+            const auto copySize =
+               std::min(target.size_bytes(), it->data.size() - skip);
+            memcpy_s(target.data(), copySize, &it->data[skip], copySize);
+         }
+         else {
+            const auto offset = it->address - addr;
+            const auto copySize =
+               std::min(target.size_bytes() - offset, it->data.size());
+            memcpy_s(&target[offset], copySize, it->data.data(), copySize);
+         }
+      }
+   }
+
+   [[nodiscard]] std::vector<PatchItem> Merge(
+      const PatchDescriptor::FullPatch& patches)
+   {
+      std::vector<PatchItem> merged;
+      for (const auto& item : patches) {
+         if (merged.empty() || !MergePatchItem(merged.back(), item)) {
+            merged.push_back(item);
+         }
+      }
+      return merged;
+   }
+
+   // Shaped like a randomizer seed: clusters of small scattered edits, item
+   // and enemy tables, next to long runs split into 255 byte PPF records,
+   // code and text.
+   [[nodiscard]] PatchDescriptor BuildSeedLikePatches(
+      const uint32_t seed,
+      const uint64_t imageSize,
+      const size_t clusters)
+   {
+      std::mt19937 rng(seed);
+      std::uniform_int_distribution<uint64_t> clusterStart(0, imageSize - 1);
+      std::uniform_int_distribution<size_t> smallGap(4, 600);
+      std::uniform_int_distribution<size_t> smallLength(1, 4);
+      std::uniform_int_distribution<size_t> runLength(256, 8 * 1024);
+      std::bernoulli_distribution isRun(0.05);
+
+      PatchDescriptor patches;
+      for (size_t c = 0; c < clusters; ++c) {
+         auto addr = clusterStart(rng);
+         for (size_t i = 0; i < 200 && addr < imageSize; ++i) {
+            const auto length =
+               std::min<uint64_t>(
+                  isRun(rng) ? runLength(rng) : smallLength(rng),
+                  imageSize - addr);
+
+            for (uint64_t done = 0; done < length;) {
+               DataBuffer record(std::min<uint64_t>(255, length - done));
+               std::iota(
+                  record.begin(),
+                  record.end(),
+                  static_cast<uint8_t>(addr + done));
+               if (!patches.AddPatchData(addr + done, record)) {
+                  break;
+               }
+               done += record.size();
+            }
+
+            addr += length + smallGap(rng);
+         }
+      }
+
+      // Clusters may have run into each other. Only data added in address
+      // order is applied the same way item by item.
+      auto& full = patches.GetFullPatch();
+      PatchDescriptor sorted;
+      uint64_t end = 0;
+      for (const auto& item : full) {
+         if (item.address >= end) {
+            std::ignore = sorted.AddPatchData(item.address, item.data);
+            end = item.address + item.data.size();
+         }
+      }
+      return sorted;
+   }
+}
+
+TEST_CASE("ApplyPatches: matches applying item by item")
+{
+   static constexpr uint64_t kImageSize = 256 * 1024;
+
+   for (const uint32_t seed : {1u, 2u, 3u}) {
+      const auto patches = BuildSeedLikePatches(seed, kImageSize, 8);
+      const auto& items = patches.GetFullPatch();
+      const auto merged = Merge(items);
+
+      std::mt19937 rng(seed);
+      std::uniform_int_distribution<uint64_t> start(0, kImageSize - 1);
+      std::uniform_int_distribution<size_t> length(0, 64 * 1024);
+
+      for (auto i = 0; i < 500; ++i) {
+         const auto addr = start(rng);
+         const auto size = std::min<uint64_t>(length(rng), kImageSize - addr);
+
+         DataBuffer expected(size, 0xEE);
+         ApplyItemByItem(addr, expected, items.begin(), items.end());
+
+         DataBuffer window(size, 0xEE);
+         ApplyPatches(addr, window, items);
+         REQUIRE(expected == window);
+
+         std::fill(window.begin(), window.end(), 0xEE);
+         ApplyPatches(addr, window, merged);
+         REQUIRE(expected == window);
+      }
+   }
+}
+
+TEST_CASE("ApplyPatches: overlapping patch data matches applying item by item")
+{
+   // Shorter records on top of a long one, in the order a PPF lists them.
+   // The last one reaches past the end of the long one.
+   const DataBuffer base(100, 0xAA);
+   const DataBuffer edit{1, 2, 3, 4};
+   const DataBuffer tail(50, 0xBB);
+   const std::vector<PatchItem> items{
+      {.address = 0, .data = base},
+      {.address = 10, .data = edit},
+      {.address = 30, .data = edit},
+      {.address = 60, .data = tail}};
+
+   PatchDescriptor patches;
+   for (const auto& item : items) {
+      CHECK(patches.AddPatchData(item.address, item.data));
+   }
+   CHECK(1 == patches.GetFullPatch().size());
+
+   for (uint64_t addr = 0; addr < 120; ++addr) {
+      for (const size_t size : {1, 7, 40, 120}) {
+         DataBuffer expected(size, 0xEE);
+         ApplyItemByItem(addr, expected, items.begin(), items.end());
+
+         DataBuffer window(size, 0xEE);
+         ApplyPatches(addr, window, patches.GetFullPatch());
+         REQUIRE(expected == window);
+      }
+   }
+}
+
+TEST_CASE("ApplyPatches: only runs contiguous in memory are merged")
+{
+   const std::array<uint8_t, 8> payload = {0, 1, 2, 3, 4, 5, 6, 7};
+   const DataView data(payload);
+
+   PatchItem last{.address = 100, .data = data.first(2)};
+   CHECK(MergePatchItem(last, {.address = 102, .data = data.subspan(2, 2)}));
+   CHECK(100 == last.address);
+   CHECK(4 == last.data.size());
+
+   // Next in the target, not in memory.
+   CHECK_FALSE(
+      MergePatchItem(last, {.address = 104, .data = data.subspan(5, 1)}));
+   // Next in memory, not in the target.
+   CHECK_FALSE(
+      MergePatchItem(last, {.address = 105, .data = data.subspan(4, 1)}));
+   CHECK(4 == last.data.size());
+}
+
+// ppftk_test -tc="ApplyPatches: benchmark*" --no-skip
+TEST_CASE("ApplyPatches: benchmark sequential reads" * doctest::skip())
+{
+   using Clock = std::chrono::steady_clock;
+
+   static constexpr uint64_t kImageSize = 64 * 1024 * 1024;
+   static constexpr size_t kReadSize = 64 * 1024;
+   static constexpr size_t kPasses = 20;
+
+   const auto patches = BuildSeedLikePatches(7, kImageSize, 400);
+   const auto& items = patches.GetFullPatch();
+   const auto merged = Merge(items);
+
+   DataBuffer window(kReadSize);
+   const auto run = [&](const auto& apply) {
+      const auto start = Clock::now();
+      for (size_t pass = 0; pass < kPasses; ++pass) {
+         for (uint64_t addr = 0; addr < kImageSize; addr += kReadSize) {
+            apply(addr, std::span(window));
+         }
+      }
+      return std::chrono::duration<double, std::milli>(Clock::now() - start);
+   };
+
+   // Both start from the first item overlapping the read, as a caller with
+   // an index would.
+   const auto firstItem = [](const auto& list, const uint64_t addr) {
+      return std::partition_point(
+         list.begin(),
+         list.end(),
+         [addr](const PatchItem& item) {
+            return item.address + item.data.size() <= addr;
+         });
+   };
+
+   const auto itemByItem = run([&](uint64_t addr, std::span<uint8_t> target) {
+      ApplyItemByItem(addr, target, firstItem(items, addr), items.end());
+   });
+   const auto kernel = run([&](uint64_t addr, std::span<uint8_t> target) {
+      ApplyPatches(addr, target, items);
+   });
+   const auto kernelMerged = run([&](uint64_t addr, std::span<uint8_t> t) {
+      ApplyPatches(addr, t, merged);
+   });
+
+   MESSAGE(
+      items.size() << " items, " << merged.size() << " runs. "
+      << "Item by item: " << itemByItem.count() << " ms. "
+      << "Clipped: " << kernel.count() << " ms. "
+      << "Clipped, merged: " << kernelMerged.count() << " ms.");
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <ppftk/rom_patch/async_patcher.h>
+
+#include <ppftk/rom_patch/simple_patcher.h>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <future>
+#include <utility>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   using namespace std::chrono_literals;
+
+   static constexpr uint64_t kPatchAddr = 100;
+   static constexpr uint8_t kPatchData[] = {1, 2, 3, 4};
+
+   PatchDescriptor BuildPatches()
+   {
+      PatchDescriptor patches;
+      CHECK(patches.AddPatchData(kPatchAddr, kPatchData));
+      return patches;
+   }
+
+   // Stands in for the open/read sequence of the hooks: the target is opened,
+   // the loader is started, and reads are issued from another thread while
+   // the loader is held at 'gate'.
+   struct [[nodiscard]] GatedLoad
+   {
+      GatedLoad(const bool announce)
+         : gate()
+         , patcher([this, announce](const AsyncPatcher::Announce& publish) {
+            auto patches = BuildPatches();
+            if (announce) {
+               publish(AsyncPatcher::CoveredRanges(patches.GetFullPatch(), 1));
+            }
+
+            gate.get_future().wait();
+            return std::make_unique<SimplePatcher>(std::move(patches));
+         })
+         , released(false)
+      {}
+
+      // The loader is joined with 'patcher', so it must not be left waiting
+      // when a check fails.
+      ~GatedLoad()
+      {
+         Release();
+      }
+
+      void Release()
+      {
+         if (!std::exchange(released, true)) {
+            gate.set_value();
+         }
+      }
+
+      [[nodiscard]] std::future<DataBuffer> Read(
+         const uint64_t addr,
+         const size_t size)
+      {
+         return std::async(std::launch::async, [this, addr, size] {
+            DataBuffer buffer(size, 0xEE);
+            CHECK(!patcher.Patch(addr, buffer).has_value());
+            return buffer;
+         });
+      }
+
+      std::promise<void> gate;
+      AsyncPatcher patcher;
+      bool released;
+   };
+}
+
+TEST_CASE("AsyncPatcher: covered ranges are widened and merged")
+{
+   static constexpr uint8_t kData[4] = {};
+   const PatchDescriptor::FullPatch patches{
+      {.address = 10, .data = DataView(kData, 2)},
+      {.address = 30, .data = DataView(kData, 4)},
+      {.address = 70, .data = DataView(kData, 1)}};
+
+   const auto ranges = AsyncPatcher::CoveredRanges(patches, 16);
+   REQUIRE(2 == ranges.size());
+   CHECK(0 == ranges[0].start);
+   CHECK(48 == ranges[0].end);
+   CHECK(64 == ranges[1].start);
+   CHECK(80 == ranges[1].end);
+}
+
+TEST_CASE("AsyncPatcher: unpatched reads don't wait for the loader")
+{
+   GatedLoad load(true);
+
+   auto before = load.Read(0, kPatchAddr);
+   auto after = load.Read(kPatchAddr + sizeof(kPatchData), 64);
+
+   CHECK(std::future_status::ready == before.wait_for(5s));
+   CHECK(std::future_status::ready == after.wait_for(5s));
+   CHECK(DataBuffer(kPatchAddr, 0xEE) == before.get());
+   CHECK(DataBuffer(64, 0xEE) == after.get());
+
+   load.Release();
+   CHECK(load.patcher.Wait());
+}
+
+TEST_CASE("AsyncPatcher: patched reads wait for the loader")
+{
+   GatedLoad load(true);
+
+   auto read = load.Read(kPatchAddr - 2, 8);
+   CHECK(std::future_status::timeout == read.wait_for(50ms));
+
+   load.Release();
+   CHECK(DataBuffer{0xEE, 0xEE, 1, 2, 3, 4, 0xEE, 0xEE} == read.get());
+}
+
+TEST_CASE("AsyncPatcher: reads wait until the ranges are known")
+{
+   GatedLoad load(false);
+
+   auto read = load.Read(0, 16);
+   CHECK(std::future_status::timeout == read.wait_for(50ms));
+
+   load.Release();
+   CHECK(DataBuffer(16, 0xEE) == read.get());
+}
+
+TEST_CASE("AsyncPatcher: patched bytes of a read")
+{
+   bool announce = true;
+
+   SUBCASE("Announced")
+   {
+   }
+
+   // Counted by the patcher alone.
+   SUBCASE("Not announced")
+   {
+      announce = false;
+   }
+
+   GatedLoad load(announce);
+   load.Release();
+   CHECK(load.patcher.Wait());
+
+   CHECK(0 == load.patcher.PatchedBytes(0, kPatchAddr));
+   CHECK(4 == load.patcher.PatchedBytes(0, 200));
+   CHECK(2 == load.patcher.PatchedBytes(kPatchAddr + 2, 64));
+   CHECK(1 == load.patcher.PatchedBytes(kPatchAddr + 1, 1));
+   CHECK(0 == load.patcher.PatchedBytes(kPatchAddr + 4, 64));
+}
+
+TEST_CASE("AsyncPatcher: nothing to patch")
+{
+   AsyncPatcher patcher([](const AsyncPatcher::Announce&) {
+      return std::unique_ptr<IPatcher>();
+   });
+
+   CHECK_FALSE(patcher.Wait());
+
+   DataBuffer buffer(16, 0xEE);
+   CHECK(!patcher.Patch(0, buffer).has_value());
+   CHECK(DataBuffer(16, 0xEE) == buffer);
+}
+
+}
\ No newline at end of file
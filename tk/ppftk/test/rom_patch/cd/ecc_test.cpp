@@ -0,0 +1,41 @@
+#include <ppftk/rom_patch/cd/ecc.h>
+
+#include "test_sector_data.h"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+
+namespace tdd::tk::rompatch::cd {
+
+TEST_CASE("Ecc: Regenerate XA Form 1 parity")
+{
+   auto sector = TestSector::kVerificationSectorRaw;
+   auto raw = reinterpret_cast<spec::Sector*>(sector.data());
+
+   memset(raw->xa.form1.pParity, 0, spec::kEccPSize);
+   memset(raw->xa.form1.qParity, 0, spec::kEccQSize);
+
+   ecc::CalculateXaForm1Ecc(raw);
+   CHECK(sector == TestSector::kVerificationSectorRaw);
+}
+
+TEST_CASE("Ecc: Mode 1 parity covers the header")
+{
+   auto mode1 = TestSector::kVerificationSectorRaw;
+   auto xa = TestSector::kVerificationSectorRaw;
+
+   auto mode1Sector = reinterpret_cast<spec::Sector*>(mode1.data());
+   auto xaSector = reinterpret_cast<spec::Sector*>(xa.data());
+
+   ecc::CalculateMode1Ecc(mode1Sector);
+   CHECK(mode1 != xa);
+
+   // XA treats the header as 0.
+   mode1Sector->header.full = 0;
+   ecc::CalculateMode1Ecc(mode1Sector);
+   mode1Sector->header = xaSector->header;
+   CHECK(mode1 == xa);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <ppftk/rom_patch/cd/patch_cache.h>
+
+#include "test_sector_data.h"
+
+#include <ppftk/rom_patch/patch_descriptor.h>
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace tdd::tk::rompatch::cd {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   void WriteFile(const fs::path& file, const uint64_t at, DataView data)
+   {
+      std::ofstream os(file, std::ofstream::binary | std::ofstream::trunc);
+      os.seekp(at);
+      os.write(reinterpret_cast<const char*>(data.data()), data.size());
+   }
+
+   // A baked Patcher for the test sector, with its cache, image and stand-in
+   // PPF in the temp directory.
+   struct [[nodiscard]] CacheFixture
+   {
+      CacheFixture()
+         : sources{
+            .ppf = fs::temp_directory_path() / "ppftk_patch_cache.ppf",
+            .image = fs::temp_directory_path() / "ppftk_patch_cache.bin"}
+         , cache(PatchCache::CachePath(sources.image))
+      {
+         // The cache only fingerprints the PPF, so any content will do.
+         static constexpr uint8_t kPpf[] = {'P', 'P', 'F', '3', '0'};
+         WriteFile(sources.ppf, 0, kPpf);
+         WriteFile(
+            sources.image,
+            TestSector::kSectorAddr.get(),
+            TestSector::kOriginalSector);
+
+         PatchDescriptor patches;
+         CHECK(patches.AddPatchData(
+            TestSector::kPatch.address,
+            TestSector::kPatch.data));
+
+         Patcher patcher(std::move(patches));
+         CHECK(patcher.Bake(sources.image));
+         CHECK(!PatchCache::Save(cache, sources, patcher));
+      }
+
+      ~CacheFixture()
+      {
+         std::error_code ec;
+         fs::remove(sources.ppf, ec);
+         fs::remove(sources.image, ec);
+         fs::remove(cache, ec);
+      }
+
+      PatchCache::Sources sources;
+      fs::path cache;
+   };
+}
+
+TEST_CASE("PatchCache: loaded patcher needs no additional reads")
+{
+   static constexpr size_t kOffset = 16;
+
+   CacheFixture fixture;
+   auto patcher = PatchCache::Load(fixture.cache, fixture.sources);
+   REQUIRE(patcher.has_value());
+   REQUIRE(1 == patcher.value().SectorPatches().size());
+
+   auto sectorData = TestSector::kOriginalSector;
+   std::span<uint8_t> targetPortion(
+      sectorData.begin() + kOffset,
+      sectorData.end() - kOffset);
+
+   CHECK(!patcher.value()
+             .Patch(TestSector::kSectorAddr.get() + kOffset, targetPortion)
+             .has_value());
+
+   CHECK(
+      0 ==
+      memcmp(
+         &TestSector::kVerificationSectorRaw[kOffset],
+         targetPortion.data(),
+         targetPortion.size_bytes()));
+}
+
+TEST_CASE("PatchCache: changed inputs invalidate the cache")
+{
+   CacheFixture fixture;
+
+   SUBCASE("PPF")
+   {
+      static constexpr uint8_t kOtherPpf[] = {'P', 'P', 'F', '3', '1'};
+      WriteFile(fixture.sources.ppf, 0, kOtherPpf);
+   }
+
+   SUBCASE("Image")
+   {
+      std::ofstream os(fixture.sources.image, std::ofstream::app);
+      os << "grown";
+   }
+
+   CHECK(!PatchCache::Load(fixture.cache, fixture.sources).has_value());
+}
+
+TEST_CASE("PatchCache: concurrent saves don't overwrite each other")
+{
+   static constexpr size_t kWriters = 4;
+
+   CacheFixture fixture;
+   const auto patcher = PatchCache::Load(fixture.cache, fixture.sources);
+   REQUIRE(patcher.has_value());
+
+   std::vector<std::error_code> results(kWriters);
+   {
+      std::vector<std::jthread> writers;
+      for (size_t w = 0; w < kWriters; ++w) {
+         writers.emplace_back([&, w] {
+            results[w] = PatchCache::Save(
+               fixture.cache,
+               fixture.sources,
+               patcher.value());
+         });
+      }
+   }
+
+   for (const auto& ec : results) {
+      CHECK(!ec);
+   }
+   CHECK(PatchCache::Load(fixture.cache, fixture.sources).has_value());
+
+   // No staging file is left behind.
+   const auto prefix = fixture.cache.filename().wstring();
+   const auto dir = fixture.cache.parent_path();
+   for (const auto& entry : fs::directory_iterator(dir)) {
+      const auto name = entry.path().filename().wstring();
+      CHECK((name == prefix || !name.starts_with(prefix)));
+   }
+}
+
+TEST_CASE("PatchCache: truncated cache is rejected")
+{
+   CacheFixture fixture;
+   const auto size = fs::file_size(fixture.cache);
+   fs::resize_file(fixture.cache, size - 1);
+
+   CHECK(!PatchCache::Load(fixture.cache, fixture.sources).has_value());
+}
+
+}
\ No newline at end of file
@@ -2,10 +2,19 @@
 
 #include "test_sector_data.h"
 
+#include <ppftk/rom_patch/extra_reads.h>
 #include <ppftk/rom_patch/patch_descriptor.h>
 
 #include <doctest/doctest.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <latch>
+#include <random>
+#include <thread>
+
 namespace tdd::tk::rompatch::cd {
 
 namespace {
@@ -73,4 +82,229 @@ TEST_CASE("Patcher: patching 1 partial sector")
       TestSector::kVerificationSector->xa.form1.edc.full);
 }
 
+TEST_CASE("Patcher: baked sectors need no additional reads")
+{
+   static constexpr size_t kOffset = 16;
+
+   const auto image =
+      std::filesystem::temp_directory_path() / "ppftk_patcher_bake.bin";
+
+   {
+      std::ofstream os(image, std::ofstream::binary | std::ofstream::trunc);
+      os.seekp(TestSector::kSectorAddr.get());
+      os.write(
+         reinterpret_cast<const char*>(TestSector::kOriginalSector.data()),
+         TestSector::kOriginalSector.size());
+   }
+
+   Patcher patcher(BuildPatches());
+   CHECK(patcher.Bake(image));
+   std::filesystem::remove(image);
+
+   auto sectorData = TestSector::kOriginalSector;
+   std::span<uint8_t> targetPortion(
+      sectorData.begin() + kOffset,
+      sectorData.end() - kOffset);
+
+   CHECK(!patcher.Patch(TestSector::kSectorAddr.get() + kOffset, targetPortion)
+             .has_value());
+
+   CHECK(
+      0 ==
+      memcmp(
+         &TestSector::kVerificationSectorRaw[kOffset],
+         targetPortion.data(),
+         targetPortion.size_bytes()));
+}
+
+TEST_CASE("Patcher: sectors missing from the image are left unbaked")
+{
+   const auto image =
+      std::filesystem::temp_directory_path() / "ppftk_patcher_short.bin";
+
+   {
+      std::ofstream os(image, std::ofstream::binary | std::ofstream::trunc);
+      os.write(
+         reinterpret_cast<const char*>(TestSector::kOriginalSector.data()),
+         TestSector::kOriginalSector.size());
+   }
+
+   Patcher patcher(BuildPatches());
+   CHECK_FALSE(patcher.Bake(image));
+   std::filesystem::remove(image);
+
+   auto sectorData = TestSector::kOriginalSector;
+   const auto additionalReads = patcher.Patch(
+      TestSector::kSectorAddr.get() + 1,
+      std::span(sectorData).subspan(1));
+   CHECK(additionalReads.has_value());
+}
+
+TEST_CASE("Patcher: only reads of patched sectors are touched")
+{
+   Patcher patcher(BuildPatches());
+
+   const auto cleanAddr = TestSector::kSectorAddr.get() + spec::kSectorSize;
+   auto cleanData = TestSector::kOriginalSector;
+   for (int i = 0; i < 3; ++i) {
+      CHECK_FALSE(patcher.Patch(cleanAddr, cleanData).has_value());
+      CHECK(cleanData == TestSector::kOriginalSector);
+   }
+
+   for (int i = 0; i < 3; ++i) {
+      auto sectorData = TestSector::kOriginalSector;
+      CHECK_FALSE(
+         patcher.Patch(TestSector::kSectorAddr.get(), sectorData).has_value());
+      const auto sector = reinterpret_cast<spec::Sector*>(sectorData.data());
+      CHECK(
+         sector->xa.form1.edc.full ==
+         TestSector::kVerificationSector->xa.form1.edc.full);
+   }
+
+   // Ends on the last byte before the patched sector.
+   auto beforeData = TestSector::kOriginalSector;
+   CHECK_FALSE(patcher
+      .Patch(TestSector::kSectorAddr.get() - beforeData.size(), beforeData)
+      .has_value());
+   CHECK(beforeData == TestSector::kOriginalSector);
+}
+
+TEST_CASE("Patcher: concurrent reads match the pre-patched image")
+{
+   static constexpr size_t kSectors = 64;
+   static constexpr size_t kThreads = 8;
+   static constexpr size_t kReadsPerThread = 400;
+   static constexpr size_t kRounds = 8;
+
+   // Every sector is a copy of the test sector. Every third one is patched
+   // the same way, so it has to come out as the verification sector.
+   DataBuffer image;
+   DataBuffer expected;
+   std::vector<uint64_t> patchAddrs;
+   for (size_t i = 0; i < kSectors; ++i) {
+      image.insert(
+         image.end(),
+         TestSector::kOriginalSector.begin(),
+         TestSector::kOriginalSector.end());
+
+      if (0 != i % 3) {
+         expected.insert(
+            expected.end(),
+            TestSector::kOriginalSector.begin(),
+            TestSector::kOriginalSector.end());
+         continue;
+      }
+
+      expected.insert(
+         expected.end(),
+         TestSector::kVerificationSectorRaw.begin(),
+         TestSector::kVerificationSectorRaw.end());
+      patchAddrs.push_back(
+         i * spec::kSectorSize + TestSector::kSectorOffset.get());
+   }
+
+   const ReadAt readAt = [&image](
+                            const uint64_t addr,
+                            std::span<uint8_t> buffer) {
+      if (addr + buffer.size() > image.size()) {
+         return false;
+      }
+      std::memcpy(buffer.data(), image.data() + addr, buffer.size());
+      return true;
+   };
+
+   for (size_t round = 0; round < kRounds; ++round) {
+      // A fresh patcher every round. All threads race on the first read of
+      // each sector.
+      PatchDescriptor patches;
+      for (const auto addr : patchAddrs) {
+         CHECK(patches.AddPatchData(addr, TestSector::kPatch.data));
+      }
+
+      Patcher patcher(std::move(patches));
+      std::atomic<size_t> mismatches = 0;
+      std::latch start(kThreads);
+
+      {
+         std::vector<std::jthread> threads;
+         for (size_t t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, seed = round * kThreads + t] {
+               std::mt19937_64 rng(seed);
+               std::uniform_int_distribution<uint64_t> addrs(
+                  0,
+                  image.size() - 1);
+               std::uniform_int_distribution<size_t> sizes(
+                  1,
+                  3 * spec::kSectorSize);
+               DataBuffer buffer;
+
+               start.arrive_and_wait();
+               for (size_t i = 0; i < kReadsPerThread; ++i) {
+                  const auto addr = addrs(rng);
+                  buffer.resize(std::min<size_t>(
+                     sizes(rng),
+                     image.size() - addr));
+                  std::memcpy(
+                     buffer.data(),
+                     image.data() + addr,
+                     buffer.size());
+
+                  if (!PatchRead(patcher, addr, buffer, readAt)
+                   || 0 != std::memcmp(
+                         buffer.data(),
+                         expected.data() + addr,
+                         buffer.size())) {
+                     ++mismatches;
+                  }
+               }
+            });
+         }
+      }
+
+      CHECK(0 == mismatches);
+   }
+}
+
+// ppftk_test -tc="Patcher: benchmark*" --no-skip
+TEST_CASE("Patcher: benchmark reads of unpatched sectors" * doctest::skip())
+{
+   using Clock = std::chrono::steady_clock;
+
+   // A patched sector every 150, across a full CD.
+   static constexpr uint64_t kSectors = 300'000;
+   static constexpr uint64_t kStride = 150;
+   static constexpr size_t kReads = 2048;
+   static constexpr size_t kPasses = 2000;
+   static constexpr uint8_t kData[] = {0x5A};
+
+   PatchDescriptor patches;
+   for (uint64_t sector = 0; sector < kSectors; sector += kStride) {
+      CHECK(patches.AddPatchData(sector * spec::kSectorSize + 100, kData));
+   }
+   Patcher patcher(std::move(patches));
+
+   // Two sector reads that stay clear of the patched ones.
+   std::mt19937 rng(5);
+   std::uniform_int_distribution<uint64_t> stride(0, kSectors / kStride - 1);
+   std::uniform_int_distribution<uint64_t> offset(1, kStride - 2);
+   std::vector<uint64_t> addrs(kReads);
+   for (auto& addr : addrs) {
+      addr = (stride(rng) * kStride + offset(rng)) * spec::kSectorSize;
+   }
+
+   DataBuffer buffer(2 * spec::kSectorSize);
+   size_t extraReads = 0;
+   const auto start = Clock::now();
+   for (size_t pass = 0; pass < kPasses; ++pass) {
+      for (const auto addr : addrs) {
+         extraReads += patcher.Patch(addr, buffer).has_value();
+      }
+   }
+   const std::chrono::duration<double, std::nano> elapsed =
+      Clock::now() - start;
+
+   CHECK(0 == extraReads);
+   MESSAGE((elapsed.count() / (kPasses * kReads)) << " ns per read");
+}
+
 }
\ No newline at end of file
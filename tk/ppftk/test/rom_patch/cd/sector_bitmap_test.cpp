@@ -0,0 +1,70 @@
+#include <ppftk/rom_patch/cd/sector_bitmap.h>
+
+#include <ppftk/rom_patch/cd/sector_patch.h>
+#include <ppftk/rom_patch/cd/spec.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <array>
+
+namespace tdd::tk::rompatch::cd {
+
+namespace {
+   static constexpr std::array<uint64_t, 5> kPatchedSectors{
+      3, 63, 64, 130, 200};
+   static constexpr std::array<uint8_t, 4> kData{1, 2, 3, 4};
+
+   std::vector<SectorPatch> BuildPatches()
+   {
+      std::vector<SectorPatch> patches;
+      for (const auto sector : kPatchedSectors) {
+         patches.emplace_back(PatchItem{
+            .address = sector * spec::kSectorSize + 16,
+            .data = kData});
+      }
+      return patches;
+   }
+}
+
+TEST_CASE("SectorBitmap")
+{
+   SUBCASE("Empty")
+   {
+      const SectorBitmap bitmap(std::span<const SectorPatch>{});
+      CHECK(bitmap.Count() == 0);
+      CHECK_FALSE(bitmap.Any(SectorNumber(0), SectorNumber(1000)));
+   }
+
+   SUBCASE("Patches without data are skipped")
+   {
+      const std::vector<SectorPatch> patches(1);
+      const SectorBitmap bitmap(patches);
+      CHECK(bitmap.Count() == 0);
+      CHECK_FALSE(bitmap.Any(SectorNumber(0), SectorNumber(0)));
+   }
+
+   SUBCASE("Matches the patched sectors for every range")
+   {
+      const auto patches = BuildPatches();
+      const SectorBitmap bitmap(patches);
+      CHECK(bitmap.Count() == kPatchedSectors.size());
+
+      for (uint64_t first = 0; first < 260; ++first) {
+         for (uint64_t last = first; last < 260; ++last) {
+            const auto expected = std::any_of(
+               kPatchedSectors.begin(),
+               kPatchedSectors.end(),
+               [=](const uint64_t s) { return first <= s && s <= last; });
+
+            CAPTURE(first);
+            CAPTURE(last);
+            REQUIRE(
+               bitmap.Any(SectorNumber(first), SectorNumber(last)) ==
+               expected);
+         }
+      }
+   }
+}
+
+}
\ No newline at end of file
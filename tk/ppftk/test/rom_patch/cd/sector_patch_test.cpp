@@ -4,9 +4,11 @@
 
 #include <doctest/doctest.h>
 
+#include <cstring>
+
 namespace tdd::tk::rompatch::cd {
 
-TEST_CASE("SectorPatch: Produce correct EDC after patching")
+TEST_CASE("SectorPatch: Produce correct EDC and ECC after patching")
 {
    static constexpr auto kSizeExcludeEcc = spec::kSectorSize -
       sizeof(spec::Mode2Xa1Data::pParity) - sizeof(spec::Mode2Xa1Data::qParity);
@@ -33,6 +35,7 @@ TEST_CASE("SectorPatch: Produce correct EDC after patching")
             sector.data(),
             TestSector::kVerificationSectorRaw.data(),
             kSizeExcludeEcc));
+      CHECK(sector == TestSector::kVerificationSectorRaw);
    }
 
    SUBCASE("Patch with cached EDC")
@@ -53,6 +56,7 @@ TEST_CASE("SectorPatch: Produce correct EDC after patching")
             sector.data(),
             TestSector::kVerificationSectorRaw.data(),
             kSizeExcludeEcc));
+      CHECK(sector == TestSector::kVerificationSectorRaw);
    }
 
    SUBCASE("Patch unaffected portion")
@@ -120,6 +124,25 @@ TEST_CASE("SectorPatch: Produce correct EDC after patching")
             sizeof(spec::Edc)));
    }
 
+   SUBCASE("Patch only ECC")
+   {
+      auto sector = TestSector::kOriginalSector;
+      std::span<uint8_t> targetBlock(
+         sector.begin() + kSizeExcludeEcc,
+         sector.end());
+
+      SectorView sv(
+         TestSector::kSectorAddr + ByteAddressDiff(kSizeExcludeEcc),
+         targetBlock);
+      patcher.Patch(sv);
+      CHECK(
+         0 ==
+         memcmp(
+            targetBlock.data(),
+            TestSector::kVerificationSector->xa.form1.pParity,
+            spec::kEccSize));
+   }
+
    SUBCASE("Patch individual EDC byte")
    {
       static constexpr auto kOffset = kSizeExcludeEcc - sizeof(spec::Edc);
@@ -16,9 +16,11 @@ inline constexpr ByteAddress kSectorAddr(kTargetAddr.get() - kSectorOffset.get()
 
 static_assert(kTargetAddr > kSectorAddr);
 
+inline static constexpr std::array<uint8_t, 1> kPatchData = {0x00};
+
 inline static PatchItem kPatch{
    .address = kTargetAddr.get(),
-   .data = {0x00}
+   .data = kPatchData
 };
 
 inline static constexpr std::array<uint8_t, spec::kSectorSize> kOriginalSector = {
@@ -0,0 +1,136 @@
+#include <ppftk/rom_patch/cd/verify.h>
+
+#include "test_sector_data.h"
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+
+namespace tdd::tk::rompatch::cd {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   static constexpr size_t kSectors = 20;
+
+   // The test sector is Mode 2 Form 1.
+   static constexpr size_t kEdcIdx =
+      spec::kSectorSize - spec::kEccSize - spec::kEdcSize;
+
+   [[nodiscard]] std::vector<uint8_t> BuildImage(const size_t tail = 0)
+   {
+      std::vector<uint8_t> image;
+      for (size_t i = 0; i < kSectors; ++i) {
+         image.insert(
+            image.end(),
+            TestSector::kOriginalSector.begin(),
+            TestSector::kOriginalSector.end());
+      }
+      image.insert(
+         image.end(),
+         TestSector::kOriginalSector.begin(),
+         TestSector::kOriginalSector.begin() + tail);
+      return image;
+   }
+
+   void Write(const fs::path& file, const std::vector<uint8_t>& data)
+   {
+      std::ofstream os(file, std::ofstream::binary | std::ofstream::trunc);
+      os.write(reinterpret_cast<const char*>(data.data()), data.size());
+   }
+
+   [[nodiscard]] std::vector<uint64_t> Sectors(const VerifyReport& report)
+   {
+      std::vector<uint64_t> sectors;
+      for (const auto& m : report.mismatches) {
+         sectors.push_back(m.sector);
+      }
+      return sectors;
+   }
+}
+
+TEST_CASE("Verify")
+{
+   const auto target = fs::temp_directory_path() / "ppftk_verify_target.bin";
+   const auto verification =
+      fs::temp_directory_path() / "ppftk_verify_expected.bin";
+
+   // Small chunks and more of them than workers.
+   VerifyOptions options{.chunkSectors = 3, .workers = 3};
+
+   SUBCASE("Reports every mismatching sector for the level")
+   {
+      const auto expected = BuildImage();
+      auto patched = expected;
+      patched[3 * spec::kSectorSize + 100] ^= 1;
+      patched[7 * spec::kSectorSize + spec::kSectorSize - 1] ^= 1;
+      patched[12 * spec::kSectorSize + kEdcIdx + 1] ^= 1;
+      patched[19 * spec::kSectorSize + 24] ^= 1;
+      Write(target, patched);
+      Write(verification, expected);
+
+      options.level = VerifyLevel::Data;
+      auto report = Verify(target, verification, options);
+      REQUIRE(report.has_value());
+      CHECK(report->sectors == kSectors);
+      CHECK(Sectors(report.value()) == std::vector<uint64_t>{3, 19});
+      CHECK(report->mismatches[0].layout == SectorLayout::Mode2Form1);
+      CHECK(report->mismatches[0].offset == 100);
+      CHECK(report->mismatches[1].offset == 24);
+
+      options.level = VerifyLevel::Edc;
+      report = Verify(target, verification, options);
+      REQUIRE(report.has_value());
+      CHECK(Sectors(report.value()) == std::vector<uint64_t>{3, 12, 19});
+      CHECK(report->mismatches[1].offset == kEdcIdx + 1);
+
+      options.level = VerifyLevel::Ecc;
+      options.workers = 1;
+      report = Verify(target, verification, options);
+      REQUIRE(report.has_value());
+      CHECK(Sectors(report.value()) == std::vector<uint64_t>{3, 7, 12, 19});
+      CHECK(report->mismatches[1].offset == spec::kSectorSize - 1);
+   }
+
+   SUBCASE("Identical images")
+   {
+      Write(target, BuildImage());
+      Write(verification, BuildImage());
+      options.workers = 0;
+      const auto report = Verify(target, verification, options);
+      REQUIRE(report.has_value());
+      CHECK(report->mismatches.empty());
+   }
+
+   SUBCASE("Only a full comparison takes a partial last sector")
+   {
+      auto patched = BuildImage(100);
+      patched[kSectors * spec::kSectorSize + 50] ^= 1;
+      Write(target, patched);
+      Write(verification, BuildImage(100));
+
+      options.level = VerifyLevel::Data;
+      CHECK_FALSE(Verify(target, verification, options).has_value());
+
+      options.level = VerifyLevel::Ecc;
+      const auto report = Verify(target, verification, options);
+      REQUIRE(report.has_value());
+      CHECK(report->sectors == kSectors + 1);
+      REQUIRE(report->mismatches.size() == 1);
+      CHECK(report->mismatches[0].sector == kSectors);
+      CHECK(report->mismatches[0].layout == SectorLayout::Unknown);
+      CHECK(report->mismatches[0].offset == 50);
+   }
+
+   SUBCASE("Different sizes")
+   {
+      Write(target, BuildImage());
+      Write(verification, BuildImage(1));
+      CHECK_FALSE(Verify(target, verification, options).has_value());
+   }
+
+   fs::remove(target);
+   fs::remove(verification);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <ppftk/rom_patch/extra_reads.h>
+
+#include <doctest/doctest.h>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   static constexpr uint64_t kBlockSize = 16;
+
+   // Byte 'addr' of the fake image.
+   uint8_t ImageByte(const uint64_t addr)
+   {
+      return static_cast<uint8_t>(addr * 7);
+   }
+
+   // Records the blocks it is fed and checks they hold the image content.
+   struct [[nodiscard]] RecordingPatcher : IPatcher
+   {
+      std::optional<AdditionalReads> Patch(
+         const uint64_t addr,
+         std::span<uint8_t> buffer) override
+      {
+         CHECK(kBlockSize == buffer.size());
+         for (size_t i = 0; i < buffer.size(); ++i) {
+            CHECK(ImageByte(addr + i) == buffer[i]);
+         }
+
+         fed.push_back(addr);
+         return std::nullopt;
+      }
+
+      uint64_t PatchedBytes(const uint64_t, const uint64_t) const noexcept
+         override
+      {
+         return 0;
+      }
+
+      std::vector<uint64_t> fed;
+   };
+
+   struct [[nodiscard]] ImageReader
+   {
+      bool operator()(const uint64_t addr, std::span<uint8_t> buffer)
+      {
+         reads.push_back({addr, buffer.size()});
+         if (fail) {
+            return false;
+         }
+
+         for (size_t i = 0; i < buffer.size(); ++i) {
+            buffer[i] = ImageByte(addr + i);
+         }
+         return true;
+      }
+
+      std::vector<std::pair<uint64_t, size_t>> reads;
+      bool fail = false;
+   };
+}
+
+TEST_CASE("FeedAdditionalReads: adjacent blocks are read at once")
+{
+   RecordingPatcher patcher;
+   ImageReader reader;
+   const IPatcher::AdditionalReads extraReads{
+      .addrs = {3 * kBlockSize, 4 * kBlockSize},
+      .blockSize = kBlockSize};
+
+   CHECK(FeedAdditionalReads(patcher, extraReads, std::ref(reader)));
+
+   REQUIRE(1 == reader.reads.size());
+   CHECK(3 * kBlockSize == reader.reads[0].first);
+   CHECK(2 * kBlockSize == reader.reads[0].second);
+   CHECK(extraReads.addrs == patcher.fed);
+}
+
+TEST_CASE("FeedAdditionalReads: separate blocks are read on their own")
+{
+   RecordingPatcher patcher;
+   ImageReader reader;
+   const IPatcher::AdditionalReads extraReads{
+      .addrs = {3 * kBlockSize, 9 * kBlockSize},
+      .blockSize = kBlockSize};
+
+   CHECK(FeedAdditionalReads(patcher, extraReads, std::ref(reader)));
+
+   REQUIRE(2 == reader.reads.size());
+   CHECK(3 * kBlockSize == reader.reads[0].first);
+   CHECK(kBlockSize == reader.reads[0].second);
+   CHECK(9 * kBlockSize == reader.reads[1].first);
+   CHECK(kBlockSize == reader.reads[1].second);
+   CHECK(extraReads.addrs == patcher.fed);
+}
+
+TEST_CASE("FeedAdditionalReads: failed read feeds nothing")
+{
+   RecordingPatcher patcher;
+   ImageReader reader;
+   reader.fail = true;
+   const IPatcher::AdditionalReads extraReads{
+      .addrs = {3 * kBlockSize},
+      .blockSize = kBlockSize};
+
+   CHECK(!FeedAdditionalReads(patcher, extraReads, std::ref(reader)));
+   CHECK(patcher.fed.empty());
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <ppftk/rom_patch/offline_apply.h>
+
+#include "cd/test_sector_data.h"
+
+#include <ppftk/rom_patch/extra_reads.h>
+#include <ppftk/rom_patch/patch_descriptor.h>
+#include <ppftk/rom_patch/patchers.h>
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+#include <iterator>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   static constexpr size_t kSectors = 40;
+   static constexpr size_t kTail = 100;
+   static constexpr std::array<uint8_t, 8> kData{1, 2, 3, 4, 5, 6, 7, 8};
+
+   [[nodiscard]] std::vector<uint8_t> BuildImage()
+   {
+      std::vector<uint8_t> image;
+      for (size_t i = 0; i < kSectors; ++i) {
+         image.insert(
+            image.end(),
+            cd::TestSector::kOriginalSector.begin(),
+            cd::TestSector::kOriginalSector.end());
+      }
+      image.insert(
+         image.end(),
+         cd::TestSector::kOriginalSector.begin(),
+         cd::TestSector::kOriginalSector.begin() + kTail);
+      return image;
+   }
+
+   // Sectors 0, 5, 6, 17 and 39, and one patch across the boundary of
+   // sector 10 and 11.
+   [[nodiscard]] PatchDescriptor BuildPatches()
+   {
+      PatchDescriptor patches;
+      for (const uint64_t sector : {0, 5, 6, 17, 39}) {
+         CHECK(patches.AddPatchData(
+            sector * cd::spec::kSectorSize + 32,
+            kData));
+      }
+      CHECK(patches.AddPatchData(11 * cd::spec::kSectorSize - 4, kData));
+      return patches;
+   }
+
+   // Patches the whole image in one go.
+   template <typename Patcher>
+   [[nodiscard]] std::vector<uint8_t> Expected(std::vector<uint8_t> image)
+   {
+      Patcher patcher(BuildPatches());
+      CHECK(PatchRead(
+         patcher,
+         0,
+         image,
+         [](uint64_t, std::span<uint8_t>) { return false; }));
+      return image;
+   }
+
+   void Write(const fs::path& file, const std::vector<uint8_t>& data)
+   {
+      std::ofstream os(file, std::ofstream::binary | std::ofstream::trunc);
+      os.write(reinterpret_cast<const char*>(data.data()), data.size());
+   }
+
+   [[nodiscard]] std::vector<uint8_t> Read(const fs::path& file)
+   {
+      std::ifstream is(file, std::ifstream::binary);
+      return {
+         std::istreambuf_iterator<char>(is),
+         std::istreambuf_iterator<char>()};
+   }
+}
+
+TEST_CASE("ApplyOffline")
+{
+   const auto source = fs::temp_directory_path() / "ppftk_offline_source.bin";
+   const auto output = fs::temp_directory_path() / "ppftk_offline_output.bin";
+
+   const auto image = BuildImage();
+   Write(source, image);
+
+   // Chunks of 3 sectors, the extra bytes are dropped. Leaves a short last
+   // chunk and more chunks than workers.
+   const OfflineApplyOptions options{
+      .chunkSize = 3 * cd::spec::kSectorSize + 5,
+      .workers = 4};
+
+   SUBCASE("Matches patching the whole image, with checksums")
+   {
+      cd::Patcher patcher(BuildPatches());
+      REQUIRE(ApplyOffline(patcher, source, output, options));
+      CHECK(Read(output) == Expected<cd::Patcher>(image));
+      CHECK(Read(output) != image);
+   }
+
+   SUBCASE("Matches patching the whole image, without checksums")
+   {
+      SimplePatcher patcher(BuildPatches());
+      REQUIRE(ApplyOffline(patcher, source, output, options));
+      CHECK(Read(output) == Expected<SimplePatcher>(image));
+   }
+
+   SUBCASE("Refuses to overwrite the source")
+   {
+      cd::Patcher patcher(BuildPatches());
+      CHECK_FALSE(ApplyOffline(patcher, source, source, options));
+      CHECK_FALSE(ApplyToClone(patcher, {}, source, source));
+      CHECK(Read(source) == image);
+   }
+
+   SUBCASE("Rewriting the patched sectors of a clone matches streaming")
+   {
+      const auto patches = BuildPatches();
+      const auto ranges = AsyncPatcher::CoveredRanges(
+         patches.GetFullPatch(),
+         cd::spec::kSectorSize);
+
+      // Sectors 0, 5 and 6, 10 and 11, 17 and 39.
+      CHECK(ranges.size() == 5);
+
+      cd::Patcher patcher(BuildPatches());
+      REQUIRE(ApplyToClone(patcher, ranges, source, output));
+      CHECK(Read(output) == Expected<cd::Patcher>(image));
+   }
+
+   SUBCASE("Patches past the end of a clone are dropped")
+   {
+      const AsyncPatcher::Range past{
+         .start = (kSectors + 2) * cd::spec::kSectorSize,
+         .end = (kSectors + 3) * cd::spec::kSectorSize};
+
+      SimplePatcher patcher(BuildPatches());
+      REQUIRE(ApplyToClone(patcher, {&past, 1}, source, output));
+      CHECK(Read(output) == image);
+   }
+
+   SUBCASE("Fails on a patch in a sector cut short by the end of the image")
+   {
+      PatchDescriptor patches;
+      CHECK(patches.AddPatchData(kSectors * cd::spec::kSectorSize, kData));
+      cd::Patcher patcher(std::move(patches));
+      CHECK_FALSE(ApplyOffline(patcher, source, output, options));
+   }
+
+   fs::remove(source);
+   fs::remove(output);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <ppftk/rom_patch/patch_descriptor.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+
+namespace tdd::tk::rompatch {
+
+TEST_CASE("PatchDescriptor: compacting contiguous data does not copy")
+{
+   static constexpr uint8_t kData[] = {1, 2, 3, 4, 5};
+
+   PatchDescriptor patch;
+   patch.Reserve(3, sizeof(kData));
+   REQUIRE(patch.AddPatchData(10, DataView(kData, 2)));
+   REQUIRE(patch.AddPatchData(12, DataView(kData + 2, 2)));
+   REQUIRE(patch.AddPatchData(20, DataView(kData + 4, 1)));
+
+   const auto first = patch.GetFullPatch().front().data.data();
+
+   patch.Compact();
+
+   const auto& compacted = patch.GetFullPatch();
+   REQUIRE(2 == compacted.size());
+
+   CHECK(10 == compacted[0].address);
+   CHECK(first == compacted[0].data.data());
+   CHECK(DataBuffer{1, 2, 3, 4}
+      == DataBuffer(compacted[0].data.begin(), compacted[0].data.end()));
+
+   CHECK(20 == compacted[1].address);
+   CHECK(DataBuffer{5}
+      == DataBuffer(compacted[1].data.begin(), compacted[1].data.end()));
+
+   auto arena = std::move(patch).TakeArena();
+   CHECK(1 == arena.BlockCount());
+}
+
+TEST_CASE("PatchArena: a moved-from arena allocates blocks of its own")
+{
+   PatchArena arena;
+   const auto first = arena.Allocate(4);
+   std::fill(first.begin(), first.end(), uint8_t(0xAA));
+
+   PatchArena owner(std::move(arena));
+   CHECK(0 == arena.BlockCount());
+
+   const auto reused = arena.Allocate(4);
+   std::fill(reused.begin(), reused.end(), uint8_t(0x55));
+   CHECK(1 == arena.BlockCount());
+   CHECK(DataBuffer(4, 0xAA) == DataBuffer(first.begin(), first.end()));
+
+   PatchArena assigned;
+   assigned = std::move(owner);
+   CHECK(0 == owner.BlockCount());
+   CHECK(1 == assigned.BlockCount());
+   CHECK(DataBuffer(4, 0xAA) == DataBuffer(first.begin(), first.end()));
+}
+
+TEST_CASE("PatchDescriptor: out of order data is copied when compacted")
+{
+   static constexpr uint8_t kData[] = {1, 2, 3, 4};
+
+   PatchDescriptor patch;
+   REQUIRE(patch.AddPatchData(12, DataView(kData + 2, 2)));
+   REQUIRE(patch.AddPatchData(10, DataView(kData, 2)));
+   CHECK_FALSE(patch.AddPatchData(10, DataView(kData, 2)));
+
+   patch.Compact();
+
+   const auto& compacted = patch.GetFullPatch();
+   REQUIRE(1 == compacted.size());
+   CHECK(10 == compacted[0].address);
+   CHECK(DataBuffer{1, 2, 3, 4}
+      == DataBuffer(compacted[0].data.begin(), compacted[0].data.end()));
+}
+
+TEST_CASE("PatchDescriptor: overlapping data is merged with the newest on top")
+{
+   static constexpr uint8_t kOld[] = {1, 1, 1, 1, 1, 1};
+   static constexpr uint8_t kNew[] = {2, 2, 2, 2};
+
+   PatchDescriptor patch;
+   REQUIRE(patch.AddPatchData(12, kOld));
+   REQUIRE(patch.AddPatchData(30, kOld));
+   REQUIRE(patch.AddPatchData(10, kNew));
+   REQUIRE(patch.AddPatchData(16, kNew));
+
+   const auto& items = patch.GetFullPatch();
+   REQUIRE(2 == items.size());
+   CHECK(10 == items[0].address);
+   CHECK(DataBuffer{2, 2, 2, 2, 1, 1, 2, 2, 2, 2}
+      == DataBuffer(items[0].data.begin(), items[0].data.end()));
+   CHECK(30 == items[1].address);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <ppftk/rom_patch/patch_index.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   static constexpr size_t kImageSize = 64 * 1024;
+
+   // Non-overlapping patches spread over an image of kImageSize bytes.
+   PatchDescriptor BuildPatches(const uint32_t seed)
+   {
+      std::mt19937 rng(seed);
+      std::uniform_int_distribution<size_t> gap(0, 300);
+      std::uniform_int_distribution<size_t> length(1, 255);
+
+      PatchDescriptor patches;
+      uint64_t addr = gap(rng);
+      while (true) {
+         DataBuffer data(length(rng));
+         if (addr + data.size() > kImageSize) {
+            break;
+         }
+
+         std::iota(data.begin(), data.end(), static_cast<uint8_t>(addr));
+         CHECK(patches.AddPatchData(addr, data));
+         addr += data.size() + gap(rng);
+      }
+      return patches;
+   }
+
+   DataBuffer ApplyReference(const PatchDescriptor::FullPatch& patches)
+   {
+      DataBuffer image(kImageSize, 0xEE);
+      for (const auto& p : patches) {
+         std::copy(p.data.begin(), p.data.end(), image.begin() + p.address);
+      }
+      return image;
+   }
+}
+
+TEST_CASE("PatchIndex: empty index")
+{
+   PatchIndex index;
+   CHECK(index.Empty());
+   CHECK(0 == index.Find(0));
+   CHECK(0 == index.Find(12345));
+
+   DataBuffer buffer(16, 0xEE);
+   index.Apply(0, buffer);
+   CHECK(DataBuffer(16, 0xEE) == buffer);
+}
+
+TEST_CASE("PatchIndex: adjacent entries are merged")
+{
+   static constexpr uint8_t kData[] = {1, 2, 3, 4, 5};
+   const PatchDescriptor::FullPatch patches{
+      {.address = 10, .data = DataView(kData, 2)},
+      {.address = 12, .data = DataView(kData + 2, 2)},
+      {.address = 20, .data = DataView(kData + 4, 1)}};
+
+   PatchIndex index(patches);
+   REQUIRE(2 == index.Size());
+
+   CHECK(10 == index.Start());
+   CHECK(21 == index.End());
+
+   CHECK(10 == index.EntryStart(0));
+   CHECK(14 == index.EntryEnd(0));
+   const auto merged = index.EntryData(0);
+   CHECK(DataBuffer{1, 2, 3, 4} == DataBuffer(merged.begin(), merged.end()));
+
+   CHECK(0 == index.Find(0));
+   CHECK(0 == index.Find(13));
+   CHECK(1 == index.Find(14));
+   CHECK(1 == index.Find(20));
+   CHECK(2 == index.Find(21));
+}
+
+TEST_CASE("PatchIndex: finds the first entry ending after an address")
+{
+   const auto patches = BuildPatches(7);
+   PatchIndex index(patches.GetFullPatch());
+
+   std::vector<uint64_t> ends;
+   for (size_t i = 0; i < index.Size(); ++i) {
+      ends.push_back(index.EntryEnd(i));
+   }
+
+   for (uint64_t addr = 0; addr < kImageSize; ++addr) {
+      const auto expected = static_cast<size_t>(std::distance(
+         ends.begin(),
+         std::upper_bound(ends.begin(), ends.end(), addr)));
+      REQUIRE(expected == index.Find(addr));
+   }
+}
+
+TEST_CASE("PatchIndex: applies patches to arbitrary windows")
+{
+   for (const uint32_t seed : {1u, 2u, 3u}) {
+      const auto patches = BuildPatches(seed);
+      const auto expected = ApplyReference(patches.GetFullPatch());
+
+      PatchIndex index(patches.GetFullPatch());
+
+      std::mt19937 rng(seed);
+      std::uniform_int_distribution<size_t> start(0, kImageSize - 1);
+      std::uniform_int_distribution<size_t> length(0, 4096);
+
+      for (auto i = 0; i < 1000; ++i) {
+         const auto addr = start(rng);
+         const auto size = std::min(length(rng), kImageSize - addr);
+
+         DataBuffer window(size, 0xEE);
+         index.Apply(addr, window);
+
+         REQUIRE(std::equal(
+            window.begin(),
+            window.end(),
+            expected.begin() + addr));
+      }
+   }
+}
+
+}
@@ -0,0 +1,140 @@
+#include <ppftk/rom_patch/patch_loader.h>
+
+#include "cd/test_sector_data.h"
+
+#include <ppftk/rom_patch/cd/patch_cache.h>
+#include <ppftk/rom_patch/ppf/ppf3.h>
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+
+   // An image holding the test sector, with a PPF for it next to it.
+   struct [[nodiscard]] TargetFixture
+   {
+      TargetFixture()
+         : dir(fs::temp_directory_path() / "ppftk_patch_loader")
+         , target(dir / "game.bin")
+      {
+         std::error_code ec;
+         fs::remove_all(dir, ec);
+         fs::create_directories(dir);
+
+         {
+            std::ofstream image(target, std::ofstream::binary);
+            image.seekp(cd::TestSector::kSectorAddr.get());
+            image.write(
+               reinterpret_cast<const char*>(
+                  cd::TestSector::kOriginalSector.data()),
+               cd::TestSector::kOriginalSector.size());
+         }
+
+         PatchDescriptor patches;
+         CHECK(patches.AddPatchData(
+            cd::TestSector::kPatch.address,
+            cd::TestSector::kPatch.data));
+         CHECK(!ppf::WritePpf3Patch(dir / "game.ppf", patches));
+      }
+
+      ~TargetFixture()
+      {
+         std::error_code ec;
+         fs::remove_all(dir, ec);
+      }
+
+      // For a PPF that holds the checksums already.
+      void SkipEdc() const
+      {
+         std::ofstream(dir / "game.piconf")
+            << R"({"patch": "game.ppf", "calculate_edc": false})";
+      }
+
+      // The ranges LoadPatcher announced. It must announce them exactly once.
+      [[nodiscard]] AsyncPatcher::Ranges Load() const
+      {
+         std::optional<AsyncPatcher::Ranges> announced;
+         const auto patcher = LoadPatcher(
+            target,
+            [&announced](AsyncPatcher::Ranges&& ranges) {
+               CHECK_FALSE(announced.has_value());
+               announced = std::move(ranges);
+            });
+
+         CHECK(nullptr != patcher);
+         REQUIRE(announced.has_value());
+         return std::move(announced).value();
+      }
+
+      fs::path dir;
+      fs::path target;
+   };
+}
+
+TEST_CASE("LoadPatcher: announces the patched ranges on every path")
+{
+   TargetFixture fixture;
+
+   uint64_t start = cd::TestSector::kSectorAddr.get();
+   uint64_t end = start + cd::spec::kSectorSize;
+
+   SUBCASE("Cold cache")
+   {
+   }
+
+   SUBCASE("Warm cache")
+   {
+      std::ignore = fixture.Load();
+      CHECK(fs::exists(cd::PatchCache::CachePath(fixture.target)));
+   }
+
+   SUBCASE("No EDC")
+   {
+      fixture.SkipEdc();
+      start = cd::TestSector::kTargetAddr.get();
+      end = start + cd::TestSector::kPatchData.size();
+   }
+
+   const auto ranges = fixture.Load();
+   REQUIRE(1 == ranges.size());
+   CHECK(start == ranges.front().start);
+   CHECK(end == ranges.front().end);
+}
+
+TEST_CASE("LoadPatcher: patched bytes of a read on every path")
+{
+   TargetFixture fixture;
+
+   uint64_t expected = cd::spec::kSectorSize;
+
+   SUBCASE("Cold cache")
+   {
+   }
+
+   SUBCASE("Warm cache")
+   {
+      std::ignore = fixture.Load();
+      REQUIRE(fs::exists(cd::PatchCache::CachePath(fixture.target)));
+   }
+
+   SUBCASE("No EDC")
+   {
+      fixture.SkipEdc();
+      expected = cd::TestSector::kPatchData.size();
+   }
+
+   AsyncPatcher patcher([&fixture](const AsyncPatcher::Announce& announce) {
+      return LoadPatcher(fixture.target, announce);
+   });
+   REQUIRE(patcher.Wait());
+
+   const auto addr = cd::TestSector::kSectorAddr.get();
+   CHECK(expected == patcher.PatchedBytes(addr, cd::spec::kSectorSize));
+   CHECK(0 == patcher.PatchedBytes(addr + cd::spec::kSectorSize, 4096));
+}
+
+}
\ No newline at end of file
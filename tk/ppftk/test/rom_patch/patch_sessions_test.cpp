@@ -0,0 +1,179 @@
+#include <ppftk/rom_patch/patch_sessions.h>
+
+#include <doctest/doctest.h>
+
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   struct [[nodiscard]] TestSession
+   {
+      explicit TestSession(std::atomic<int>& alive)
+         : m_alive(alive)
+      {
+         ++m_alive;
+      }
+
+      ~TestSession()
+      {
+         --m_alive;
+      }
+
+      std::atomic<int>& m_alive;
+   };
+
+   using TestSessions = PatchSessions<int, TestSession>;
+}
+
+TEST_CASE("PatchSessions: opening the same image shares the session")
+{
+   std::atomic<int> alive = 0;
+   int created = 0;
+   const auto create = [&] {
+      ++created;
+      return std::make_shared<TestSession>(alive);
+   };
+
+   TestSessions sessions;
+   CHECK(nullptr == sessions.Find(3));
+
+   const auto first = sessions.Open(3, "/games/disc1.bin", create);
+   const auto second = sessions.Open(4, "/games/disc1.bin", create);
+   const auto other = sessions.Open(5, "/games/disc2.bin", create);
+
+   CHECK(2 == created);
+   CHECK(first == second);
+   CHECK(first != other);
+   CHECK(first == sessions.Find(3));
+   CHECK(first == sessions.Find(4));
+   CHECK(other == sessions.Find(5));
+   CHECK(3 == sessions.Size());
+}
+
+TEST_CASE("PatchSessions: sessions live until their last handle closes")
+{
+   std::atomic<int> alive = 0;
+   const auto create = [&] { return std::make_shared<TestSession>(alive); };
+
+   TestSessions sessions;
+   std::ignore = sessions.Open(3, "/games/disc1.bin", create);
+   CHECK(nullptr != sessions.Duplicate(3, 7));
+   CHECK(nullptr == sessions.Duplicate(9, 8));
+   CHECK(nullptr == sessions.Find(8));
+
+   CHECK(sessions.Close(3));
+   CHECK(!sessions.Close(3));
+   CHECK(1 == alive);
+   CHECK(nullptr == sessions.Find(3));
+
+   auto inFlight = sessions.Find(7);
+   CHECK(sessions.Close(7));
+   CHECK(0 == sessions.Size());
+   CHECK(1 == alive);
+
+   inFlight.reset();
+   CHECK(0 == alive);
+}
+
+TEST_CASE("PatchSessions: a reused handle is replaced")
+{
+   std::atomic<int> alive = 0;
+   const auto create = [&] { return std::make_shared<TestSession>(alive); };
+
+   TestSessions sessions;
+   const auto first = sessions.Open(3, "/games/disc1.bin", create);
+   const auto second = sessions.Open(3, "/games/disc2.bin", create);
+   CHECK(first != second);
+   CHECK(second == sessions.Find(3));
+   CHECK(1 == sessions.Size());
+
+   // Reopening the only handle of an image doesn't share with itself.
+   const auto third = sessions.Open(3, "/games/disc2.bin", create);
+   CHECK(third != second);
+}
+
+TEST_CASE("PatchSessions: a failed create registers nothing")
+{
+   TestSessions sessions;
+   CHECK(nullptr == sessions.Open(3, "/games/disc1.bin", [] {
+      return TestSessions::SessionPtr();
+   }));
+   CHECK(0 == sessions.Size());
+}
+
+TEST_CASE("PatchSessions: lookups don't carry over to a new instance")
+{
+   std::atomic<int> alive = 0;
+   const auto create = [&] { return std::make_shared<TestSession>(alive); };
+
+   // Likely at the same address, with this thread's snapshot of the first
+   // one still cached.
+   std::optional<TestSessions> sessions;
+   sessions.emplace();
+   std::ignore = sessions->Open(3, "/games/disc1.bin", create);
+   CHECK(nullptr != sessions->Find(3));
+
+   sessions.emplace();
+   CHECK(0 == alive);
+   std::ignore = sessions->Open(4, "/games/disc1.bin", create);
+   CHECK(nullptr == sessions->Find(3));
+   CHECK(nullptr != sessions->Find(4));
+}
+
+TEST_CASE("PatchSessions: lookups race opens and closes")
+{
+   static constexpr int kHandles = 16;
+   static constexpr int kRounds = 2000;
+
+   std::atomic<int> alive = 0;
+   const auto create = [&] { return std::make_shared<TestSession>(alive); };
+
+   TestSessions sessions;
+   // Handle 0 stays open throughout.
+   const auto stable = sessions.Open(0, "/games/stable.bin", create);
+
+   std::atomic<bool> done = false;
+   std::vector<std::jthread> readers;
+   for (int r = 0; r < 3; ++r) {
+      readers.emplace_back([&] {
+         while (!done) {
+            for (int handle = 0; handle < kHandles; ++handle) {
+               const auto session = sessions.Find(handle);
+               if (0 == handle) {
+                  CHECK(stable == session);
+               }
+               else if (nullptr != session) {
+                  CHECK(alive > 0);
+               }
+            }
+         }
+      });
+   }
+
+   for (int round = 0; round < kRounds; ++round) {
+      const int handle = 1 + round % (kHandles - 1);
+      const auto image = "/games/disc" + std::to_string(round % 3) + ".bin";
+      std::ignore = sessions.Open(handle, image, create);
+      if (0 == round % 2) {
+         const int copy = 1 + handle % (kHandles - 1);
+         std::ignore = sessions.Duplicate(handle, copy);
+      }
+      std::ignore = sessions.Close(1 + (round * 7) % (kHandles - 1));
+   }
+
+   done = true;
+   readers.clear();
+
+   for (int handle = 1; handle < kHandles; ++handle) {
+      std::ignore = sessions.Close(handle);
+   }
+
+   CHECK(1 == sessions.Size());
+   CHECK(1 == alive);
+}
+
+}
\ No newline at end of file
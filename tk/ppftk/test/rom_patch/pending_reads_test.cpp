@@ -0,0 +1,324 @@
+#include <ppftk/rom_patch/pending_reads.h>
+
+#include "cd/test_sector_data.h"
+
+#include <ppftk/rom_patch/extra_reads.h>
+#include <ppftk/rom_patch/patchers.h>
+
+#include <doctest/doctest.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   // Completes reads of 'image' on a worker thread and reports them the way
+   // an IO completion port would: with the key the read was issued with and
+   // the number of bytes transferred.
+   class [[nodiscard]] FakeAsyncFile
+   {
+   public:
+      using Completion =
+         std::function<void(const void* key, size_t bytesTransferred)>;
+
+      FakeAsyncFile(DataView image, Completion complete)
+         : m_image(image)
+         , m_complete(std::move(complete))
+         , m_lock()
+         , m_ready()
+         , m_queue()
+         , m_worker([this](std::stop_token stop) { Run(stop); })
+      {}
+
+      ~FakeAsyncFile()
+      {
+         m_worker.request_stop();
+         m_ready.notify_all();
+      }
+
+      void ReadAsync(
+         const void* key,
+         const uint64_t addr,
+         std::span<uint8_t> buffer)
+      {
+         {
+            std::lock_guard lock(m_lock);
+            m_queue.push_back({key, addr, buffer});
+         }
+         m_ready.notify_all();
+      }
+
+      [[nodiscard]] bool ReadAt(
+         const uint64_t addr,
+         std::span<uint8_t> buffer) const
+      {
+         if (addr + buffer.size() > m_image.size()) {
+            return false;
+         }
+
+         std::memcpy(buffer.data(), m_image.data() + addr, buffer.size());
+         return true;
+      }
+
+   private:
+      struct Request
+      {
+         const void* key;
+         uint64_t addr;
+         std::span<uint8_t> buffer;
+      };
+
+      void Run(std::stop_token stop)
+      {
+         while (true) {
+            Request request;
+            {
+               std::unique_lock lock(m_lock);
+               m_ready.wait(lock, [&] {
+                  return stop.stop_requested() || !m_queue.empty();
+               });
+
+               if (m_queue.empty()) {
+                  return;
+               }
+
+               request = m_queue.front();
+               m_queue.pop_front();
+            }
+
+            const auto size = std::min<uint64_t>(
+               request.buffer.size(),
+               m_image.size() - request.addr);
+            std::memcpy(
+               request.buffer.data(),
+               m_image.data() + request.addr,
+               size);
+            m_complete(request.key, size);
+         }
+      }
+
+      DataView m_image;
+      Completion m_complete;
+      std::mutex m_lock;
+      std::condition_variable m_ready;
+      std::deque<Request> m_queue;
+      std::jthread m_worker;
+   };
+
+   struct [[nodiscard]] NoContext
+   {};
+
+   // Completion side of the hooks: take the read back out and patch it.
+   struct [[nodiscard]] CompletionPatcher
+   {
+      void operator()(const void* key, const size_t bytesTransferred)
+      {
+         auto read = pending.Take(key);
+         REQUIRE(read.has_value());
+
+         const auto patched = PatchRead(
+            *patcher,
+            read->addr,
+            read->buffer.first(bytesTransferred),
+            [this](const uint64_t addr, std::span<uint8_t> buffer) {
+               return file->ReadAt(addr, buffer);
+            });
+         CHECK(patched);
+
+         std::lock_guard lock(doneLock);
+         ++completed;
+         done.notify_all();
+      }
+
+      void WaitFor(const size_t count)
+      {
+         std::unique_lock lock(doneLock);
+         done.wait(lock, [&] { return completed == count; });
+      }
+
+      IPatcher* patcher = nullptr;
+      FakeAsyncFile* file = nullptr;
+      PendingReads<NoContext> pending;
+      std::mutex doneLock;
+      std::condition_variable done;
+      size_t completed = 0;
+   };
+}
+
+TEST_CASE("PendingReads: a read is taken once")
+{
+   PendingReads<int> pending;
+   uint8_t buffer[4] = {};
+   const int key = 0;
+
+   CHECK(!pending.Take(&key).has_value());
+
+   pending.Add(&key, {.addr = 10, .buffer = buffer, .context = 1});
+   pending.Add(&key, {.addr = 20, .buffer = buffer, .context = 2});
+   CHECK(1 == pending.Size());
+
+   const auto read = pending.Take(&key);
+   REQUIRE(read.has_value());
+   CHECK(20 == read->addr);
+   CHECK(2 == read->context);
+
+   CHECK(!pending.Take(&key).has_value());
+   CHECK(0 == pending.Size());
+}
+
+TEST_CASE("PendingReads: a reused key completes only its new read")
+{
+   PendingReads<int> pending;
+   uint8_t buffer[4] = {};
+   const int overlapped = 0;
+   static constexpr int kTarget = 1;
+   static constexpr int kOther = 2;
+
+   // Completed through a wait on its event, which the hooks don't see.
+   pending.Add(&overlapped, {.addr = 10, .buffer = buffer, .context = kTarget});
+
+   SUBCASE("Reused for a file that isn't patched")
+   {
+      // The hooks drop the stale read when they pass the new one through.
+      std::ignore = pending.Take(&overlapped);
+      CHECK(!pending.Take(&overlapped).has_value());
+   }
+
+   SUBCASE("Reused for another patched file")
+   {
+      pending.Add(
+         &overlapped,
+         {.addr = 20, .buffer = buffer, .context = kOther});
+
+      const auto read = pending.Take(&overlapped);
+      REQUIRE(read.has_value());
+      CHECK(20 == read->addr);
+      CHECK(kOther == read->context);
+   }
+
+   CHECK(0 == pending.Size());
+}
+
+TEST_CASE("PendingReads: the reads of a closed file are dropped")
+{
+   PendingReads<int> pending;
+   uint8_t buffer[4] = {};
+   const int overlapped[3] = {};
+   static constexpr int kClosed = 1;
+   static constexpr int kOpen = 2;
+
+   CHECK(0 == pending.EraseIf([](const auto&) { return true; }));
+
+   for (const auto& key : overlapped) {
+      const auto file = &key == &overlapped[1] ? kOpen : kClosed;
+      pending.Add(&key, {.addr = 0, .buffer = buffer, .context = file});
+   }
+
+   CHECK(2 == pending.EraseIf([](const auto& read) {
+      return kClosed == read.context;
+   }));
+   CHECK(1 == pending.Size());
+
+   CHECK(!pending.Take(&overlapped[0]).has_value());
+   CHECK(!pending.Take(&overlapped[2]).has_value());
+   CHECK(pending.Take(&overlapped[1]).has_value());
+   CHECK(0 == pending.Size());
+}
+
+TEST_CASE("PendingReads: reads are patched on completion")
+{
+   static constexpr size_t kImageSize = 64 * 1024;
+   static constexpr size_t kReads = 500;
+
+   std::mt19937 rng(11);
+   DataBuffer image(kImageSize);
+   std::generate(image.begin(), image.end(), [&] {
+      return static_cast<uint8_t>(rng());
+   });
+
+   PatchDescriptor patches;
+   for (uint64_t addr = 37; addr + 8 < kImageSize; addr += 997) {
+      CHECK(patches.AddPatchData(addr, DataBuffer(8, 0xA5)));
+   }
+
+   auto expected = image;
+   for (const auto& p : patches.GetFullPatch()) {
+      std::copy(p.data.begin(), p.data.end(), expected.begin() + p.address);
+   }
+
+   SimplePatcher patcher(std::move(patches));
+   CompletionPatcher complete;
+   FakeAsyncFile file(image, std::ref(complete));
+   complete.patcher = &patcher;
+   complete.file = &file;
+
+   std::uniform_int_distribution<size_t> start(0, kImageSize - 1);
+   std::uniform_int_distribution<size_t> length(1, 4096);
+
+   // Reads can complete before ReadAsync() returns. They are registered
+   // before they are issued, like the hooks do.
+   std::vector<uint64_t> addrs(kReads);
+   std::vector<DataBuffer> buffers(kReads);
+   for (size_t i = 0; i < kReads; ++i) {
+      addrs[i] = start(rng);
+      buffers[i].resize(std::min(length(rng), kImageSize - addrs[i]));
+      complete.pending.Add(
+         &buffers[i],
+         {.addr = addrs[i], .buffer = buffers[i], .context = {}});
+      file.ReadAsync(&buffers[i], addrs[i], buffers[i]);
+   }
+
+   complete.WaitFor(kReads);
+   CHECK(0 == complete.pending.Size());
+
+   for (size_t i = 0; i < kReads; ++i) {
+      REQUIRE(std::equal(
+         buffers[i].begin(),
+         buffers[i].end(),
+         expected.begin() + addrs[i]));
+   }
+}
+
+TEST_CASE("PendingReads: partial CD sectors are completed with extra reads")
+{
+   static constexpr size_t kOffset = 16;
+   const auto sectorAddr = cd::TestSector::kSectorAddr.get();
+
+   DataBuffer image(sectorAddr + cd::spec::kSectorSize, 0);
+   std::copy(
+      cd::TestSector::kOriginalSector.begin(),
+      cd::TestSector::kOriginalSector.end(),
+      image.begin() + sectorAddr);
+
+   PatchDescriptor patches;
+   CHECK(patches.AddPatchData(
+      cd::TestSector::kPatch.address,
+      cd::TestSector::kPatch.data));
+
+   cd::Patcher patcher(std::move(patches));
+   CompletionPatcher complete;
+   FakeAsyncFile file(image, std::ref(complete));
+   complete.patcher = &patcher;
+   complete.file = &file;
+
+   DataBuffer buffer(cd::spec::kSectorSize - 2 * kOffset);
+   complete.pending.Add(
+      &buffer,
+      {.addr = sectorAddr + kOffset, .buffer = buffer, .context = {}});
+   file.ReadAsync(&buffer, sectorAddr + kOffset, buffer);
+   complete.WaitFor(1);
+
+   CHECK(
+      0 ==
+      std::memcmp(
+         &cd::TestSector::kVerificationSectorRaw[kOffset],
+         buffer.data(),
+         buffer.size()));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <ppftk/rom_patch/ppf/parser.h>
+
+#include <doctest/doctest.h>
+
+#include <string_view>
+
+namespace tdd::tk::rompatch::ppf {
+
+namespace {
+   static constexpr size_t kHeaderSize = 60;
+
+   void Append(DataBuffer& ppf, std::string_view data)
+   {
+      ppf.insert(ppf.end(), data.begin(), data.end());
+   }
+
+   template <typename T>
+   void AppendValue(DataBuffer& ppf, const T value)
+   {
+      const auto bytes = reinterpret_cast<const uint8_t*>(&value);
+      ppf.insert(ppf.end(), bytes, bytes + sizeof(value));
+   }
+
+   DataBuffer MakeHeader(const bool hasUndo)
+   {
+      DataBuffer ppf;
+      Append(ppf, "PPF30");
+      ppf.push_back(2);
+      Append(ppf, "test patch");
+      ppf.resize(kHeaderSize);
+      ppf[kHeaderSize - 2] = hasUndo ? 1 : 0;
+      return ppf;
+   }
+
+   void AppendEntry(
+      DataBuffer& ppf,
+      const uint64_t address,
+      const DataBuffer& data,
+      const bool hasUndo)
+   {
+      AppendValue(ppf, address);
+      AppendValue(ppf, static_cast<uint8_t>(data.size()));
+      ppf.insert(ppf.end(), data.begin(), data.end());
+      if (hasUndo) {
+         ppf.insert(ppf.end(), data.size(), 0xEE);
+      }
+   }
+
+   void AppendFileId(DataBuffer& ppf, std::string_view id)
+   {
+      Append(ppf, "@BEGIN_FILE_ID.DIZ");
+      Append(ppf, id);
+      Append(ppf, "@END_FILE_ID.DIZ");
+      AppendValue(ppf, static_cast<int16_t>(id.size()));
+   }
+}
+
+TEST_CASE("ppf::Parse: PPF3 from memory")
+{
+   for (const bool hasUndo : {false, true}) {
+      auto ppf = MakeHeader(hasUndo);
+      AppendEntry(ppf, 0x2000, {7, 8}, hasUndo);
+      AppendEntry(ppf, 0x1000, {1, 2, 3}, hasUndo);
+      AppendEntry(ppf, 0x1003, {4}, hasUndo);
+      AppendFileId(ppf, "file id");
+
+      const auto patch = Parse(ppf);
+      REQUIRE(patch.has_value());
+
+      CHECK("test patch" == patch->GetDescription());
+      CHECK("file id" == patch->GetFileId());
+      CHECK(patch->GetValidationData().data.empty());
+
+      const auto& entries = patch->GetFullPatch();
+      REQUIRE(2 == entries.size());
+
+      CHECK(0x1000 == entries[0].address);
+      CHECK(DataBuffer{1, 2, 3, 4}
+         == DataBuffer(entries[0].data.begin(), entries[0].data.end()));
+
+      CHECK(0x2000 == entries[1].address);
+      CHECK(DataBuffer{7, 8}
+         == DataBuffer(entries[1].data.begin(), entries[1].data.end()));
+   }
+}
+
+TEST_CASE("ppf::Parse: rejects malformed PPF3")
+{
+   SUBCASE("Truncated entry")
+   {
+      auto ppf = MakeHeader(false);
+      AppendEntry(ppf, 0x1000, {1, 2, 3}, false);
+      ppf.pop_back();
+
+      CHECK_FALSE(Parse(ppf).has_value());
+   }
+
+   SUBCASE("Truncated header")
+   {
+      auto ppf = MakeHeader(false);
+      ppf.resize(kHeaderSize - 1);
+
+      CHECK_FALSE(Parse(ppf).has_value());
+   }
+
+   SUBCASE("Duplicate address")
+   {
+      auto ppf = MakeHeader(false);
+      AppendEntry(ppf, 0x1000, {1}, false);
+      AppendEntry(ppf, 0x1000, {2}, false);
+
+      CHECK_FALSE(Parse(ppf).has_value());
+   }
+
+   SUBCASE("Not a PPF")
+   {
+      DataBuffer ppf(kHeaderSize, 0);
+      CHECK_FALSE(Parse(ppf).has_value());
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <ppftk/rom_patch/read_trace.h>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace tdd::tk::rompatch {
+
+namespace {
+   namespace fs = std::filesystem;
+   using namespace std::chrono_literals;
+
+   struct [[nodiscard]] TraceFile
+   {
+      TraceFile()
+         : path(fs::temp_directory_path() / "ppftk_read_trace.trace")
+      {}
+
+      ~TraceFile()
+      {
+         std::error_code ec;
+         fs::remove(path, ec);
+      }
+
+      fs::path path;
+   };
+
+   [[nodiscard]] ReadTrace::Read MakeRead(const uint64_t offset)
+   {
+      const auto start = ReadTrace::Clock::now();
+      return {
+         .offset = offset,
+         .length = 2352,
+         .patchedBytes = 16,
+         .extraReads = 1,
+         .start = start,
+         .read = start + 5us,
+         .patched = start + 7us};
+   }
+}
+
+TEST_CASE("ReadTrace: records round trip")
+{
+   TraceFile file;
+   {
+      const auto trace = ReadTrace::Create(file.path, 16);
+      REQUIRE(nullptr != trace);
+      trace->Add(MakeRead(0));
+      trace->Add(MakeRead(2352));
+   }
+
+   const auto contents = ReadTrace::Load(file.path);
+   REQUIRE(contents.has_value());
+   CHECK(16 == contents->header.capacity);
+   CHECK(2 == contents->header.next);
+   REQUIRE(2 == contents->records.size());
+
+   const auto& first = contents->records[0];
+   CHECK(1 == first.sequence);
+   CHECK(0 == first.offset);
+   CHECK(2352 == first.length);
+   CHECK(16 == first.patchedBytes);
+   CHECK(1 == first.extraReads);
+   CHECK(5'000 == first.readTime);
+   CHECK(2'000 == first.patchTime);
+   CHECK(0 != first.threadId);
+
+   const auto& second = contents->records[1];
+   CHECK(2 == second.sequence);
+   CHECK(2352 == second.offset);
+   CHECK(first.time <= second.time);
+}
+
+TEST_CASE("ReadTrace: the ring keeps the most recent reads")
+{
+   TraceFile file;
+   {
+      const auto trace = ReadTrace::Create(file.path, 3);
+      REQUIRE(nullptr != trace);
+      CHECK(4 == trace->Capacity());
+      for (uint64_t i = 0; i < 10; ++i) {
+         trace->Add(MakeRead(i));
+      }
+   }
+
+   const auto contents = ReadTrace::Load(file.path);
+   REQUIRE(contents.has_value());
+   CHECK(10 == contents->header.next);
+   REQUIRE(4 == contents->records.size());
+   for (uint64_t i = 0; i < 4; ++i) {
+      CHECK(7 + i == contents->records[i].sequence);
+      CHECK(6 + i == contents->records[i].offset);
+   }
+}
+
+TEST_CASE("ReadTrace: concurrent writers")
+{
+   static constexpr size_t kThreads = 4;
+   static constexpr uint64_t kReads = 1000;
+
+   TraceFile file;
+   {
+      const auto trace = ReadTrace::Create(file.path, kThreads * kReads);
+      REQUIRE(nullptr != trace);
+
+      std::vector<std::jthread> writers;
+      for (size_t t = 0; t < kThreads; ++t) {
+         writers.emplace_back([&trace, t] {
+            for (uint64_t i = 0; i < kReads; ++i) {
+               trace->Add(MakeRead(t * kReads + i));
+            }
+         });
+      }
+   }
+
+   const auto contents = ReadTrace::Load(file.path);
+   REQUIRE(contents.has_value());
+   REQUIRE(kThreads * kReads == contents->records.size());
+
+   std::vector<bool> seen(kThreads * kReads);
+   for (const auto& record : contents->records) {
+      REQUIRE(record.offset < seen.size());
+      CHECK_FALSE(seen[record.offset]);
+      seen[record.offset] = true;
+   }
+}
+
+TEST_CASE("ReadTrace: loading while reads are added")
+{
+   static constexpr size_t kLoads = 200;
+
+   TraceFile file;
+   const auto trace = ReadTrace::Create(file.path, 4);
+   REQUIRE(nullptr != trace);
+
+   // Each read is its own offset and length. A record torn between two
+   // reads would hold the fields of both.
+   std::jthread writer([&trace](const std::stop_token stop) {
+      for (uint32_t i = 0; !stop.stop_requested(); ++i) {
+         auto read = MakeRead(i);
+         read.length = i;
+         trace->Add(read);
+      }
+   });
+
+   size_t torn = 0;
+   for (size_t load = 0; load < kLoads; ++load) {
+      const auto contents = ReadTrace::Load(file.path);
+      REQUIRE(contents.has_value());
+      for (const auto& record : contents->records) {
+         torn += record.offset != record.length;
+      }
+   }
+
+   CHECK(0 == torn);
+}
+
+TEST_CASE("ReadTrace: other files are rejected")
+{
+   TraceFile file;
+   std::ofstream(file.path, std::ofstream::binary) << "not a trace";
+   CHECK_FALSE(ReadTrace::Load(file.path).has_value());
+}
+
+TEST_CASE("ReadTrace: benchmark" * doctest::skip())
+{
+   static constexpr uint64_t kReads = 10'000'000;
+
+   TraceFile file;
+   const auto trace = ReadTrace::Create(file.path, 1 << 16);
+   REQUIRE(nullptr != trace);
+
+   const auto read = MakeRead(0);
+   const auto start = std::chrono::steady_clock::now();
+   for (uint64_t i = 0; i < kReads; ++i) {
+      trace->Add(read);
+   }
+
+   const auto elapsed = std::chrono::steady_clock::now() - start;
+   const auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+   const auto perRead = static_cast<double>(ns) / kReads;
+   MESSAGE(perRead << " ns per read");
+}
+
+}
\ No newline at end of file